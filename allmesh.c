@@ -0,0 +1,527 @@
+// SPDX-License-Identifier: GPL-2.0
+/* Copyright (C) B.A.T.M.A.N. contributors:
+ *
+ * License-Filename: LICENSES/preferred/GPL-2.0
+ */
+
+#include <errno.h>
+#include <net/if.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "allmesh.h"
+#include "binenc.h"
+#include "debug.h"
+#include "functions.h"
+#include "main.h"
+#include "netlink.h"
+#include "output.h"
+
+enum allmesh_output {
+	ALLMESH_OUTPUT_LINES,
+	ALLMESH_OUTPUT_JSON,
+	ALLMESH_OUTPUT_CBOR,
+	ALLMESH_OUTPUT_MSGPACK,
+};
+
+struct allmesh_worker {
+	char mesh_iface[IF_NAMESIZE];
+	pid_t pid;
+	int fd;
+	/* unfinished line or the complete output of a query */
+	struct outbuf buf;
+};
+
+struct allmesh {
+	struct allmesh_worker *workers;
+	size_t num_workers;
+	size_t max_workers;
+	int error;
+};
+
+static void allmesh_add_iface(const char *ifname, void *arg)
+{
+	struct allmesh *allmesh = arg;
+	struct allmesh_worker *workers;
+	struct allmesh_worker *worker;
+	size_t max_workers;
+
+	if (allmesh->error)
+		return;
+
+	if (allmesh->num_workers == allmesh->max_workers) {
+		max_workers = allmesh->max_workers ? allmesh->max_workers * 2 : 8;
+		workers = realloc(allmesh->workers,
+				  max_workers * sizeof(*workers));
+		if (!workers) {
+			allmesh->error = -ENOMEM;
+			return;
+		}
+
+		allmesh->workers = workers;
+		allmesh->max_workers = max_workers;
+	}
+
+	worker = &allmesh->workers[allmesh->num_workers];
+	memset(worker, 0, sizeof(*worker));
+	snprintf(worker->mesh_iface, sizeof(worker->mesh_iface), "%s", ifname);
+	worker->pid = -1;
+	worker->fd = -1;
+
+	if (outbuf_init(&worker->buf, NULL) < 0) {
+		allmesh->error = -ENOMEM;
+		return;
+	}
+
+	allmesh->num_workers++;
+}
+
+static enum allmesh_output allmesh_output(const struct command *cmd,
+					  int argc, char **argv)
+{
+	enum allmesh_output output = ALLMESH_OUTPUT_JSON;
+	const char *format;
+	int i;
+
+	if (cmd->type != JSON_MIF)
+		return ALLMESH_OUTPUT_LINES;
+
+	/* the query itself validates the format, only the encoding of the
+	 * merged document has to be known here
+	 */
+	for (i = 1; i < argc; i++) {
+		if (strncmp(argv[i], "-f", 2) != 0)
+			continue;
+
+		if (argv[i][2] != '\0')
+			format = &argv[i][2];
+		else if (i + 1 < argc)
+			format = argv[++i];
+		else
+			break;
+
+		if (strcmp(format, "cbor") == 0)
+			output = ALLMESH_OUTPUT_CBOR;
+		else if (strcmp(format, "msgpack") == 0)
+			output = ALLMESH_OUTPUT_MSGPACK;
+		else
+			output = ALLMESH_OUTPUT_JSON;
+	}
+
+	return output;
+}
+
+static void allmesh_worker_run(struct state *state,
+			       struct allmesh_worker *worker,
+			       int argc, char **argv)
+{
+	const struct command *cmd = state->cmd;
+	int ret;
+
+	snprintf(state->mesh_iface, sizeof(state->mesh_iface), "%s",
+		 worker->mesh_iface);
+	state->selector = SP_MESHIF;
+
+	if (check_mesh_iface(state) < 0) {
+		fprintf(stderr,
+			"Error - interface %s is not present or not a batman-adv interface\n",
+			state->mesh_iface);
+		exit(EXIT_FAILURE);
+	}
+
+	if (cmd->flags & COMMAND_FLAG_NETLINK) {
+		ret = netlink_create(state);
+		if (ret < 0) {
+			fprintf(stderr,
+				"Error - failed to connect to batadv\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	ret = cmd->handler(state, argc, argv);
+
+	if (cmd->flags & COMMAND_FLAG_NETLINK)
+		netlink_destroy(state);
+
+	exit(ret);
+}
+
+static int allmesh_start(struct allmesh *allmesh, struct state *state,
+			 int argc, char **argv)
+{
+	struct allmesh_worker *worker;
+	int pipefd[2];
+	size_t i, j;
+
+	/* don't duplicate pending output in the workers */
+	fflush(stdout);
+	fflush(stderr);
+
+	for (i = 0; i < allmesh->num_workers; i++) {
+		worker = &allmesh->workers[i];
+
+		if (pipe(pipefd) < 0)
+			return -errno;
+
+		worker->pid = fork();
+		if (worker->pid < 0) {
+			close(pipefd[0]);
+			close(pipefd[1]);
+			return -errno;
+		}
+
+		if (worker->pid == 0) {
+			for (j = 0; j < i; j++)
+				close(allmesh->workers[j].fd);
+
+			close(pipefd[0]);
+			if (dup2(pipefd[1], STDOUT_FILENO) < 0)
+				exit(EXIT_FAILURE);
+
+			close(pipefd[1]);
+			allmesh_worker_run(state, worker, argc, argv);
+		}
+
+		close(pipefd[1]);
+		worker->fd = pipefd[0];
+	}
+
+	return 0;
+}
+
+/* print all complete lines of the worker with the mesh interface in front */
+static void allmesh_print_lines(struct outbuf *out,
+				struct allmesh_worker *worker,
+				int width, bool eof)
+{
+	struct outbuf *buf = &worker->buf;
+	size_t start = 0;
+	char *newline;
+	size_t len;
+
+	while (start < buf->len) {
+		newline = memchr(&buf->data[start], '\n', buf->len - start);
+		if (!newline && !eof)
+			break;
+
+		if (newline)
+			len = newline - &buf->data[start];
+		else
+			len = buf->len - start;
+
+		outbuf_str(out, worker->mesh_iface, 0);
+		outbuf_str(out, "", width - strlen(worker->mesh_iface) + 1);
+		outbuf_write(out, &buf->data[start], len);
+		outbuf_putc(out, '\n');
+
+		start += len + !!newline;
+	}
+
+	memmove(buf->data, &buf->data[start], buf->len - start);
+	buf->len -= start;
+}
+
+static int allmesh_collect(struct allmesh *allmesh, struct outbuf *out,
+			   enum allmesh_output output, int width)
+{
+	struct allmesh_worker *worker;
+	struct pollfd *pollfds;
+	size_t num_open;
+	char chunk[4096];
+	ssize_t len;
+	size_t i;
+	int ret;
+
+	pollfds = calloc(allmesh->num_workers, sizeof(*pollfds));
+	if (!pollfds)
+		return -ENOMEM;
+
+	num_open = allmesh->num_workers;
+	while (num_open > 0) {
+		for (i = 0; i < allmesh->num_workers; i++) {
+			pollfds[i].fd = allmesh->workers[i].fd;
+			pollfds[i].events = POLLIN;
+			pollfds[i].revents = 0;
+		}
+
+		ret = poll(pollfds, allmesh->num_workers, -1);
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+
+			free(pollfds);
+			return -errno;
+		}
+
+		for (i = 0; i < allmesh->num_workers; i++) {
+			worker = &allmesh->workers[i];
+
+			if (!pollfds[i].revents)
+				continue;
+
+			len = read(worker->fd, chunk, sizeof(chunk));
+			if (len < 0 && errno == EINTR)
+				continue;
+
+			if (len > 0) {
+				outbuf_write(&worker->buf, chunk, len);
+				if (output == ALLMESH_OUTPUT_LINES)
+					allmesh_print_lines(out, worker,
+							    width, false);
+				continue;
+			}
+
+			close(worker->fd);
+			worker->fd = -1;
+			num_open--;
+
+			if (output == ALLMESH_OUTPUT_LINES)
+				allmesh_print_lines(out, worker, width, true);
+		}
+
+		/* watch mode never ends, don't hold back the lines */
+		outbuf_flush(out);
+	}
+
+	free(pollfds);
+
+	return 0;
+}
+
+static void allmesh_print_json_str(struct outbuf *out, const char *str)
+{
+	outbuf_putc(out, '"');
+	for (; *str; str++) {
+		if (*str == '"' || *str == '\\')
+			outbuf_putc(out, '\\');
+
+		outbuf_putc(out, *str);
+	}
+	outbuf_putc(out, '"');
+}
+
+/* the queries of the mesh interfaces are merged in one object/map which
+ * uses the mesh interface as key. failed queries are null
+ */
+static void allmesh_print_merged(struct allmesh *allmesh, struct outbuf *out,
+				 enum allmesh_output output)
+{
+	struct allmesh_worker *worker;
+	struct binenc enc = {
+		.out = out,
+	};
+	size_t len;
+	size_t i;
+
+	switch (output) {
+	case ALLMESH_OUTPUT_LINES:
+		return;
+	case ALLMESH_OUTPUT_JSON:
+		outbuf_putc(out, '{');
+		break;
+	case ALLMESH_OUTPUT_CBOR:
+		enc.format = BINENC_CBOR;
+		binenc_map(&enc, allmesh->num_workers);
+		break;
+	case ALLMESH_OUTPUT_MSGPACK:
+		enc.format = BINENC_MSGPACK;
+		binenc_map(&enc, allmesh->num_workers);
+		break;
+	}
+
+	for (i = 0; i < allmesh->num_workers; i++) {
+		worker = &allmesh->workers[i];
+		len = worker->buf.len;
+
+		if (output != ALLMESH_OUTPUT_JSON) {
+			binenc_str(&enc, worker->mesh_iface,
+				   strlen(worker->mesh_iface));
+
+			if (len > 0)
+				outbuf_write(out, worker->buf.data, len);
+			else if (output == ALLMESH_OUTPUT_CBOR)
+				outbuf_putc(out, (char)0xf6);
+			else
+				outbuf_putc(out, (char)0xc0);
+			continue;
+		}
+
+		while (len > 0 && worker->buf.data[len - 1] == '\n')
+			len--;
+
+		if (i > 0)
+			outbuf_putc(out, ',');
+
+		allmesh_print_json_str(out, worker->mesh_iface);
+		outbuf_putc(out, ':');
+
+		if (len > 0)
+			outbuf_write(out, worker->buf.data, len);
+		else
+			outbuf_str(out, "null", 0);
+	}
+
+	if (output == ALLMESH_OUTPUT_JSON)
+		outbuf_str(out, "}\n", 0);
+}
+
+static bool allmesh_help_requested(int argc, char **argv)
+{
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-h") == 0)
+			return true;
+	}
+
+	return false;
+}
+
+/* the workers share the terminal through the line prefixes, so debug tables
+ * can't clear the screen or move the cursor. Only the change log of '-w -l'
+ * is line based
+ */
+static int allmesh_check_debug_table(int argc, char **argv)
+{
+	bool changes_only = false;
+	bool watch = false;
+	bool diff = false;
+	int optchar;
+	int ret = 0;
+
+	/* the debug table reports unknown options itself */
+	opterr = 0;
+
+	while ((optchar = getopt(argc, argv, DEBUG_TABLE_OPTSTRING)) != -1) {
+		switch (optchar) {
+		case 'w':
+			watch = true;
+			if (optarg[0] == '-')
+				optind--;
+			break;
+		case 'd':
+			diff = true;
+			break;
+		case 'l':
+			changes_only = true;
+			break;
+		case '?':
+			if (optopt == 'w')
+				watch = true;
+			break;
+		}
+	}
+
+	if (diff) {
+		fprintf(stderr, "Error - '-d' can't be used for all mesh interfaces, use '-l'\n");
+		ret = -EINVAL;
+	} else if (watch && !changes_only) {
+		fprintf(stderr, "Error - '-w' needs '-l' for all mesh interfaces\n");
+		ret = -EINVAL;
+	}
+
+	opterr = 1;
+	optind = 0;
+
+	return ret;
+}
+
+int allmesh_run(struct state *state, int argc, char **argv)
+{
+	enum allmesh_output output;
+	struct allmesh allmesh = {
+		.workers = NULL,
+		.num_workers = 0,
+		.max_workers = 0,
+		.error = 0,
+	};
+	int ret = EXIT_SUCCESS;
+	struct outbuf out;
+	int status;
+	int width = 0;
+	size_t i;
+	int err;
+
+	if (allmesh_help_requested(argc, argv))
+		return state->cmd->handler(state, argc, argv);
+
+	if (state->cmd->type == DEBUGTABLE &&
+	    allmesh_check_debug_table(argc, argv) < 0)
+		return EXIT_FAILURE;
+
+	check_root_or_die("batctl");
+
+	err = for_each_mesh_iface(allmesh_add_iface, &allmesh);
+	if (err < 0 || allmesh.error < 0) {
+		fprintf(stderr, "Error - failed to list the mesh interfaces: %s\n",
+			strerror(-(err < 0 ? err : allmesh.error)));
+		ret = EXIT_FAILURE;
+		goto free_workers;
+	}
+
+	if (allmesh.num_workers == 0) {
+		fprintf(stderr, "Error - no batman-adv interface found\n");
+		ret = EXIT_FAILURE;
+		goto free_workers;
+	}
+
+	if (outbuf_init(&out, stdout) < 0) {
+		ret = EXIT_FAILURE;
+		goto free_workers;
+	}
+
+	for (i = 0; i < allmesh.num_workers; i++) {
+		if ((int)strlen(allmesh.workers[i].mesh_iface) > width)
+			width = strlen(allmesh.workers[i].mesh_iface);
+	}
+
+	output = allmesh_output(state->cmd, argc, argv);
+
+	err = allmesh_start(&allmesh, state, argc, argv);
+	if (err < 0) {
+		fprintf(stderr, "Error - failed to start the workers: %s\n",
+			strerror(-err));
+		ret = EXIT_FAILURE;
+	}
+
+	if (err >= 0)
+		err = allmesh_collect(&allmesh, &out, output, width);
+
+	for (i = 0; i < allmesh.num_workers; i++) {
+		if (allmesh.workers[i].fd >= 0)
+			close(allmesh.workers[i].fd);
+
+		if (allmesh.workers[i].pid <= 0)
+			continue;
+
+		if (waitpid(allmesh.workers[i].pid, &status, 0) < 0 ||
+		    !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+			ret = EXIT_FAILURE;
+
+			/* don't merge partial documents */
+			allmesh.workers[i].buf.len = 0;
+		}
+	}
+
+	if (err < 0)
+		ret = EXIT_FAILURE;
+	else
+		allmesh_print_merged(&allmesh, &out, output);
+
+	outbuf_flush(&out);
+	outbuf_free(&out);
+
+free_workers:
+	for (i = 0; i < allmesh.num_workers; i++)
+		outbuf_free(&allmesh.workers[i].buf);
+
+	free(allmesh.workers);
+
+	return ret;
+}
@@ -0,0 +1,14 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/* Copyright (C) B.A.T.M.A.N. contributors:
+ *
+ * License-Filename: LICENSES/preferred/GPL-2.0
+ */
+
+#ifndef _BATCTL_ALLMESH_H
+#define _BATCTL_ALLMESH_H
+
+struct state;
+
+int allmesh_run(struct state *state, int argc, char **argv);
+
+#endif /* _BATCTL_ALLMESH_H */
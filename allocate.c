@@ -0,0 +1,145 @@
+// SPDX-License-Identifier: GPL-2.0
+/* Copyright (C) B.A.T.M.A.N. contributors:
+ *
+ * License-Filename: LICENSES/preferred/GPL-2.0
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+
+#include "allocate.h"
+
+/* same alignment as malloc() guarantees */
+#define ARENA_ALIGN (2 * sizeof(void *))
+#define ARENA_MIN_CHUNK 4096
+#define ARENA_MAX_CHUNK (1024 * 1024)
+
+struct arena_chunk {
+	struct arena_chunk *next;
+	size_t size;
+	size_t used;
+};
+
+static size_t arena_align(size_t size)
+{
+	return (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+}
+
+/* the objects start behind the aligned chunk header */
+static unsigned char *arena_chunk_data(struct arena_chunk *chunk)
+{
+	return (unsigned char *)chunk + arena_align(sizeof(*chunk));
+}
+
+void arena_init(struct arena *arena, const char *name, size_t size)
+{
+	arena->chunk = NULL;
+	arena->name = name;
+	arena->allocated = 0;
+	arena->reserved = 0;
+	arena->count = 0;
+
+	if (size < ARENA_MIN_CHUNK)
+		size = ARENA_MIN_CHUNK;
+
+	arena->chunk_size = size;
+}
+
+static struct arena_chunk *arena_chunk_new(struct arena *arena, size_t size)
+{
+	struct arena_chunk *chunk;
+
+	if (size > SIZE_MAX - arena_align(sizeof(*chunk)))
+		return NULL;
+
+	chunk = malloc(arena_align(sizeof(*chunk)) + size);
+	if (!chunk)
+		return NULL;
+
+	chunk->size = size;
+	chunk->used = 0;
+	arena->reserved += size;
+
+	return chunk;
+}
+
+void *arena_alloc(struct arena *arena, size_t size)
+{
+	struct arena_chunk *chunk = arena->chunk;
+	void *data;
+
+	if (size > SIZE_MAX - ARENA_ALIGN)
+		return NULL;
+
+	size = arena_align(size);
+
+	if (!chunk || chunk->size - chunk->used < size) {
+		/* objects bigger than a chunk get their own chunk behind the
+		 * current one, which still has room for smaller objects
+		 */
+		if (size > arena->chunk_size / 4 && chunk) {
+			chunk = arena_chunk_new(arena, size);
+			if (!chunk)
+				return NULL;
+
+			chunk->next = arena->chunk->next;
+			arena->chunk->next = chunk;
+		} else {
+			if (size > arena->chunk_size)
+				arena->chunk_size = size;
+
+			chunk = arena_chunk_new(arena, arena->chunk_size);
+			if (!chunk)
+				return NULL;
+
+			chunk->next = arena->chunk;
+			arena->chunk = chunk;
+
+			if (arena->chunk_size < ARENA_MAX_CHUNK)
+				arena->chunk_size *= 2;
+		}
+	}
+
+	data = arena_chunk_data(chunk) + chunk->used;
+	chunk->used += size;
+	arena->allocated += size;
+	arena->count++;
+
+	return data;
+}
+
+#ifdef DEBUG_MALLOC
+static void arena_report(const struct arena *arena)
+{
+	struct rusage usage;
+	long maxrss = -1;
+
+	if (getrusage(RUSAGE_SELF, &usage) == 0)
+		maxrss = usage.ru_maxrss;
+
+	fprintf(stderr,
+		"arena %s: %lu objects, %zu of %zu bytes used, peak RSS %ld KiB\n",
+		arena->name, arena->count, arena->allocated, arena->reserved,
+		maxrss);
+}
+#endif
+
+void arena_release(struct arena *arena)
+{
+	struct arena_chunk *chunk;
+
+#ifdef DEBUG_MALLOC
+	if (arena->count)
+		arena_report(arena);
+#endif
+
+	while (arena->chunk) {
+		chunk = arena->chunk;
+		arena->chunk = chunk->next;
+		free(chunk);
+	}
+
+	arena_init(arena, arena->name, 0);
+}
@@ -10,11 +10,35 @@
 #ifndef _BATCTL_ALLOCATE_H
 #define _BATCTL_ALLOCATE_H
 
-/* debug allocate wrapper to keep hash.c happy */
+#include <stddef.h>
 
-#include <stdlib.h>
+/* bump allocator for many small objects which are freed all at once
+ *
+ * Memory is taken from chunks which double in size up to 1 MiB. Single
+ * objects cannot be freed, arena_release() frees all chunks. Build with
+ * -DDEBUG_MALLOC to print the usage of each arena and the peak RSS of the
+ * process when the arena is released.
+ */
+struct arena_chunk;
+
+struct arena {
+	struct arena_chunk *chunk;	/* newest chunk, links to older ones */
+	const char *name;
+	size_t chunk_size;		/* size of the next chunk */
+	size_t allocated;
+	size_t reserved;
+	unsigned long count;
+};
+
+/* prepare an empty arena. size is the expected number of bytes, the first
+ * chunk is allocated by the first arena_alloc()
+ */
+void arena_init(struct arena *arena, const char *name, size_t size);
+
+/* returns size bytes aligned like malloc() or NULL on error */
+void *arena_alloc(struct arena *arena, size_t size);
 
-#define debugMalloc(length, tag) malloc(length)
-#define debugFree(mem, tag) free(mem)
+/* free all memory of the arena. It can be used again afterwards */
+void arena_release(struct arena *arena);
 
 #endif
@@ -21,6 +21,8 @@
 #include "functions.h"
 #include "main.h"
 #include "netlink.h"
+#include "output.h"
+#include "tablefmt.h"
 
 static const int bla_backbone_mandatory[] = {
 	BATADV_ATTR_BLA_VID,
@@ -29,44 +31,28 @@ static const int bla_backbone_mandatory[] = {
 	BATADV_ATTR_LAST_SEEN_MSECS,
 };
 
-static int bla_backbone_callback(struct nl_msg *msg, void *arg)
+static const struct table_column bla_backbone_columns[] = {
+	{ "bla_backbone", BATADV_ATTR_BLA_BACKBONE, table_column_mac },
+	{ "bla_vid", BATADV_ATTR_BLA_VID, table_column_vid },
+	{ "last_seen_msecs", BATADV_ATTR_LAST_SEEN_MSECS, table_column_u32 },
+	{ "bla_crc", BATADV_ATTR_BLA_CRC, table_column_u16 },
+};
+
+/* don't show own backbones */
+static bool bla_backbone_match(struct nlattr *attrs[],
+			       const struct print_opts *opts __maybe_unused)
+{
+	return !attrs[BATADV_ATTR_BLA_OWN];
+}
+
+static void bla_backbone_print(struct nlattr *attrs[], struct print_opts *opts)
 {
-	struct nlattr *attrs[BATADV_ATTR_MAX+1];
-	struct nlmsghdr *nlh = nlmsg_hdr(msg);
 	int last_seen_msecs, last_seen_secs;
-	struct print_opts *opts = arg;
 	struct bat_host *bat_host;
-	struct genlmsghdr *ghdr;
 	uint16_t backbone_crc;
 	uint8_t *backbone;
 	uint16_t vid;
 
-	if (!genlmsg_valid_hdr(nlh, 0)) {
-		fputs("Received invalid data from kernel.\n", stderr);
-		exit(1);
-	}
-
-	ghdr = nlmsg_data(nlh);
-
-	if (ghdr->cmd != BATADV_CMD_GET_BLA_BACKBONE)
-		return NL_OK;
-
-	if (nla_parse(attrs, BATADV_ATTR_MAX, genlmsg_attrdata(ghdr, 0),
-		      genlmsg_len(ghdr), batadv_netlink_policy)) {
-		fputs("Received invalid data from kernel.\n", stderr);
-		exit(1);
-	}
-
-	if (missing_mandatory_attrs(attrs, bla_backbone_mandatory,
-				    ARRAY_SIZE(bla_backbone_mandatory))) {
-		fputs("Missing attributes from kernel\n", stderr);
-		exit(1);
-	}
-
-	/* don't show own backbones */
-	if (attrs[BATADV_ATTR_BLA_OWN])
-		return NL_OK;
-
 	vid = nla_get_u16(attrs[BATADV_ATTR_BLA_VID]);
 	backbone = nla_data(attrs[BATADV_ATTR_BLA_BACKBONE]);
 	backbone_crc = nla_get_u16(attrs[BATADV_ATTR_BLA_CRC]);
@@ -77,32 +63,45 @@ static int bla_backbone_callback(struct nl_msg *msg, void *arg)
 
 	bat_host = bat_hosts_find_by_mac((char *)backbone);
 	if (!(opts->read_opt & USE_BAT_HOSTS) || !bat_host)
-		printf("%02x:%02x:%02x:%02x:%02x:%02x ",
-		       backbone[0], backbone[1], backbone[2],
-		       backbone[3], backbone[4], backbone[5]);
+		outbuf_mac(opts->out, backbone);
 	else
-		printf("%17s ", bat_host->name);
-
-	printf("on %5d %4i.%03is (0x%04x)\n",
-	       BATADV_PRINT_VID(vid), last_seen_secs, last_seen_msecs,
-	       backbone_crc);
-
-	return NL_OK;
+		outbuf_str(opts->out, bat_host->name, 17);
+	outbuf_putc(opts->out, ' ');
+
+	outbuf_str(opts->out, "on ", 0);
+	outbuf_int(opts->out, BATADV_PRINT_VID(vid), 5);
+	outbuf_putc(opts->out, ' ');
+	outbuf_int(opts->out, last_seen_secs, 4);
+	outbuf_putc(opts->out, '.');
+	outbuf_uint_zero(opts->out, last_seen_msecs, 3);
+	outbuf_str(opts->out, "s (0x", 0);
+	outbuf_hex(opts->out, backbone_crc, 4);
+	outbuf_str(opts->out, ")\n", 0);
 }
 
+static const struct table_rows bla_backbone_rows = {
+	.mandatory = bla_backbone_mandatory,
+	.num_mandatory = ARRAY_SIZE(bla_backbone_mandatory),
+	.match = bla_backbone_match,
+	.print = bla_backbone_print,
+};
+
 static int netlink_print_bla_backbone(struct state *state, char *orig_iface,
 				      int read_opts, float orig_timeout,
-				      float watch_interval)
+				      float watch_interval,
+				      const struct table_opts *table)
 {
 	return netlink_print_common(state, orig_iface, read_opts,
 				    orig_timeout, watch_interval,
 				    "Originator           VID   last seen (CRC   )\n",
 				    BATADV_CMD_GET_BLA_BACKBONE,
-				    bla_backbone_callback);
+				    &bla_backbone_rows, table);
 }
 
 static struct debug_table_data batctl_debug_table_backbonetable = {
 	.netlink_fn = netlink_print_bla_backbone,
+	.columns = bla_backbone_columns,
+	.num_columns = ARRAY_SIZE(bla_backbone_columns),
 };
 
 COMMAND_NAMED(DEBUGTABLE, backbonetable, "bbt", handle_debug_table,
@@ -15,49 +15,120 @@
 #include <errno.h>
 #include <string.h>
 #include <stddef.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <netinet/ether.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
+#include "allocate.h"
 #include "bat-hosts.h"
-#include "hash.h"
 #include "functions.h"
+#include "macmap.h"
+#include "oahash.h"
 
 
-static struct hashtable_t *host_hash = NULL;
+/* all bat_host entries, freed at once by bat_hosts_free() */
+static struct arena host_arena;
+static struct macmap host_hash;
+/* same entries as host_hash, keyed by bat_host->name */
+static struct oahash name_hash;
 const char *bat_hosts_path[3] = {"/etc/bat-hosts", "~/bat-hosts", "bat-hosts"};
 
+#define BAT_HOSTS_LOCATIONS (sizeof(bat_hosts_path) / sizeof(bat_hosts_path[0]))
+
+#define BAT_HOSTS_CACHE_MAGIC "BHIX"
+#define BAT_HOSTS_CACHE_VERSION 1
+
+/* state of one bat_hosts_path location when the cache was compiled */
+struct bat_hosts_cache_src {
+	uint64_t dev;
+	uint64_t ino;
+	uint64_t size;
+	int64_t mtime_sec;
+	int64_t mtime_nsec;
+	uint32_t present;
+	uint32_t reserved;
+};
+
+/* the cache is only read on the host which wrote it, so all fields are in
+ * host byte order. The header is followed by num_hosts struct bat_host
+ * sorted by mac address and num_hosts uint32_t indices into that array
+ * sorted by name.
+ */
+struct bat_hosts_cache_hdr {
+	char magic[4];
+	uint32_t version;
+	uint32_t host_size;
+	uint32_t num_hosts;
+	struct bat_hosts_cache_src src[BAT_HOSTS_LOCATIONS];
+};
+
+static struct {
+	void *map;
+	size_t map_len;
+	const struct bat_host *hosts;
+	const uint32_t *by_name;
+	uint32_t num_hosts;
+	/* results of the mac address lookups in hosts, misses are stored as
+	 * &host_cache_miss
+	 */
+	struct macmap seen;
+} host_cache;
+
+static struct bat_host host_cache_miss;
+
+/* the seen table is sized once when the cache is opened, addresses beyond
+ * that are searched in hosts on every lookup
+ */
+#define BAT_HOSTS_CACHE_SEEN_MAX 4096
 
-static int compare_mac(void *data1, void *data2)
+/* set by bat_hosts_init() until the first lookup */
+static int host_load_pending;
+static int host_load_opt;
+
+
+/* names are compared up to HOST_NAME_MAX_LEN - 1 characters */
+static void bat_hosts_name_key(char key[HOST_NAME_MAX_LEN - 1], const char *name)
 {
-	return (memcmp(data1, data2, sizeof(struct ether_addr)) == 0 ? 1 : 0);
+	strncpy(key, name, HOST_NAME_MAX_LEN - 1);
 }
 
-static int choose_mac(void *data, int32_t size)
+static int bat_host_add(struct bat_host *bat_host)
 {
-	unsigned char *key= data;
-	uint32_t hash = 0, m_size = sizeof(struct ether_addr);
-	size_t i;
+	char key[HOST_NAME_MAX_LEN - 1];
+
+	if (macmap_add(&host_hash, macmap_key(&bat_host->mac_addr),
+		       bat_host) < 0)
+		return -1;
 
-	for (i = 0; i < m_size; i++) {
-		hash += key[i];
-		hash += (hash << 10);
-		hash ^= (hash >> 6);
+	bat_hosts_name_key(key, bat_host->name);
+	if (oahash_add(&name_hash, key, bat_host) < 0) {
+		macmap_remove(&host_hash, macmap_key(&bat_host->mac_addr));
+		return -1;
 	}
 
-	hash += (hash << 3);
-	hash ^= (hash >> 11);
-	hash += (hash << 15);
+	return 0;
+}
+
+static void bat_host_remove(struct bat_host *bat_host)
+{
+	char key[HOST_NAME_MAX_LEN - 1];
 
-	return (hash % size);
+	bat_hosts_name_key(key, bat_host->name);
+	oahash_remove(&name_hash, key);
+	macmap_remove(&host_hash, macmap_key(&bat_host->mac_addr));
+	/* the entry itself stays in host_arena */
 }
 
-static void parse_hosts_file(struct hashtable_t **hash, const char path[], int read_opt)
+static void parse_hosts_file(const char path[], int read_opt)
 {
 	FILE *fd;
 	char *line_ptr = NULL;
 	char name[HOST_NAME_MAX_LEN], mac_str[18];
 	struct ether_addr *mac_addr;
-	struct bat_host *bat_host;
-	struct hashtable_t *swaphash;
+	struct bat_host *bat_host, *old_host;
+	char key[HOST_NAME_MAX_LEN - 1];
 	size_t len = 0;
 
 	name[0] = mac_str[0] = '\0';
@@ -95,8 +166,18 @@ static void parse_hosts_file(struct hashtable_t **hash, const char path[], int r
 			if (read_opt & USE_BAT_HOSTS)
 				fprintf(stderr, "Warning - mac already known (changing name from '%s' to '%s'): %s\n",
 					bat_host->name, name, mac_str);
+
+			/* the new name must not stay reachable via another mac */
+			old_host = bat_hosts_find_by_name(name);
+			if (old_host)
+				bat_host_remove(old_host);
+
+			bat_hosts_name_key(key, bat_host->name);
+			oahash_remove(&name_hash, key);
 			strncpy(bat_host->name, name, HOST_NAME_MAX_LEN);
 			bat_host->name[HOST_NAME_MAX_LEN - 1] = '\0';
+			bat_hosts_name_key(key, bat_host->name);
+			oahash_add(&name_hash, key, bat_host);
 			continue;
 		}
 
@@ -107,11 +188,10 @@ static void parse_hosts_file(struct hashtable_t **hash, const char path[], int r
 			if (read_opt & USE_BAT_HOSTS)
 				fprintf(stderr, "Warning - name already known (changing mac from '%s' to '%s'): %s\n",
 					ether_ntoa(&bat_host->mac_addr), mac_str, name);
-			hash_remove(*hash, bat_host);
-			free(bat_host);
+			bat_host_remove(bat_host);
 		}
 
-		bat_host = malloc(sizeof(struct bat_host));
+		bat_host = arena_alloc(&host_arena, sizeof(struct bat_host));
 
 		if (!bat_host) {
 			if (read_opt & USE_BAT_HOSTS)
@@ -123,15 +203,9 @@ static void parse_hosts_file(struct hashtable_t **hash, const char path[], int r
 		strncpy(bat_host->name, name, HOST_NAME_MAX_LEN);
 		bat_host->name[HOST_NAME_MAX_LEN - 1] = '\0';
 
-		hash_add(*hash, bat_host);
-
-		if ((*hash)->elements * 4 > (*hash)->size) {
-			swaphash = hash_resize((*hash), (*hash)->size * 2);
-
-			if (swaphash)
-				*hash = swaphash;
-			else if (read_opt & USE_BAT_HOSTS)
-				fprintf(stderr, "Warning - couldn't resize bat hosts hash table\n");
+		if (bat_host_add(bat_host) < 0) {
+			if (read_opt & USE_BAT_HOSTS)
+				fprintf(stderr, "Warning - couldn't add bat host to hash table: %s\n", name);
 		}
 	}
 
@@ -143,13 +217,38 @@ static void parse_hosts_file(struct hashtable_t **hash, const char path[], int r
 	return;
 }
 
-void bat_hosts_init(int read_opt)
+/* expand bat_hosts_path[i] into confdir, returns -1 if it can't be used */
+static int bat_hosts_location(unsigned int i, char *confdir)
 {
-	unsigned int i, j, parse;
-	char confdir[CONF_DIR_LEN];
 	char *homedir;
-	size_t locations = sizeof(bat_hosts_path) / sizeof(char *);
+
+	if (strlen(bat_hosts_path[i]) >= 2
+	    && bat_hosts_path[i][0] == '~' && bat_hosts_path[i][1] == '/') {
+		homedir = getenv("HOME");
+		if (!homedir)
+			return -1;
+
+		snprintf(confdir, CONF_DIR_LEN, "%s%s", homedir, &bat_hosts_path[i][1]);
+	} else {
+		strncpy(confdir, bat_hosts_path[i], CONF_DIR_LEN);
+		confdir[CONF_DIR_LEN - 1] = '\0';
+	}
+
+	return 0;
+}
+
+/* typical line: 17 characters mac, separator, short name and newline */
+#define BAT_HOSTS_AVG_LINE_LEN 28
+
+static void bat_hosts_parse(int read_opt)
+{
+	unsigned int i, j;
+	char confdir[CONF_DIR_LEN];
+	size_t locations = BAT_HOSTS_LOCATIONS;
+	int parse[BAT_HOSTS_LOCATIONS];
+	off_t total_size = 0;
 	char *normalized;
+	struct stat st;
 
 	/***
 	 * realpath could allocate the memory for us but some embedded libc
@@ -163,83 +262,378 @@ void bat_hosts_init(int read_opt)
 	}
 
 	memset(normalized, 0, locations * PATH_MAX);
-	host_hash = hash_new(64, compare_mac, choose_mac);
-
-	if (!host_hash) {
-		if (read_opt & USE_BAT_HOSTS)
-			printf("Warning - could not create bat hosts hash table\n");
-		goto out;
-	}
-
-	homedir = getenv("HOME");
 
 	for (i = 0; i < locations; i++) {
-		strcpy(confdir, "");
+		parse[i] = 0;
 
-		if (strlen(bat_hosts_path[i]) >= 2
-		    && bat_hosts_path[i][0] == '~' && bat_hosts_path[i][1] == '/') {
-			if (!homedir)
-				continue;
-
-			snprintf(confdir, CONF_DIR_LEN, "%s%s", homedir, &bat_hosts_path[i][1]);
-		} else {
-			strncpy(confdir, bat_hosts_path[i], CONF_DIR_LEN);
-			confdir[CONF_DIR_LEN - 1] = '\0';
-		}
+		if (bat_hosts_location(i, confdir) < 0)
+			continue;
 
 		if (!realpath(confdir, normalized + (i * PATH_MAX)))
 			continue;
 
 		/* check for duplicates: don't parse the same file twice */
-		parse = 1;
+		parse[i] = 1;
 		for (j = 0; j < i; j++) {
 			if (strncmp(normalized + (i * PATH_MAX), normalized + (j * PATH_MAX), CONF_DIR_LEN) == 0) {
-				parse = 0;
+				parse[i] = 0;
 				break;
 			}
 		}
 
-		if (parse)
-			parse_hosts_file(&host_hash, normalized + (i * PATH_MAX), read_opt);
+		if (parse[i] && stat(normalized + (i * PATH_MAX), &st) == 0)
+			total_size += st.st_size;
+	}
+
+	/* start with the size the tables would grow to anyway, files with
+	 * unusually short lines still make them grow
+	 */
+	arena_init(&host_arena, "bat-hosts",
+		   total_size / BAT_HOSTS_AVG_LINE_LEN *
+		   sizeof(struct bat_host));
+
+	if (macmap_init(&host_hash, total_size / BAT_HOSTS_AVG_LINE_LEN) < 0 ||
+	    oahash_init(&name_hash, HOST_NAME_MAX_LEN - 1,
+			total_size / BAT_HOSTS_AVG_LINE_LEN) < 0) {
+		if (read_opt & USE_BAT_HOSTS)
+			printf("Warning - could not create bat hosts hash table\n");
+		bat_hosts_free();
+		goto out;
+	}
+
+	for (i = 0; i < locations; i++) {
+		if (parse[i])
+			parse_hosts_file(normalized + (i * PATH_MAX), read_opt);
 	}
 
 out:
 	free(normalized);
 }
 
-struct bat_host *bat_hosts_find_by_name(char *name)
+static void bat_hosts_cache_stat(struct bat_hosts_cache_src *src)
 {
-	struct hash_it_t *hashit = NULL;
-	struct bat_host *bat_host = NULL, *tmp_bat_host;
+	char confdir[CONF_DIR_LEN];
+	struct stat st;
+	unsigned int i;
 
-	if (!host_hash)
-		return NULL;
+	memset(src, 0, BAT_HOSTS_LOCATIONS * sizeof(*src));
 
-	while (NULL != (hashit = hash_iterate(host_hash, hashit))) {
-		tmp_bat_host = (struct bat_host *)hashit->bucket->data;
+	for (i = 0; i < BAT_HOSTS_LOCATIONS; i++) {
+		if (bat_hosts_location(i, confdir) < 0)
+			continue;
+
+		if (stat(confdir, &st) < 0)
+			continue;
 
-		if (strncmp(tmp_bat_host->name, name, HOST_NAME_MAX_LEN - 1) == 0)
-			bat_host = tmp_bat_host;
+		src[i].dev = st.st_dev;
+		src[i].ino = st.st_ino;
+		src[i].size = st.st_size;
+		src[i].mtime_sec = st.st_mtim.tv_sec;
+		src[i].mtime_nsec = st.st_mtim.tv_nsec;
+		src[i].present = 1;
 	}
+}
 
-	return bat_host;
+/* the lookups use the entries without further checks, so a damaged cache
+ * must not index outside of hosts or have a name without terminator
+ */
+static int bat_hosts_cache_check(const struct bat_host *hosts,
+				 const uint32_t *by_name, uint32_t num_hosts)
+{
+	uint32_t i;
+
+	for (i = 0; i < num_hosts; i++) {
+		if (by_name[i] >= num_hosts)
+			return -1;
+
+		if (!memchr(hosts[i].name, '\0', sizeof(hosts[i].name)))
+			return -1;
+	}
+
+	return 0;
 }
 
-struct bat_host *bat_hosts_find_by_mac(char *mac)
+/* map the compiled cache if it still matches the bat-hosts files */
+static int bat_hosts_cache_open(void)
 {
-	if (!host_hash)
+	struct bat_hosts_cache_src src[BAT_HOSTS_LOCATIONS];
+	const struct bat_hosts_cache_hdr *hdr;
+	const struct bat_host *hosts;
+	const uint32_t *by_name;
+	struct stat st;
+	size_t len;
+	void *map;
+	int fd;
+
+	fd = open(BAT_HOSTS_CACHE, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return -1;
+
+	if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(*hdr)) {
+		close(fd);
+		return -1;
+	}
+
+	len = st.st_size;
+	map = mmap(NULL, len, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (map == MAP_FAILED)
+		return -1;
+
+	hdr = map;
+	bat_hosts_cache_stat(src);
+
+	if (memcmp(hdr->magic, BAT_HOSTS_CACHE_MAGIC, sizeof(hdr->magic)) != 0 ||
+	    hdr->version != BAT_HOSTS_CACHE_VERSION ||
+	    hdr->host_size != sizeof(struct bat_host) ||
+	    hdr->num_hosts > (len - sizeof(*hdr)) / (sizeof(struct bat_host) + sizeof(uint32_t)) ||
+	    len != sizeof(*hdr) + hdr->num_hosts * (sizeof(struct bat_host) + sizeof(uint32_t)) ||
+	    memcmp(hdr->src, src, sizeof(src)) != 0) {
+		munmap(map, len);
+		return -1;
+	}
+
+	hosts = (const struct bat_host *)(hdr + 1);
+	by_name = (const uint32_t *)(hosts + hdr->num_hosts);
+
+	if (bat_hosts_cache_check(hosts, by_name, hdr->num_hosts) < 0) {
+		munmap(map, len);
+		return -1;
+	}
+
+	host_cache.map = map;
+	host_cache.map_len = len;
+	host_cache.num_hosts = hdr->num_hosts;
+	host_cache.hosts = hosts;
+	host_cache.by_name = by_name;
+
+	/* the lookups still work without it */
+	macmap_init(&host_cache.seen, BAT_HOSTS_CACHE_SEEN_MAX);
+
+	return 0;
+}
+
+/* the files are only read when the first name or mac address is looked up */
+void bat_hosts_init(int read_opt)
+{
+	host_load_pending = 1;
+	host_load_opt = read_opt;
+}
+
+static void bat_hosts_load(void)
+{
+	if (!host_load_pending)
+		return;
+
+	host_load_pending = 0;
+
+	if (bat_hosts_cache_open() == 0)
+		return;
+
+	bat_hosts_parse(host_load_opt);
+}
+
+static int bat_hosts_mac_cmp(const void *data1, const void *data2)
+{
+	return memcmp(data1, data2, sizeof(struct ether_addr));
+}
+
+static int bat_hosts_name_cmp(const void *data1, const void *data2)
+{
+	const struct bat_host *bat_host1 = *(const struct bat_host * const *)data1;
+	const struct bat_host *bat_host2 = *(const struct bat_host * const *)data2;
+
+	return strcmp(bat_host1->name, bat_host2->name);
+}
+
+static int bat_hosts_cache_write(int fd, const void *data, size_t len)
+{
+	const char *buf = data;
+	ssize_t ret;
+
+	while (len > 0) {
+		ret = write(fd, buf, len);
+		if (ret < 0 && errno == EINTR)
+			continue;
+
+		if (ret < 0)
+			return -errno;
+
+		buf += ret;
+		len -= ret;
+	}
+
+	return 0;
+}
+
+int bat_hosts_compile(int read_opt)
+{
+	char tmp_path[] = BAT_HOSTS_CACHE ".XXXXXX";
+	struct bat_hosts_cache_hdr hdr;
+	struct bat_host *bat_host;
+	uint32_t iter = 0;
+	struct bat_host **by_name_ptr = NULL;
+	struct bat_host *hosts = NULL;
+	uint32_t *by_name = NULL;
+	uint32_t num_hosts = 0;
+	int ret = -ENOMEM;
+	uint32_t i;
+	int fd;
+
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, BAT_HOSTS_CACHE_MAGIC, sizeof(hdr.magic));
+	hdr.version = BAT_HOSTS_CACHE_VERSION;
+	hdr.host_size = sizeof(struct bat_host);
+
+	/* a file modified while it is parsed leaves a stale cache behind */
+	bat_hosts_cache_stat(hdr.src);
+	bat_hosts_parse(read_opt);
+
+	if (!host_hash.table.slots)
+		return -ENOMEM;
+
+	hosts = malloc(host_hash.elements * sizeof(*hosts) + 1);
+	by_name_ptr = malloc(host_hash.elements * sizeof(*by_name_ptr) + 1);
+	by_name = malloc(host_hash.elements * sizeof(*by_name) + 1);
+	if (!hosts || !by_name_ptr || !by_name)
+		goto out;
+
+	while ((bat_host = macmap_iterate(&host_hash, &iter)))
+		memcpy(&hosts[num_hosts++], bat_host, sizeof(*hosts));
+
+	qsort(hosts, num_hosts, sizeof(*hosts), bat_hosts_mac_cmp);
+
+	for (i = 0; i < num_hosts; i++)
+		by_name_ptr[i] = &hosts[i];
+
+	qsort(by_name_ptr, num_hosts, sizeof(*by_name_ptr), bat_hosts_name_cmp);
+
+	for (i = 0; i < num_hosts; i++)
+		by_name[i] = by_name_ptr[i] - hosts;
+
+	hdr.num_hosts = num_hosts;
+
+	if (mkdir(BAT_HOSTS_CACHE_DIR, 0755) < 0 && errno != EEXIST) {
+		ret = -errno;
+		goto out;
+	}
+
+	fd = mkstemp(tmp_path);
+	if (fd < 0) {
+		ret = -errno;
+		goto out;
+	}
+
+	ret = bat_hosts_cache_write(fd, &hdr, sizeof(hdr));
+	if (ret == 0)
+		ret = bat_hosts_cache_write(fd, hosts, num_hosts * sizeof(*hosts));
+	if (ret == 0)
+		ret = bat_hosts_cache_write(fd, by_name, num_hosts * sizeof(*by_name));
+	if (ret == 0 && fchmod(fd, 0644) < 0)
+		ret = -errno;
+
+	if (close(fd) < 0 && ret == 0)
+		ret = -errno;
+
+	/* readers either see the old or the complete new cache */
+	if (ret == 0 && rename(tmp_path, BAT_HOSTS_CACHE) < 0)
+		ret = -errno;
+
+	if (ret < 0)
+		unlink(tmp_path);
+
+out:
+	free(by_name);
+	free(by_name_ptr);
+	free(hosts);
+	return ret;
+}
+
+static struct bat_host *bat_hosts_cache_find_by_name(const char *name)
+{
+	const struct bat_host *bat_host;
+	uint32_t low = 0, high = host_cache.num_hosts, mid;
+	int cmp;
+
+	while (low < high) {
+		mid = low + (high - low) / 2;
+		bat_host = &host_cache.hosts[host_cache.by_name[mid]];
+
+		cmp = strncmp(name, bat_host->name, HOST_NAME_MAX_LEN - 1);
+		if (cmp == 0)
+			return (struct bat_host *)bat_host;
+
+		if (cmp < 0)
+			high = mid;
+		else
+			low = mid + 1;
+	}
+
+	return NULL;
+}
+
+struct bat_host *bat_hosts_find_by_name(char *name)
+{
+	char key[HOST_NAME_MAX_LEN - 1];
+
+	bat_hosts_load();
+
+	if (host_cache.map)
+		return bat_hosts_cache_find_by_name(name);
+
+	bat_hosts_name_key(key, name);
+
+	return oahash_find(&name_hash, key);
+}
+
+/* tcpdump looks up the same few addresses for every packet, so the
+ * binary search is only done once per address
+ */
+static struct bat_host *bat_hosts_cache_find_by_mac(const char *mac)
+{
+	uint64_t key = macmap_key(mac);
+	struct bat_host *bat_host;
+
+	bat_host = macmap_find(&host_cache.seen, key);
+	if (bat_host == &host_cache_miss)
 		return NULL;
 
-	return (struct bat_host *)hash_find(host_hash, mac);
+	if (bat_host)
+		return bat_host;
+
+	bat_host = bsearch(mac, host_cache.hosts, host_cache.num_hosts,
+			   sizeof(*host_cache.hosts), bat_hosts_mac_cmp);
+
+	/* never grow it, a lookup must not allocate */
+	if (host_cache.seen.elements < BAT_HOSTS_CACHE_SEEN_MAX)
+		macmap_add(&host_cache.seen, key,
+			   bat_host ? bat_host : &host_cache_miss);
+
+	return bat_host;
 }
 
-static void bat_host_free(void *data)
+struct bat_host *bat_hosts_find_by_mac(char *mac)
 {
-	free(data);
+	bat_hosts_load();
+
+	if (host_cache.map)
+		return bat_hosts_cache_find_by_mac(mac);
+
+	return macmap_find(&host_hash, macmap_key(mac));
 }
 
 void bat_hosts_free(void)
 {
-	if (host_hash)
-		hash_delete(host_hash, bat_host_free);
+	oahash_destroy(&name_hash, NULL);
+	macmap_destroy(&host_hash, NULL);
+	arena_release(&host_arena);
+
+	if (host_cache.map)
+		munmap(host_cache.map, host_cache.map_len);
+
+	macmap_destroy(&host_cache.seen, NULL);
+
+	memset(&host_cache, 0, sizeof(host_cache));
+	host_load_pending = 0;
 }
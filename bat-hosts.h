@@ -16,6 +16,9 @@
 #define HOST_NAME_MAX_LEN 50
 #define CONF_DIR_LEN 256
 
+#define BAT_HOSTS_CACHE_DIR "/var/cache/batctl"
+#define BAT_HOSTS_CACHE BAT_HOSTS_CACHE_DIR "/bat-hosts.idx"
+
 
 struct bat_host {
 	struct ether_addr mac_addr;
@@ -26,5 +29,6 @@ void bat_hosts_init(int read_opt);
 struct bat_host *bat_hosts_find_by_name(char *name);
 struct bat_host *bat_hosts_find_by_mac(char *mac);
 void bat_hosts_free(void);
+int bat_hosts_compile(int read_opt);
 
 #endif
@@ -0,0 +1,239 @@
+// SPDX-License-Identifier: GPL-2.0
+/* Copyright (C) B.A.T.M.A.N. contributors:
+ *
+ * License-Filename: LICENSES/preferred/GPL-2.0
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <net/if.h>
+#include <netlink/netlink.h>
+#include <netlink/handlers.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "main.h"
+#include "functions.h"
+#include "netlink.h"
+
+#define BATCH_MAX_ARGS 64
+
+struct batch_opts {
+	bool print_timing;
+	/* command of the current line for the timing output */
+	const char *cmd_name;
+	char checked_iface[IF_NAMESIZE];
+	unsigned int checked_ifindex;
+};
+
+static void batch_usage(void)
+{
+	fprintf(stderr, "Usage: batctl [options] batch [parameters]\n");
+	fprintf(stderr, "parameters:\n");
+	fprintf(stderr, " \t -f file read commands from file instead of stdin\n");
+	fprintf(stderr, " \t -h print this help\n");
+	fprintf(stderr, " \t -q don't print the per command timing to stderr\n");
+}
+
+static double batch_elapsed_ms(const struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec - start->tv_sec) * 1000.0 +
+	       (now.tv_nsec - start->tv_nsec) / 1000000.0;
+}
+
+static int batch_check_mesh_iface(struct batch_opts *opts, struct state *state)
+{
+	unsigned int ifindex;
+
+	/* only ask rtnl again when the mesh interface changed between lines */
+	if (opts->checked_ifindex &&
+	    strcmp(opts->checked_iface, state->mesh_iface) == 0) {
+		ifindex = if_nametoindex(state->mesh_iface);
+		if (ifindex == opts->checked_ifindex) {
+			state->mesh_ifindex = ifindex;
+			return 0;
+		}
+	}
+
+	opts->checked_ifindex = 0;
+
+	if (check_mesh_iface(state) < 0)
+		return -1;
+
+	snprintf(opts->checked_iface, sizeof(opts->checked_iface), "%s",
+		 state->mesh_iface);
+	opts->checked_ifindex = state->mesh_ifindex;
+
+	return 0;
+}
+
+static void batch_reset_cb(struct nl_cb *cb)
+{
+	/* handlers point the shared callbacks to their own stack frames */
+	nl_cb_set(cb, NL_CB_VALID, NL_CB_DEFAULT, NULL, NULL);
+	nl_cb_set(cb, NL_CB_FINISH, NL_CB_DEFAULT, NULL, NULL);
+	nl_cb_set(cb, NL_CB_ACK, NL_CB_DEFAULT, NULL, NULL);
+	nl_cb_set(cb, NL_CB_SEQ_CHECK, NL_CB_DEFAULT, NULL, NULL);
+	nl_cb_err(cb, NL_CB_DEFAULT, NULL, NULL);
+}
+
+static int batch_run(struct batch_opts *opts, struct state *batch_state,
+		     int argc, char **argv)
+{
+	const struct command *cmd;
+	struct state state = {
+		.arg_iface = batch_state->arg_iface,
+		.selector = SP_NONE_OR_MESHIF,
+		.cmd = NULL,
+		.sock = batch_state->sock,
+		.cb = batch_state->cb,
+		.batadv_family = batch_state->batadv_family,
+	};
+	int dev_arguments;
+	int ret;
+
+	optind = 0;
+
+	dev_arguments = parse_dev_args(&state, argc, argv);
+	if (dev_arguments < 0)
+		return EXIT_FAILURE;
+
+	if (state.selector == SP_ALL_MESHIFS) {
+		fprintf(stderr, "Error - 'all' is not supported in batch mode\n");
+		return EXIT_FAILURE;
+	}
+
+	argv += dev_arguments;
+	argc -= dev_arguments;
+
+	if (argc == 0) {
+		opts->cmd_name = "-";
+		fprintf(stderr, "Error - no command specified\n");
+		return EXIT_FAILURE;
+	}
+
+	opts->cmd_name = argv[0];
+
+	cmd = find_command(&state, argv[0]);
+	if (!cmd) {
+		fprintf(stderr,
+			"Error - no valid command or debug table/JSON specified: %s\n",
+			argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (cmd == batch_state->cmd) {
+		fprintf(stderr, "Error - batch cannot be nested\n");
+		return EXIT_FAILURE;
+	}
+
+	state.cmd = cmd;
+	opts->cmd_name = cmd->name;
+
+	if (cmd->flags & COMMAND_FLAG_MESH_IFACE &&
+	    batch_check_mesh_iface(opts, &state) < 0) {
+		fprintf(stderr,
+			"Error - interface %s is not present or not a batman-adv interface\n",
+			state.mesh_iface);
+		return EXIT_FAILURE;
+	}
+
+	ret = cmd->handler(&state, argc, argv);
+
+	batch_reset_cb(batch_state->cb);
+	fflush(stdout);
+
+	return ret;
+}
+
+static int batch(struct state *state, int argc, char **argv)
+{
+	struct batch_opts opts = {
+		.print_timing = true,
+		.checked_ifindex = 0,
+	};
+	char *cmd_argv[BATCH_MAX_ARGS];
+	struct timespec start;
+	char *filename = NULL;
+	unsigned int lineno = 0;
+	char *line = NULL;
+	int ret = EXIT_SUCCESS;
+	size_t len = 0;
+	int cmd_argc;
+	FILE *fp;
+	int optchar;
+	int res;
+
+	while ((optchar = getopt(argc, argv, "f:hq")) != -1) {
+		switch (optchar) {
+		case 'f':
+			filename = optarg;
+			break;
+		case 'h':
+			batch_usage();
+			return EXIT_SUCCESS;
+		case 'q':
+			opts.print_timing = false;
+			break;
+		default:
+			batch_usage();
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (filename && strcmp(filename, "-") != 0) {
+		fp = fopen(filename, "r");
+		if (!fp) {
+			fprintf(stderr, "Error - can't open file '%s': %s\n",
+				filename, strerror(errno));
+			return EXIT_FAILURE;
+		}
+	} else {
+		fp = stdin;
+	}
+
+	while (getline(&line, &len, fp) != -1) {
+		lineno++;
+
+		cmd_argc = split_command_line(line, cmd_argv, BATCH_MAX_ARGS);
+		if (cmd_argc < 0) {
+			fprintf(stderr, "Error - too many arguments in line %u\n",
+				lineno);
+			ret = EXIT_FAILURE;
+			continue;
+		}
+
+		/* ignore empty lines and comments */
+		if (cmd_argc == 0)
+			continue;
+
+		opts.cmd_name = cmd_argv[0];
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		res = batch_run(&opts, state, cmd_argc, cmd_argv);
+
+		if (opts.print_timing)
+			fprintf(stderr, "batch:%u: %s %.3f ms (exit %d)\n",
+				lineno, opts.cmd_name, batch_elapsed_ms(&start),
+				res);
+
+		if (res != EXIT_SUCCESS)
+			ret = EXIT_FAILURE;
+	}
+
+	free(line);
+	if (fp != stdin)
+		fclose(fp);
+
+	return ret;
+}
+
+COMMAND(SUBCOMMAND, batch, "ba", COMMAND_FLAG_NETLINK, NULL,
+	"[-f file]         \texecute commands line by line with one netlink socket");
@@ -0,0 +1,232 @@
+// SPDX-License-Identifier: GPL-2.0
+/* Copyright (C) B.A.T.M.A.N. contributors:
+ *
+ * License-Filename: LICENSES/preferred/GPL-2.0
+ */
+
+/* times loading a generated bat-hosts file with 1k up to max_entries
+ * entries, looking all of them up by mac address and by name and freeing
+ * them again. The load is triggered by the first lookup, like in batctl.
+ *
+ * usage: bat_hosts_bench [max_entries]
+ *        bat_hosts_bench -g entries > bat-hosts
+ *
+ * The second form only writes the generated file, e.g. to time batctl
+ * itself against it.
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bat-hosts.h"
+
+/* the locations searched by bat-hosts.c, all replaced by the generated file */
+extern const char *bat_hosts_path[3];
+
+static volatile uintptr_t bench_sink;
+
+static double bench_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint64_t bench_rand(uint64_t *state)
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 7;
+	*state ^= *state << 17;
+
+	return *state;
+}
+
+static struct bat_host *bench_hosts(size_t num)
+{
+	uint64_t state = 0x9e3779b97f4a7c15ULL;
+	struct bat_host *hosts;
+	struct bat_host tmp;
+	uint64_t rand;
+	size_t i, j;
+
+	hosts = calloc(num, sizeof(*hosts));
+	if (!hosts)
+		return NULL;
+
+	for (i = 0; i < num; i++) {
+		rand = bench_rand(&state);
+
+		/* the index keeps the addresses unique */
+		hosts[i].mac_addr.ether_addr_octet[0] = 0x02;
+		hosts[i].mac_addr.ether_addr_octet[1] = rand >> 8;
+		hosts[i].mac_addr.ether_addr_octet[2] = i >> 24;
+		hosts[i].mac_addr.ether_addr_octet[3] = i >> 16;
+		hosts[i].mac_addr.ether_addr_octet[4] = i >> 8;
+		hosts[i].mac_addr.ether_addr_octet[5] = i;
+		snprintf(hosts[i].name, sizeof(hosts[i].name),
+			 "node%zu.mesh.example", i);
+	}
+
+	/* look the entries up in a different order than they were added */
+	for (i = num - 1; i > 0; i--) {
+		j = bench_rand(&state) % (i + 1);
+		tmp = hosts[i];
+		hosts[i] = hosts[j];
+		hosts[j] = tmp;
+	}
+
+	return hosts;
+}
+
+static int bench_write(FILE *fp, const struct bat_host *hosts, size_t num)
+{
+	const uint8_t *mac;
+	size_t i;
+
+	for (i = 0; i < num; i++) {
+		mac = hosts[i].mac_addr.ether_addr_octet;
+		fprintf(fp, "%02x:%02x:%02x:%02x:%02x:%02x %s\n",
+			mac[0], mac[1], mac[2], mac[3], mac[4], mac[5],
+			hosts[i].name);
+	}
+
+	return ferror(fp) ? -EIO : 0;
+}
+
+static int bench_size(size_t num)
+{
+	char path[] = "/tmp/bat-hosts.XXXXXX";
+	double load, by_mac, by_name, release;
+	struct bat_host *hosts;
+	struct bat_host *found;
+	uintptr_t sum = 0;
+	double start;
+	FILE *fp;
+	size_t i;
+	int ret;
+	int fd;
+
+	hosts = bench_hosts(num);
+	if (!hosts) {
+		fprintf(stderr, "Error - could not allocate %zu entries\n", num);
+		return -ENOMEM;
+	}
+
+	fd = mkstemp(path);
+	if (fd < 0) {
+		ret = -errno;
+		perror("Error - could not create bat-hosts file");
+		free(hosts);
+		return ret;
+	}
+
+	fp = fdopen(fd, "w");
+	if (!fp) {
+		ret = -errno;
+		perror("Error - could not open bat-hosts file");
+		close(fd);
+		goto out;
+	}
+
+	ret = bench_write(fp, hosts, num);
+	if (fclose(fp) != 0 && ret == 0)
+		ret = -errno;
+
+	if (ret < 0) {
+		fprintf(stderr, "Error - could not write %s\n", path);
+		goto out;
+	}
+
+	for (i = 0; i < sizeof(bat_hosts_path) / sizeof(bat_hosts_path[0]); i++)
+		bat_hosts_path[i] = path;
+
+	start = bench_now();
+	bat_hosts_init(0);
+	found = bat_hosts_find_by_mac((char *)&hosts[0].mac_addr);
+	load = bench_now() - start;
+
+	if (!found) {
+		fprintf(stderr, "Error - %s was not loaded\n", path);
+		bat_hosts_free();
+		ret = -ENOENT;
+		goto out;
+	}
+
+	start = bench_now();
+	for (i = 0; i < num; i++)
+		sum += (uintptr_t)bat_hosts_find_by_mac((char *)
+							&hosts[i].mac_addr);
+	by_mac = bench_now() - start;
+
+	start = bench_now();
+	for (i = 0; i < num; i++)
+		sum += (uintptr_t)bat_hosts_find_by_name(hosts[i].name);
+	by_name = bench_now() - start;
+
+	start = bench_now();
+	bat_hosts_free();
+	release = bench_now() - start;
+
+	bench_sink += sum;
+
+	printf("%8zu %11.3f %9.1f %9.1f %11.3f\n", num, load / 1e6,
+	       by_mac / num, by_name / num, release / 1e6);
+
+out:
+	unlink(path);
+	free(hosts);
+
+	return ret;
+}
+
+static int bench_generate(size_t num)
+{
+	struct bat_host *hosts;
+	int ret;
+
+	hosts = bench_hosts(num);
+	if (!hosts) {
+		fprintf(stderr, "Error - could not allocate %zu entries\n", num);
+		return -ENOMEM;
+	}
+
+	ret = bench_write(stdout, hosts, num);
+	free(hosts);
+
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	size_t max_entries = 1000000;
+	size_t num;
+
+	if (argc > 2 && strcmp(argv[1], "-g") == 0) {
+		num = strtoul(argv[2], NULL, 10);
+		if (num == 0 || bench_generate(num) < 0)
+			return EXIT_FAILURE;
+
+		return EXIT_SUCCESS;
+	}
+
+	if (argc > 1)
+		max_entries = strtoul(argv[1], NULL, 10);
+
+	printf("%8s %11s %9s %9s %11s\n", "entries", "load", "by mac",
+	       "by name", "free");
+	printf("%8s %11s %9s %9s %11s\n", "", "ms", "ns/op", "ns/op", "ms");
+
+	for (num = 1000; num <= max_entries; num *= 10) {
+		if (bench_size(num) < 0)
+			return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,385 @@
+// SPDX-License-Identifier: GPL-2.0
+/* Copyright (C) B.A.T.M.A.N. contributors:
+ *
+ * License-Filename: LICENSES/preferred/GPL-2.0
+ */
+
+/* compares the chaining hash of hash.c with the oahash and the macmap.
+ *
+ * The names are keyed like the bat-hosts name index (49 byte keys), the mac
+ * addresses like the bat-hosts address index. The chaining hash grows like
+ * bat-hosts did before the oahash: the size is doubled with hash_resize()
+ * when it is more than 1/4 full.
+ *
+ * usage: hash_bench [max_entries]
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hash.h"
+#include "macmap.h"
+#include "oahash.h"
+
+#define NAME_LEN 50
+#define NAME_KEY_LEN (NAME_LEN - 1)
+
+struct entry {
+	char name[NAME_LEN];
+	uint8_t mac[6];
+};
+
+struct bench_result {
+	double insert;
+	double find;
+	double miss;
+	double iterate;
+	double resize;
+};
+
+struct bench_impl {
+	const char *name;
+	int (*run)(struct entry *entries, struct entry *missing,
+		   const uint32_t *order, size_t num,
+		   struct bench_result *result);
+};
+
+static volatile uintptr_t bench_sink;
+
+static double bench_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint64_t bench_rand(uint64_t *state)
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 7;
+	*state ^= *state << 17;
+
+	return *state;
+}
+
+static void bench_entry(struct entry *entry, uint64_t *state, size_t i)
+{
+	uint64_t mac = bench_rand(state);
+
+	memset(entry, 0, sizeof(*entry));
+	snprintf(entry->name, sizeof(entry->name), "node%zu.mesh.example", i);
+
+	/* the index keeps the addresses unique */
+	entry->mac[0] = 0x02;
+	entry->mac[1] = mac >> 8;
+	entry->mac[2] = i >> 24;
+	entry->mac[3] = i >> 16;
+	entry->mac[4] = i >> 8;
+	entry->mac[5] = i;
+}
+
+static int compare_name(void *data1, void *data2)
+{
+	return strncmp(data1, data2, NAME_KEY_LEN) == 0 ? 1 : 0;
+}
+
+static int choose_name(void *data, int32_t size)
+{
+	return hash_bytes(data, strnlen(data, NAME_KEY_LEN)) % size;
+}
+
+static int compare_mac(void *data1, void *data2)
+{
+	return memcmp(data1, data2, 6) == 0 ? 1 : 0;
+}
+
+static int choose_mac(void *data, int32_t size)
+{
+	return hash_bytes(data, 6) % size;
+}
+
+/* grow like bat-hosts did before the oahash */
+static int chain_grow(struct hashtable_t **hash)
+{
+	struct hashtable_t *swaphash;
+
+	if ((*hash)->elements * 4 <= (*hash)->size)
+		return 0;
+
+	swaphash = hash_resize(*hash, (*hash)->size * 2);
+	if (!swaphash)
+		return -ENOMEM;
+
+	*hash = swaphash;
+	return 0;
+}
+
+static int chain_run(struct entry *entries, struct entry *missing,
+		     const uint32_t *order, size_t num,
+		     struct bench_result *result, size_t key_offset,
+		     hashdata_compare_cb compare, hashdata_choose_cb choose)
+{
+	struct hash_it_t *hashit = NULL;
+	struct hashtable_t *hash;
+	struct entry *entry;
+	uintptr_t sum = 0;
+	double start;
+	size_t i;
+
+	hash = hash_new(64, compare, choose);
+	if (!hash)
+		return -ENOMEM;
+
+	start = bench_now();
+	for (i = 0; i < num; i++) {
+		if (hash_add(hash, (char *)&entries[i] + key_offset) < 0 ||
+		    chain_grow(&hash) < 0) {
+			hash_delete(hash, NULL);
+			return -ENOMEM;
+		}
+	}
+	result->insert = bench_now() - start;
+
+	start = bench_now();
+	for (i = 0; i < num; i++)
+		sum += (uintptr_t)hash_find(hash, (char *)&entries[order[i]] +
+						  key_offset);
+	result->find = bench_now() - start;
+
+	start = bench_now();
+	for (i = 0; i < num; i++)
+		sum += (uintptr_t)hash_find(hash, (char *)&missing[order[i]] +
+						  key_offset);
+	result->miss = bench_now() - start;
+
+	start = bench_now();
+	while ((hashit = hash_iterate(hash, hashit))) {
+		entry = (struct entry *)((char *)hashit->bucket->data -
+					 key_offset);
+		sum += entry->mac[5];
+	}
+	result->iterate = bench_now() - start;
+
+	start = bench_now();
+	hash = hash_resize(hash, hash->size * 4);
+	result->resize = bench_now() - start;
+	if (!hash)
+		return -ENOMEM;
+
+	bench_sink += sum;
+	hash_delete(hash, NULL);
+
+	return 0;
+}
+
+static int chain_name_run(struct entry *entries, struct entry *missing,
+			  const uint32_t *order, size_t num,
+			  struct bench_result *result)
+{
+	return chain_run(entries, missing, order, num, result,
+			 offsetof(struct entry, name), compare_name,
+			 choose_name);
+}
+
+static int chain_mac_run(struct entry *entries, struct entry *missing,
+			 const uint32_t *order, size_t num,
+			 struct bench_result *result)
+{
+	return chain_run(entries, missing, order, num, result,
+			 offsetof(struct entry, mac), compare_mac, choose_mac);
+}
+
+static int oahash_name_run(struct entry *entries, struct entry *missing,
+			   const uint32_t *order, size_t num,
+			   struct bench_result *result)
+{
+	struct oahash hash;
+	struct entry *entry;
+	uint32_t iter = 0;
+	uintptr_t sum = 0;
+	double start;
+	size_t i;
+
+	if (oahash_init(&hash, NAME_KEY_LEN, 0) < 0)
+		return -ENOMEM;
+
+	start = bench_now();
+	for (i = 0; i < num; i++) {
+		if (oahash_add(&hash, entries[i].name, &entries[i]) < 0) {
+			oahash_destroy(&hash, NULL);
+			return -ENOMEM;
+		}
+	}
+	result->insert = bench_now() - start;
+
+	start = bench_now();
+	for (i = 0; i < num; i++)
+		sum += (uintptr_t)oahash_find(&hash, entries[order[i]].name);
+	result->find = bench_now() - start;
+
+	start = bench_now();
+	for (i = 0; i < num; i++)
+		sum += (uintptr_t)oahash_find(&hash, missing[order[i]].name);
+	result->miss = bench_now() - start;
+
+	start = bench_now();
+	while ((entry = oahash_iterate(&hash, &iter)))
+		sum += entry->mac[5];
+	result->iterate = bench_now() - start;
+
+	start = bench_now();
+	if (oahash_resize(&hash, num * 4) < 0) {
+		oahash_destroy(&hash, NULL);
+		return -ENOMEM;
+	}
+	result->resize = bench_now() - start;
+
+	bench_sink += sum;
+	oahash_destroy(&hash, NULL);
+
+	return 0;
+}
+
+static int macmap_mac_run(struct entry *entries, struct entry *missing,
+			  const uint32_t *order, size_t num,
+			  struct bench_result *result)
+{
+	struct macmap map;
+	struct entry *entry;
+	uint32_t iter = 0;
+	uintptr_t sum = 0;
+	double start;
+	size_t i;
+
+	if (macmap_init(&map, 0) < 0)
+		return -ENOMEM;
+
+	start = bench_now();
+	for (i = 0; i < num; i++) {
+		if (macmap_add(&map, macmap_key(entries[i].mac),
+			       &entries[i]) < 0) {
+			macmap_destroy(&map, NULL);
+			return -ENOMEM;
+		}
+	}
+	result->insert = bench_now() - start;
+
+	start = bench_now();
+	for (i = 0; i < num; i++)
+		sum += (uintptr_t)macmap_find(&map,
+					      macmap_key(entries[order[i]].mac));
+	result->find = bench_now() - start;
+
+	start = bench_now();
+	for (i = 0; i < num; i++)
+		sum += (uintptr_t)macmap_find(&map,
+					      macmap_key(missing[order[i]].mac));
+	result->miss = bench_now() - start;
+
+	start = bench_now();
+	while ((entry = macmap_iterate(&map, &iter)))
+		sum += entry->mac[5];
+	result->iterate = bench_now() - start;
+
+	start = bench_now();
+	if (macmap_resize(&map, num * 4) < 0) {
+		macmap_destroy(&map, NULL);
+		return -ENOMEM;
+	}
+	result->resize = bench_now() - start;
+
+	bench_sink += sum;
+	macmap_destroy(&map, NULL);
+
+	return 0;
+}
+
+static const struct bench_impl bench_impls[] = {
+	{ .name = "hash.c name", .run = chain_name_run },
+	{ .name = "oahash name", .run = oahash_name_run },
+	{ .name = "hash.c mac", .run = chain_mac_run },
+	{ .name = "macmap mac", .run = macmap_mac_run },
+};
+
+static int bench_size(size_t num)
+{
+	struct bench_result result;
+	struct entry *entries;
+	struct entry *missing;
+	uint64_t state = 0x9e3779b97f4a7c15ULL;
+	uint32_t *order;
+	uint32_t tmp;
+	size_t i, j;
+	int ret = 0;
+
+	entries = malloc(num * sizeof(*entries));
+	missing = malloc(num * sizeof(*missing));
+	order = malloc(num * sizeof(*order));
+	if (!entries || !missing || !order) {
+		fprintf(stderr, "Error - could not allocate %zu entries\n", num);
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	for (i = 0; i < num; i++) {
+		bench_entry(&entries[i], &state, i);
+		bench_entry(&missing[i], &state, num + i);
+		order[i] = i;
+	}
+
+	/* look the entries up in a different order than they were added */
+	for (i = num - 1; i > 0; i--) {
+		j = bench_rand(&state) % (i + 1);
+		tmp = order[i];
+		order[i] = order[j];
+		order[j] = tmp;
+	}
+
+	for (i = 0; i < sizeof(bench_impls) / sizeof(bench_impls[0]); i++) {
+		ret = bench_impls[i].run(entries, missing, order, num, &result);
+		if (ret < 0) {
+			fprintf(stderr, "Error - %s failed for %zu entries\n",
+				bench_impls[i].name, num);
+			goto out;
+		}
+
+		printf("%8zu %-12s %9.1f %9.1f %9.1f %9.1f %11.3f\n", num,
+		       bench_impls[i].name, result.insert / num,
+		       result.find / num, result.miss / num,
+		       result.iterate / num, result.resize / 1e6);
+	}
+
+out:
+	free(order);
+	free(missing);
+	free(entries);
+
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	size_t max_entries = 1000000;
+	size_t num;
+
+	if (argc > 1)
+		max_entries = strtoul(argv[1], NULL, 10);
+
+	printf("%8s %-12s %9s %9s %9s %9s %11s\n", "entries", "table",
+	       "insert", "find", "miss", "iterate", "resize");
+	printf("%8s %-12s %9s %9s %9s %9s %11s\n", "", "", "ns/op", "ns/op",
+	       "ns/op", "ns/op", "ms");
+
+	for (num = 1000; num <= max_entries; num *= 10) {
+		if (bench_size(num) < 0)
+			return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,284 @@
+// SPDX-License-Identifier: GPL-2.0
+/* Copyright (C) B.A.T.M.A.N. contributors:
+ *
+ * License-Filename: LICENSES/preferred/GPL-2.0
+ */
+
+/* renders synthetic global translation table dumps of 10k and 100k rows
+ * with the printf() calls transglobal.c used before the output buffer and
+ * with the outbuf calls of transglobal_print(). Both are written to
+ * /dev/null. Before timing, both are rendered to memory and have to match
+ * byte for byte.
+ *
+ * usage: output_bench [rounds]
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "batadv_packet.h"
+#include "batman_adv.h"
+#include "main.h"
+#include "output.h"
+
+struct bench_row {
+	uint8_t addr[6];
+	uint8_t orig[6];
+	uint32_t crc32;
+	uint32_t flags;
+	int16_t vid;
+	uint8_t ttvn;
+	uint8_t last_ttvn;
+	bool best;
+};
+
+static const size_t bench_sizes[] = { 10000, 100000 };
+
+static double bench_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint64_t bench_rand(uint64_t *state)
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 7;
+	*state ^= *state << 17;
+
+	return *state;
+}
+
+static struct bench_row *bench_rows(size_t num)
+{
+	uint64_t state = 0x9e3779b97f4a7c15ULL;
+	struct bench_row *rows;
+	uint64_t rand;
+	size_t i;
+
+	rows = calloc(num, sizeof(*rows));
+	if (!rows)
+		return NULL;
+
+	for (i = 0; i < num; i++) {
+		rand = bench_rand(&state);
+
+		memcpy(rows[i].addr, &rand, sizeof(rows[i].addr));
+		rows[i].addr[0] &= 0xfe;
+		rows[i].orig[0] = 0x02;
+		rows[i].orig[5] = rand >> 48;
+		rows[i].crc32 = rand >> 16;
+		rows[i].flags = rand >> 56;
+		if (rand & 0x100)
+			rows[i].vid = BATADV_VLAN_HAS_TAG | (rand & 0x0fff);
+		rows[i].ttvn = rand >> 40;
+		rows[i].last_ttvn = rand >> 32;
+		rows[i].best = rand & 0x200;
+	}
+
+	return rows;
+}
+
+static void bench_flags(const struct bench_row *row, char *c, char *r,
+			char *w, char *i, char *t)
+{
+	*c = ' ', *r = '.', *w = '.', *i = '.', *t = '.';
+	if (row->best)
+		*c = '*';
+	if (row->flags & BATADV_TT_CLIENT_ROAM)
+		*r = 'R';
+	if (row->flags & BATADV_TT_CLIENT_WIFI)
+		*w = 'W';
+	if (row->flags & BATADV_TT_CLIENT_ISOLA)
+		*i = 'I';
+	if (row->flags & BATADV_TT_CLIENT_TEMP)
+		*t = 'T';
+}
+
+/* transglobal.c before the output buffer */
+static void bench_render_printf(FILE *fp, const struct bench_row *rows,
+				size_t num)
+{
+	const struct bench_row *row;
+	char c, r, w, i, t;
+	size_t n;
+
+	for (n = 0; n < num; n++) {
+		row = &rows[n];
+		bench_flags(row, &c, &r, &w, &i, &t);
+
+		fprintf(fp, " %c ", c);
+		fprintf(fp, "%02x:%02x:%02x:%02x:%02x:%02x ",
+			row->addr[0], row->addr[1], row->addr[2],
+			row->addr[3], row->addr[4], row->addr[5]);
+		fprintf(fp, "%4i [%c%c%c%c] (%3u) ",
+			BATADV_PRINT_VID(row->vid), r, w, i, t, row->ttvn);
+		fprintf(fp, "%02x:%02x:%02x:%02x:%02x:%02x ",
+			row->orig[0], row->orig[1], row->orig[2],
+			row->orig[3], row->orig[4], row->orig[5]);
+		fprintf(fp, "(%3u) (0x%.8x)\n", row->last_ttvn, row->crc32);
+	}
+}
+
+/* same calls as transglobal_print() */
+static void bench_render_outbuf(struct outbuf *ob, const struct bench_row *rows,
+				size_t num)
+{
+	const struct bench_row *row;
+	char c, r, w, i, t;
+	size_t n;
+
+	for (n = 0; n < num; n++) {
+		row = &rows[n];
+		bench_flags(row, &c, &r, &w, &i, &t);
+
+		outbuf_putc(ob, ' ');
+		outbuf_putc(ob, c);
+		outbuf_putc(ob, ' ');
+		outbuf_mac(ob, row->addr);
+		outbuf_putc(ob, ' ');
+
+		outbuf_int(ob, BATADV_PRINT_VID(row->vid), 4);
+		outbuf_str(ob, " [", 0);
+		outbuf_putc(ob, r);
+		outbuf_putc(ob, w);
+		outbuf_putc(ob, i);
+		outbuf_putc(ob, t);
+		outbuf_str(ob, "] (", 0);
+		outbuf_uint(ob, row->ttvn, 3);
+		outbuf_str(ob, ") ", 0);
+
+		outbuf_mac(ob, row->orig);
+		outbuf_putc(ob, ' ');
+
+		outbuf_putc(ob, '(');
+		outbuf_uint(ob, row->last_ttvn, 3);
+		outbuf_str(ob, ") (0x", 0);
+		outbuf_hex(ob, row->crc32, 8);
+		outbuf_str(ob, ")\n", 0);
+	}
+}
+
+static int bench_compare(const struct bench_row *rows, size_t num)
+{
+	struct outbuf ob;
+	size_t len = 0;
+	char *data;
+	FILE *fp;
+	int ret = 0;
+
+	fp = open_memstream(&data, &len);
+	if (!fp)
+		return -ENOMEM;
+
+	bench_render_printf(fp, rows, num);
+	fclose(fp);
+
+	if (outbuf_init(&ob, NULL) < 0) {
+		free(data);
+		return -ENOMEM;
+	}
+
+	bench_render_outbuf(&ob, rows, num);
+
+	if (ob.error || ob.len != len || memcmp(ob.data, data, len) != 0) {
+		fprintf(stderr, "Error - outbuf output differs from printf for %zu rows\n",
+			num);
+		ret = -EINVAL;
+	}
+
+	outbuf_free(&ob);
+	free(data);
+
+	return ret;
+}
+
+static int bench_size(FILE *null, size_t num, unsigned int rounds)
+{
+	double printf_time = 0, outbuf_time = 0;
+	struct bench_row *rows;
+	struct outbuf ob;
+	unsigned int k;
+	double start;
+	int ret;
+
+	rows = bench_rows(num);
+	if (!rows) {
+		fprintf(stderr, "Error - could not allocate %zu rows\n", num);
+		return -ENOMEM;
+	}
+
+	ret = bench_compare(rows, num);
+	if (ret < 0)
+		goto out;
+
+	for (k = 0; k < rounds; k++) {
+		start = bench_now();
+		bench_render_printf(null, rows, num);
+		fflush(null);
+		printf_time += bench_now() - start;
+
+		start = bench_now();
+		if (outbuf_init(&ob, null) < 0) {
+			ret = -ENOMEM;
+			goto out;
+		}
+
+		bench_render_outbuf(&ob, rows, num);
+		outbuf_flush(&ob);
+		outbuf_free(&ob);
+		fflush(null);
+		outbuf_time += bench_now() - start;
+	}
+
+	printf("%8zu %11.3f %11.3f %9.1f %9.1f\n", num,
+	       printf_time / rounds / 1e6, outbuf_time / rounds / 1e6,
+	       printf_time / rounds / num, outbuf_time / rounds / num);
+
+out:
+	free(rows);
+
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int rounds = 10;
+	FILE *null;
+	size_t i;
+
+	if (argc > 1)
+		rounds = strtoul(argv[1], NULL, 10);
+
+	if (rounds == 0)
+		rounds = 1;
+
+	null = fopen("/dev/null", "w");
+	if (!null) {
+		perror("Error - could not open /dev/null");
+		return EXIT_FAILURE;
+	}
+
+	printf("%8s %11s %11s %9s %9s\n", "rows", "printf", "outbuf",
+	       "printf", "outbuf");
+	printf("%8s %11s %11s %9s %9s\n", "", "ms", "ms", "ns/row", "ns/row");
+
+	for (i = 0; i < sizeof(bench_sizes) / sizeof(bench_sizes[0]); i++) {
+		if (bench_size(null, bench_sizes[i], rounds) < 0) {
+			fclose(null);
+			return EXIT_FAILURE;
+		}
+	}
+
+	fclose(null);
+
+	return EXIT_SUCCESS;
+}
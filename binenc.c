@@ -0,0 +1,162 @@
+// SPDX-License-Identifier: GPL-2.0
+/* Copyright (C) B.A.T.M.A.N. contributors:
+ *
+ * License-Filename: LICENSES/preferred/GPL-2.0
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "binenc.h"
+#include "output.h"
+
+/* CBOR (RFC 8949) major types */
+#define CBOR_UINT	0
+#define CBOR_NEGINT	1
+#define CBOR_BYTES	2
+#define CBOR_TEXT	3
+#define CBOR_ARRAY	4
+#define CBOR_MAP	5
+#define CBOR_FALSE	0xf4
+#define CBOR_TRUE	0xf5
+
+/* write the type byte followed by the lowest bytes of val in network order */
+static void binenc_put(struct binenc *enc, uint8_t type, uint64_t val,
+		       unsigned int bytes)
+{
+	uint8_t buf[9];
+	unsigned int i;
+
+	buf[0] = type;
+	for (i = 0; i < bytes; i++)
+		buf[bytes - i] = val >> (8 * i);
+
+	outbuf_write(enc->out, buf, bytes + 1);
+}
+
+/* CBOR head with the argument in its shortest form */
+static void binenc_cbor_head(struct binenc *enc, uint8_t major, uint64_t val)
+{
+	major <<= 5;
+
+	if (val < 24)
+		binenc_put(enc, major | val, 0, 0);
+	else if (val <= UINT8_MAX)
+		binenc_put(enc, major | 24, val, 1);
+	else if (val <= UINT16_MAX)
+		binenc_put(enc, major | 25, val, 2);
+	else if (val <= UINT32_MAX)
+		binenc_put(enc, major | 26, val, 4);
+	else
+		binenc_put(enc, major | 27, val, 8);
+}
+
+/* MessagePack types with a 8/16/32 bit length (type_8 + 0, 1, 2) */
+static void binenc_msgpack_len(struct binenc *enc, uint8_t type_8,
+			       size_t len)
+{
+	if (len <= UINT8_MAX)
+		binenc_put(enc, type_8, len, 1);
+	else if (len <= UINT16_MAX)
+		binenc_put(enc, type_8 + 1, len, 2);
+	else
+		binenc_put(enc, type_8 + 2, len, 4);
+}
+
+void binenc_uint(struct binenc *enc, uint64_t val)
+{
+	if (enc->format == BINENC_CBOR) {
+		binenc_cbor_head(enc, CBOR_UINT, val);
+		return;
+	}
+
+	if (val < 0x80)
+		binenc_put(enc, val, 0, 0);
+	else if (val <= UINT8_MAX)
+		binenc_put(enc, 0xcc, val, 1);
+	else if (val <= UINT16_MAX)
+		binenc_put(enc, 0xcd, val, 2);
+	else if (val <= UINT32_MAX)
+		binenc_put(enc, 0xce, val, 4);
+	else
+		binenc_put(enc, 0xcf, val, 8);
+}
+
+void binenc_int(struct binenc *enc, int64_t val)
+{
+	if (val >= 0) {
+		binenc_uint(enc, val);
+		return;
+	}
+
+	if (enc->format == BINENC_CBOR) {
+		binenc_cbor_head(enc, CBOR_NEGINT, -(val + 1));
+		return;
+	}
+
+	if (val >= -32)
+		binenc_put(enc, val & 0xff, 0, 0);
+	else if (val >= INT8_MIN)
+		binenc_put(enc, 0xd0, val, 1);
+	else if (val >= INT16_MIN)
+		binenc_put(enc, 0xd1, val, 2);
+	else if (val >= INT32_MIN)
+		binenc_put(enc, 0xd2, val, 4);
+	else
+		binenc_put(enc, 0xd3, val, 8);
+}
+
+void binenc_bool(struct binenc *enc, bool val)
+{
+	if (enc->format == BINENC_CBOR)
+		outbuf_putc(enc->out, val ? CBOR_TRUE : CBOR_FALSE);
+	else
+		outbuf_putc(enc->out, val ? 0xc3 : 0xc2);
+}
+
+void binenc_str(struct binenc *enc, const char *str, size_t len)
+{
+	if (enc->format == BINENC_CBOR)
+		binenc_cbor_head(enc, CBOR_TEXT, len);
+	else if (len < 32)
+		binenc_put(enc, 0xa0 | len, 0, 0);
+	else
+		binenc_msgpack_len(enc, 0xd9, len);
+
+	outbuf_write(enc->out, str, len);
+}
+
+void binenc_bytes(struct binenc *enc, const void *data, size_t len)
+{
+	if (enc->format == BINENC_CBOR)
+		binenc_cbor_head(enc, CBOR_BYTES, len);
+	else
+		binenc_msgpack_len(enc, 0xc4, len);
+
+	outbuf_write(enc->out, data, len);
+}
+
+void binenc_array(struct binenc *enc, size_t count)
+{
+	if (enc->format == BINENC_CBOR)
+		binenc_cbor_head(enc, CBOR_ARRAY, count);
+	else if (count < 16)
+		binenc_put(enc, 0x90 | count, 0, 0);
+	else if (count <= UINT16_MAX)
+		binenc_put(enc, 0xdc, count, 2);
+	else
+		binenc_put(enc, 0xdd, count, 4);
+}
+
+void binenc_map(struct binenc *enc, size_t count)
+{
+	if (enc->format == BINENC_CBOR)
+		binenc_cbor_head(enc, CBOR_MAP, count);
+	else if (count < 16)
+		binenc_put(enc, 0x80 | count, 0, 0);
+	else if (count <= UINT16_MAX)
+		binenc_put(enc, 0xde, count, 2);
+	else
+		binenc_put(enc, 0xdf, count, 4);
+}
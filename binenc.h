@@ -0,0 +1,34 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/* Copyright (C) B.A.T.M.A.N. contributors:
+ *
+ * License-Filename: LICENSES/preferred/GPL-2.0
+ */
+
+#ifndef _BATCTL_BINENC_H
+#define _BATCTL_BINENC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct outbuf;
+
+enum binenc_format {
+	BINENC_CBOR,
+	BINENC_MSGPACK,
+};
+
+struct binenc {
+	enum binenc_format format;
+	struct outbuf *out;
+};
+
+void binenc_uint(struct binenc *enc, uint64_t val);
+void binenc_int(struct binenc *enc, int64_t val);
+void binenc_bool(struct binenc *enc, bool val);
+void binenc_str(struct binenc *enc, const char *str, size_t len);
+void binenc_bytes(struct binenc *enc, const void *data, size_t len);
+void binenc_array(struct binenc *enc, size_t count);
+void binenc_map(struct binenc *enc, size_t count);
+
+#endif /* _BATCTL_BINENC_H */
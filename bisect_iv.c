@@ -15,13 +15,16 @@
 #include <stddef.h>
 #include <netinet/ether.h>
 
+#include "allocate.h"
 #include "bisect_iv.h"
 #include "bat-hosts.h"
-#include "hash.h"
 #include "main.h"
 #include "functions.h"
+#include "oahash.h"
 
-static struct hashtable_t *node_hash = NULL;
+static struct oahash node_hash;
+/* nodes and everything hanging off them, freed at once after the analysis */
+static struct arena node_arena;
 static struct bat_node *curr_bat_node = NULL;
 
 static void bisect_iv_usage(void)
@@ -42,25 +45,6 @@ static int compare_name(void *data1, void *data2)
 	return (memcmp(data1, data2, NAME_LEN) == 0 ? 1 : 0);
 }
 
-static int choose_name(void *data, int32_t size)
-{
-	unsigned char *key= data;
-	uint32_t hash = 0, m_size = NAME_LEN - 1;
-	size_t i;
-
-	for (i = 0; i < m_size; i++) {
-		hash += key[i];
-		hash += (hash << 10);
-		hash ^= (hash >> 6);
-	}
-
-	hash += (hash << 3);
-	hash ^= (hash >> 11);
-	hash += (hash << 15);
-
-	return (hash % size);
-}
-
 static struct bat_node *node_get(char *name)
 {
 	struct bat_node *bat_node;
@@ -68,11 +52,11 @@ static struct bat_node *node_get(char *name)
 	if (!name)
 		return NULL;
 
-	bat_node = (struct bat_node *)hash_find(node_hash, name);
+	bat_node = oahash_find(&node_hash, name);
 	if (bat_node)
 		goto out;
 
-	bat_node = malloc(sizeof(struct bat_node));
+	bat_node = arena_alloc(&node_arena, sizeof(struct bat_node));
 	if (!bat_node) {
 		fprintf(stderr, "Could not allocate memory for data structure (out of mem?) - skipping");
 		return NULL;
@@ -84,7 +68,10 @@ static struct bat_node *node_get(char *name)
 	INIT_LIST_HEAD(&bat_node->rt_table_list);
 	memset(bat_node->loop_magic, 0, sizeof(bat_node->loop_magic));
 	memset(bat_node->loop_magic2, 0, sizeof(bat_node->loop_magic2));
-	hash_add(node_hash, bat_node);
+	if (oahash_add(&node_hash, bat_node->name, bat_node) < 0) {
+		fprintf(stderr, "Could not add node to hash table (out of mem?) - skipping");
+		return NULL;
+	}
 
 out:
 	return bat_node;
@@ -94,7 +81,7 @@ static struct orig_event *orig_event_new(struct bat_node *bat_node, struct bat_n
 {
 	struct orig_event *orig_event;
 
-	orig_event = malloc(sizeof(struct orig_event));
+	orig_event = arena_alloc(&node_arena, sizeof(struct orig_event));
 	if (!orig_event) {
 		fprintf(stderr, "Could not allocate memory for orig event structure (out of mem?) - skipping");
 		return NULL;
@@ -143,39 +130,6 @@ static struct orig_event *orig_event_get_by_ptr(struct bat_node *bat_node, struc
 	return orig_event_new(bat_node, orig_node);
 }
 
-static void node_free(void *data)
-{
-	struct orig_event *orig_event, *orig_event_tmp;
-	struct seqno_event *seqno_event, *seqno_event_tmp;
-	struct rt_table *rt_table, *rt_table_tmp;
-	struct rt_hist *rt_hist, *rt_hist_tmp;
-	struct bat_node *bat_node = (struct bat_node *)data;
-
-	list_for_each_entry_safe(orig_event, orig_event_tmp, &bat_node->orig_event_list, list) {
-		list_for_each_entry_safe(seqno_event, seqno_event_tmp, &orig_event->event_list, list) {
-			list_del(&seqno_event->list);
-			free(seqno_event);
-		}
-
-		list_for_each_entry_safe(rt_hist, rt_hist_tmp, &orig_event->rt_hist_list, list) {
-			list_del(&rt_hist->list);
-			free(rt_hist);
-		}
-
-		list_del(&orig_event->list);
-		free(orig_event);
-	}
-
-	list_for_each_entry_safe(rt_table, rt_table_tmp, &bat_node->rt_table_list, list) {
-		list_del(&rt_table->list);
-
-		free(rt_table->entries);
-		free(rt_table);
-	}
-
-	free(bat_node);
-}
-
 static int routing_table_new(char *orig, char *next_hop, char *old_next_hop, char rt_flag)
 {
 	struct bat_node *next_hop_node;
@@ -223,16 +177,16 @@ static int routing_table_new(char *orig, char *next_hop, char *old_next_hop, cha
 		goto err;
 	}
 
-	rt_table = malloc(sizeof(struct rt_table));
+	rt_table = arena_alloc(&node_arena, sizeof(struct rt_table));
 	if (!rt_table) {
 		fprintf(stderr, "Could not allocate memory for routing table (out of mem?) - skipping");
 		goto err;
 	}
 
-	rt_hist = malloc(sizeof(struct rt_hist));
+	rt_hist = arena_alloc(&node_arena, sizeof(struct rt_hist));
 	if (!rt_hist) {
 		fprintf(stderr, "Could not allocate memory for routing history (out of mem?) - skipping");
-		goto table_free;
+		goto err;
 	}
 
 	rt_table->num_entries = 1;
@@ -282,17 +236,17 @@ static int routing_table_new(char *orig, char *next_hop, char *old_next_hop, cha
 				fprintf(stderr,
 				        "Found a delete entry of orig '%s' but no existing record - skipping",
 				        orig);
-				goto rt_hist_free;
+				goto err;
 			}
 
 			/**
 			 * we need to create a special seqno event as a timer instead
 			 * of an OGM triggered that event
 			 */
-			seqno_event = malloc(sizeof(struct seqno_event));
+			seqno_event = arena_alloc(&node_arena, sizeof(struct seqno_event));
 			if (!seqno_event) {
 				fprintf(stderr, "Could not allocate memory for delete seqno event (out of mem?) - skipping");
-				goto rt_hist_free;
+				goto err;
 			}
 
 			seqno_event->orig = node_get(orig);
@@ -307,13 +261,14 @@ static int routing_table_new(char *orig, char *next_hop, char *old_next_hop, cha
 		break;
 	default:
 		fprintf(stderr, "Unknown rt_flag received: %i - skipping", rt_flag);
-		goto rt_hist_free;
+		goto err;
 	}
 
-	rt_table->entries = malloc(sizeof(struct rt_entry) * rt_table->num_entries);
+	rt_table->entries = arena_alloc(&node_arena,
+				       sizeof(struct rt_entry) * rt_table->num_entries);
 	if (!rt_table->entries) {
 		fprintf(stderr, "Could not allocate memory for routing table entries (out of mem?) - skipping");
-		goto rt_hist_free;
+		goto err;
 	}
 
 	if (prev_rt_table) {
@@ -363,11 +318,8 @@ static int routing_table_new(char *orig, char *next_hop, char *old_next_hop, cha
 
 	return 1;
 
-rt_hist_free:
-	free(rt_hist);
-table_free:
-	free(rt_table);
 err:
+	/* the unused objects stay in node_arena */
 	return 0;
 }
 
@@ -427,7 +379,7 @@ static int seqno_event_new(char *iface_addr, char *orig, char *prev_sender, char
 	if (!orig_event)
 		goto err;
 
-	seqno_event = malloc(sizeof(struct seqno_event));
+	seqno_event = arena_alloc(&node_arena, sizeof(struct seqno_event));
 	if (!seqno_event) {
 		fprintf(stderr, "Could not allocate memory for seqno event (out of mem?) - skipping");
 		goto err;
@@ -808,8 +760,8 @@ static void loop_detection(char *loop_orig, long long seqno_min, long long seqno
 {
 	struct bat_node *bat_node;
 	struct orig_event *orig_event;
-	struct hash_it_t *hashit = NULL;
 	struct rt_hist *rt_hist, *prev_rt_hist;
+	uint32_t iter = 0;
 	long long last_seqno = -1, seqno_count = 0;
 	int res;
 	char check_orig[NAME_LEN];
@@ -835,9 +787,7 @@ static void loop_detection(char *loop_orig, long long seqno_min, long long seqno
 
 	printf("\n");
 
-	while (NULL != (hashit = hash_iterate(node_hash, hashit))) {
-		bat_node = hashit->bucket->data;
-
+	while ((bat_node = oahash_iterate(&node_hash, &iter))) {
 		if (!compare_name(loop_orig, check_orig) &&
 		    !compare_name(loop_orig, bat_node->name))
 			continue;
@@ -1241,8 +1191,8 @@ static void trace_seqnos(char *trace_orig, long long seqno_min, long long seqno_
 	struct bat_node *bat_node;
 	struct orig_event *orig_event;
 	struct seqno_event *seqno_event;
-	struct hash_it_t *hashit = NULL;
 	struct list_head trace_list;
+	uint32_t iter = 0;
 	struct seqno_trace *seqno_trace, *seqno_trace_tmp;
 	char check_orig[NAME_LEN], print_trace;
 	int res;
@@ -1251,9 +1201,7 @@ static void trace_seqnos(char *trace_orig, long long seqno_min, long long seqno_
 	memset(check_orig, 0, NAME_LEN);
 	INIT_LIST_HEAD(&trace_list);
 
-	while (NULL != (hashit = hash_iterate(node_hash, hashit))) {
-		bat_node = hashit->bucket->data;
-
+	while ((bat_node = oahash_iterate(&node_hash, &iter))) {
 		list_for_each_entry(orig_event, &bat_node->orig_event_list, list) {
 
 			/* we might have no log file from this node */
@@ -1283,10 +1231,8 @@ static void trace_seqnos(char *trace_orig, long long seqno_min, long long seqno_
 
 				res = seqno_trace_add(&trace_list, bat_node, seqno_event, print_trace);
 
-				if (res < 1) {
-					hash_iterate_free(hashit);
+				if (res < 1)
 					goto out;
-				}
 			}
 		}
 	}
@@ -1498,13 +1444,14 @@ static int bisect_iv(struct state *state __maybe_unused, int argc, char **argv)
 		goto err;
 	}
 
-	node_hash = hash_new(64, compare_name, choose_name);
+	arena_init(&node_arena, "bisect_iv", 0);
 
-	if (!node_hash) {
+	if (oahash_init(&node_hash, NAME_LEN, 64) < 0) {
 		fprintf(stderr, "Error - could not create node hash table\n");
 		goto err;
 	}
 
+	/* get_orig_addr() also resolves names with -n */
 	bat_hosts_init(read_opt);
 	num_parsed_files = 0;
 
@@ -1575,8 +1522,8 @@ static int bisect_iv(struct state *state __maybe_unused, int argc, char **argv)
 	ret = EXIT_SUCCESS;
 
 err:
-	if (node_hash)
-		hash_delete(node_hash, node_free);
+	oahash_destroy(&node_hash, NULL);
+	arena_release(&node_arena);
 	bat_hosts_free();
 	return ret;
 }
@@ -21,6 +21,9 @@
 #include "functions.h"
 #include "main.h"
 #include "netlink.h"
+#include "output.h"
+#include "tablefmt.h"
+#include "tablegroup.h"
 
 static const int bla_claim_mandatory[] = {
 	BATADV_ATTR_BLA_ADDRESS,
@@ -29,41 +32,32 @@ static const int bla_claim_mandatory[] = {
 	BATADV_ATTR_BLA_CRC,
 };
 
-static int bla_claim_callback(struct nl_msg *msg, void *arg)
+static const struct table_column bla_claim_columns[] = {
+	{ "bla_address", BATADV_ATTR_BLA_ADDRESS, table_column_mac },
+	{ "bla_vid", BATADV_ATTR_BLA_VID, table_column_vid },
+	{ "bla_backbone", BATADV_ATTR_BLA_BACKBONE, table_column_mac },
+	{ "bla_own", BATADV_ATTR_BLA_OWN, table_column_flag },
+	{ "bla_crc", BATADV_ATTR_BLA_CRC, table_column_u16 },
+};
+
+static const struct table_group_key bla_claim_group_keys[] = {
+	{ "backbone", "Originator", BATADV_ATTR_BLA_BACKBONE, TABLE_GROUP_MAC },
+	{ "vid", "VID", BATADV_ATTR_BLA_VID, TABLE_GROUP_VID },
+};
+
+static const struct table_group_flag bla_claim_group_flags[] = {
+	{ "own", BATADV_ATTR_BLA_OWN, 0 },
+};
+
+static void bla_claim_print(struct nlattr *attrs[], struct print_opts *opts)
 {
-	struct nlattr *attrs[BATADV_ATTR_MAX+1];
-	struct nlmsghdr *nlh = nlmsg_hdr(msg);
-	struct print_opts *opts = arg;
 	struct bat_host *bat_host;
-	struct genlmsghdr *ghdr;
 	uint16_t backbone_crc;
 	uint8_t *backbone;
 	uint8_t *client;
 	uint16_t vid;
 	char c = ' ';
 
-	if (!genlmsg_valid_hdr(nlh, 0)) {
-		fputs("Received invalid data from kernel.\n", stderr);
-		exit(1);
-	}
-
-	ghdr = nlmsg_data(nlh);
-
-	if (ghdr->cmd != BATADV_CMD_GET_BLA_CLAIM)
-		return NL_OK;
-
-	if (nla_parse(attrs, BATADV_ATTR_MAX, genlmsg_attrdata(ghdr, 0),
-		      genlmsg_len(ghdr), batadv_netlink_policy)) {
-		fputs("Received invalid data from kernel.\n", stderr);
-		exit(1);
-	}
-
-	if (missing_mandatory_attrs(attrs, bla_claim_mandatory,
-				       ARRAY_SIZE(bla_claim_mandatory))) {
-		fputs("Missing attributes from kernel\n", stderr);
-		exit(1);
-	}
-
 	if (attrs[BATADV_ATTR_BLA_OWN])
 		c = '*';
 
@@ -74,40 +68,55 @@ static int bla_claim_callback(struct nl_msg *msg, void *arg)
 
 	bat_host = bat_hosts_find_by_mac((char *)client);
 	if (!(opts->read_opt & USE_BAT_HOSTS) || !bat_host)
-		printf("%02x:%02x:%02x:%02x:%02x:%02x ",
-		       client[0], client[1], client[2],
-		       client[3], client[4], client[5]);
+		outbuf_mac(opts->out, client);
 	else
-		printf("%17s ", bat_host->name);
+		outbuf_str(opts->out, bat_host->name, 17);
+	outbuf_putc(opts->out, ' ');
 
-	printf("on %5d by ", BATADV_PRINT_VID(vid));
+	outbuf_str(opts->out, "on ", 0);
+	outbuf_int(opts->out, BATADV_PRINT_VID(vid), 5);
+	outbuf_str(opts->out, " by ", 0);
 
 	bat_host = bat_hosts_find_by_mac((char *)backbone);
 	if (!(opts->read_opt & USE_BAT_HOSTS) || !bat_host)
-		printf("%02x:%02x:%02x:%02x:%02x:%02x ",
-		       backbone[0], backbone[1], backbone[2],
-		       backbone[3], backbone[4], backbone[5]);
+		outbuf_mac(opts->out, backbone);
 	else
-		printf("%17s ", bat_host->name);
-
-	printf("[%c] (0x%04x)\n", c, backbone_crc);
-
-	return NL_OK;
+		outbuf_str(opts->out, bat_host->name, 17);
+	outbuf_putc(opts->out, ' ');
+
+	outbuf_putc(opts->out, '[');
+	outbuf_putc(opts->out, c);
+	outbuf_str(opts->out, "] (0x", 0);
+	outbuf_hex(opts->out, backbone_crc, 4);
+	outbuf_str(opts->out, ")\n", 0);
 }
 
+static const struct table_rows bla_claim_rows = {
+	.mandatory = bla_claim_mandatory,
+	.num_mandatory = ARRAY_SIZE(bla_claim_mandatory),
+	.print = bla_claim_print,
+};
+
 static int netlink_print_bla_claim(struct state *state, char *orig_iface,
 				   int read_opts, float orig_timeout,
-				   float watch_interval)
+				   float watch_interval,
+				   const struct table_opts *table)
 {
 	return netlink_print_common(state, orig_iface, read_opts,
 				    orig_timeout, watch_interval,
 				    "Client               VID      Originator        [o] (CRC   )\n",
 				    BATADV_CMD_GET_BLA_CLAIM,
-				    bla_claim_callback);
+				    &bla_claim_rows, table);
 }
 
 static struct debug_table_data batctl_debug_table_claimtable = {
 	.netlink_fn = netlink_print_bla_claim,
+	.columns = bla_claim_columns,
+	.num_columns = ARRAY_SIZE(bla_claim_columns),
+	.group_keys = bla_claim_group_keys,
+	.num_group_keys = ARRAY_SIZE(bla_claim_group_keys),
+	.group_flags = bla_claim_group_flags,
+	.num_group_flags = ARRAY_SIZE(bla_claim_group_flags),
 };
 
 COMMAND_NAMED(DEBUGTABLE, claimtable, "cl", handle_debug_table,
@@ -24,6 +24,9 @@
 #include "functions.h"
 #include "main.h"
 #include "netlink.h"
+#include "output.h"
+#include "tablefmt.h"
+#include "tablegroup.h"
 
 static const int dat_cache_mandatory[] = {
 	BATADV_ATTR_DAT_CACHE_IP4ADDRESS,
@@ -32,40 +35,44 @@ static const int dat_cache_mandatory[] = {
 	BATADV_ATTR_LAST_SEEN_MSECS,
 };
 
-static int dat_cache_callback(struct nl_msg *msg, void *arg)
+static const struct table_column dat_cache_columns[] = {
+	{ "dat_cache_ip4address", BATADV_ATTR_DAT_CACHE_IP4ADDRESS, table_column_ipv4 },
+	{ "dat_cache_hwaddress", BATADV_ATTR_DAT_CACHE_HWADDRESS, table_column_mac },
+	{ "dat_cache_vid", BATADV_ATTR_DAT_CACHE_VID, table_column_vid },
+	{ "last_seen_msecs", BATADV_ATTR_LAST_SEEN_MSECS, table_column_u32 },
+};
+
+static const struct table_group_key dat_cache_group_keys[] = {
+	{ "hwaddress", "MAC", BATADV_ATTR_DAT_CACHE_HWADDRESS, TABLE_GROUP_MAC },
+	{ "vid", "VID", BATADV_ATTR_DAT_CACHE_VID, TABLE_GROUP_VID },
+};
+
+static bool dat_cache_match(struct nlattr *attrs[],
+			    const struct print_opts *opts)
 {
-	int last_seen_msecs, last_seen_secs, last_seen_mins;
-	struct nlattr *attrs[BATADV_ATTR_MAX+1];
-	struct nlmsghdr *nlh = nlmsg_hdr(msg);
-	struct print_opts *opts = arg;
-	struct bat_host *bat_host;
-	struct genlmsghdr *ghdr;
 	struct in_addr in_addr;
-	uint8_t *hwaddr;
-	int16_t vid;
 	char *addr;
 
-	if (!genlmsg_valid_hdr(nlh, 0)) {
-		fputs("Received invalid data from kernel.\n", stderr);
-		exit(1);
-	}
+	in_addr.s_addr = nla_get_u32(attrs[BATADV_ATTR_DAT_CACHE_IP4ADDRESS]);
+	addr = inet_ntoa(in_addr);
 
-	ghdr = nlmsg_data(nlh);
+	if (opts->read_opt & MULTICAST_ONLY && !(addr[0] & 0x01))
+		return false;
 
-	if (ghdr->cmd != BATADV_CMD_GET_DAT_CACHE)
-		return NL_OK;
+	if (opts->read_opt & UNICAST_ONLY && (addr[0] & 0x01))
+		return false;
 
-	if (nla_parse(attrs, BATADV_ATTR_MAX, genlmsg_attrdata(ghdr, 0),
-		      genlmsg_len(ghdr), batadv_netlink_policy)) {
-		fputs("Received invalid data from kernel.\n", stderr);
-		exit(1);
-	}
+	return true;
+}
 
-	if (missing_mandatory_attrs(attrs, dat_cache_mandatory,
-				    ARRAY_SIZE(dat_cache_mandatory))) {
-		fputs("Missing attributes from kernel\n", stderr);
-		exit(1);
-	}
+static void dat_cache_print(struct nlattr *attrs[], struct print_opts *opts)
+{
+	int last_seen_msecs, last_seen_secs, last_seen_mins;
+	struct bat_host *bat_host;
+	struct in_addr in_addr;
+	uint8_t *hwaddr;
+	int16_t vid;
+	char *addr;
 
 	in_addr.s_addr = nla_get_u32(attrs[BATADV_ATTR_DAT_CACHE_IP4ADDRESS]);
 	addr = inet_ntoa(in_addr);
@@ -77,31 +84,36 @@ static int dat_cache_callback(struct nl_msg *msg, void *arg)
 	last_seen_msecs = last_seen_msecs % 60000;
 	last_seen_secs = last_seen_msecs / 1000;
 
-	if (opts->read_opt & MULTICAST_ONLY && !(addr[0] & 0x01))
-		return NL_OK;
-
-	if (opts->read_opt & UNICAST_ONLY && (addr[0] & 0x01))
-		return NL_OK;
-
-	printf(" * %15s ", addr);
+	outbuf_str(opts->out, " * ", 0);
+	outbuf_str(opts->out, addr, 15);
+	outbuf_putc(opts->out, ' ');
 
 	bat_host = bat_hosts_find_by_mac((char *)hwaddr);
 	if (!(opts->read_opt & USE_BAT_HOSTS) || !bat_host)
-		printf("%02x:%02x:%02x:%02x:%02x:%02x ",
-		       hwaddr[0], hwaddr[1], hwaddr[2],
-		       hwaddr[3], hwaddr[4], hwaddr[5]);
+		outbuf_mac(opts->out, hwaddr);
 	else
-		printf("%17s ", bat_host->name);
-
-	printf("%4i %6i:%02i\n",
-	       BATADV_PRINT_VID(vid), last_seen_mins, last_seen_secs);
-
-	return NL_OK;
+		outbuf_str(opts->out, bat_host->name, 17);
+	outbuf_putc(opts->out, ' ');
+
+	outbuf_int(opts->out, BATADV_PRINT_VID(vid), 4);
+	outbuf_putc(opts->out, ' ');
+	outbuf_int(opts->out, last_seen_mins, 6);
+	outbuf_putc(opts->out, ':');
+	outbuf_uint_zero(opts->out, last_seen_secs, 2);
+	outbuf_putc(opts->out, '\n');
 }
 
+static const struct table_rows dat_cache_rows = {
+	.mandatory = dat_cache_mandatory,
+	.num_mandatory = ARRAY_SIZE(dat_cache_mandatory),
+	.match = dat_cache_match,
+	.print = dat_cache_print,
+};
+
 static int netlink_print_dat_cache(struct state *state, char *orig_iface,
 				   int read_opts, float orig_timeout,
-				   float watch_interval)
+				   float watch_interval,
+				   const struct table_opts *table)
 {
 	char *header;
 	int ret;
@@ -116,7 +128,7 @@ static int netlink_print_dat_cache(struct state *state, char *orig_iface,
 	ret = netlink_print_common(state, orig_iface, read_opts,
 				   orig_timeout, watch_interval, header,
 				   BATADV_CMD_GET_DAT_CACHE,
-				   dat_cache_callback);
+				   &dat_cache_rows, table);
 
 	free(header);
 	return ret;
@@ -124,6 +136,10 @@ static int netlink_print_dat_cache(struct state *state, char *orig_iface,
 
 static struct debug_table_data batctl_debug_table_dat_cache = {
 	.netlink_fn = netlink_print_dat_cache,
+	.columns = dat_cache_columns,
+	.num_columns = ARRAY_SIZE(dat_cache_columns),
+	.group_keys = dat_cache_group_keys,
+	.num_group_keys = ARRAY_SIZE(dat_cache_group_keys),
 };
 
 COMMAND_NAMED(DEBUGTABLE, dat_cache, "dc", handle_debug_table,
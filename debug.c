@@ -8,8 +8,10 @@
 
 
 #include <unistd.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <errno.h>
 
 #include "debug.h"
@@ -20,6 +22,7 @@
 static void debug_table_usage(struct state *state)
 {
 	struct debug_table_data *debug_table = state->cmd->arg;
+	size_t i;
 
 	fprintf(stderr, "Usage: batctl [options] %s|%s [parameters]\n",
 		state->cmd->name, state->cmd->abbr);
@@ -28,6 +31,30 @@ static void debug_table_usage(struct state *state)
 	fprintf(stderr, " \t -n don't replace mac addresses with bat-host names\n");
 	fprintf(stderr, " \t -H don't show the header\n");
 	fprintf(stderr, " \t -w [interval] watch mode - refresh the table continuously\n");
+	fprintf(stderr, " \t -d watch mode - only redraw changed rows\n");
+	fprintf(stderr, " \t -l watch mode - only print added (+), changed (*) and removed (-) rows\n");
+	fprintf(stderr, " \t -F expr only print rows matching expr, e.g. 'vid==10 && orig==aa:bb:*'\n");
+
+	if (debug_table->columns) {
+		fprintf(stderr, " \t -o csv|tsv print the selected columns as comma/tab separated values\n");
+		fprintf(stderr, " \t -c col1,col2 select the columns for -o (default: all)\n");
+	}
+
+	if (debug_table->sort_keys) {
+		fprintf(stderr, " \t -s key sort the rows by key:");
+		for (i = 0; i < debug_table->num_sort_keys; i++)
+			fprintf(stderr, " %s", debug_table->sort_keys[i].name);
+		fprintf(stderr, "\n");
+		fprintf(stderr, " \t -N count only print the first count rows of the sorted table\n");
+		fprintf(stderr, " \t -r reverse the sort order\n");
+	}
+
+	if (debug_table->group_keys) {
+		fprintf(stderr, " \t -g key print the number of rows per key:");
+		for (i = 0; i < debug_table->num_group_keys; i++)
+			fprintf(stderr, " %s", debug_table->group_keys[i].name);
+		fprintf(stderr, "\n");
+	}
 
 	if (debug_table->option_timeout_interval)
 		fprintf(stderr, " \t -t timeout interval - don't print originators not seen for x.y seconds \n");
@@ -45,13 +72,29 @@ static void debug_table_usage(struct state *state)
 int handle_debug_table(struct state *state, int argc, char **argv)
 {
 	struct debug_table_data *debug_table = state->cmd->arg;
+	enum table_output output = TABLE_OUTPUT_CSV;
 	int optchar, read_opt = USE_BAT_HOSTS;
+	const struct table_group_key *group_key = NULL;
+	const struct table_sort_key *sort_key = NULL;
+	struct table_opts table = {
+		.filter = NULL,
+		.group = NULL,
+		.sort = NULL,
+		.format = NULL,
+	};
+	struct table_format table_format;
+	bool columns_output = false;
+	bool sort_reverse = false;
+	unsigned long sort_limit = 0;
 	char *orig_iface = NULL;
+	char *columns = NULL;
+	char *filter_expr = NULL;
+	char *endptr;
 	float orig_timeout = 0.0f;
 	float watch_interval = 1;
 	int err;
 
-	while ((optchar = getopt(argc, argv, "hnw:t:Humi:")) != -1) {
+	while ((optchar = getopt(argc, argv, DEBUG_TABLE_OPTSTRING)) != -1) {
 		switch (optchar) {
 		case 'h':
 			debug_table_usage(state);
@@ -87,6 +130,92 @@ int handle_debug_table(struct state *state, int argc, char **argv)
 		case 'H':
 			read_opt |= SKIP_HEADER;
 			break;
+		case 'd':
+			read_opt |= DIFF_READ;
+			break;
+		case 'l':
+			read_opt |= DIFF_CHANGES_ONLY;
+			break;
+		case 'o':
+			if (!debug_table->columns) {
+				fprintf(stderr, "Error - unrecognised option '-%c'\n", optchar);
+				debug_table_usage(state);
+				return EXIT_FAILURE;
+			}
+
+			if (strcmp(optarg, "csv") == 0) {
+				output = TABLE_OUTPUT_CSV;
+			} else if (strcmp(optarg, "tsv") == 0) {
+				output = TABLE_OUTPUT_TSV;
+			} else {
+				fprintf(stderr, "Error - unknown output format '%s'\n", optarg);
+				debug_table_usage(state);
+				return EXIT_FAILURE;
+			}
+
+			columns_output = true;
+			break;
+		case 'c':
+			if (!debug_table->columns) {
+				fprintf(stderr, "Error - unrecognised option '-%c'\n", optchar);
+				debug_table_usage(state);
+				return EXIT_FAILURE;
+			}
+
+			columns = optarg;
+			columns_output = true;
+			break;
+		case 's':
+			if (!debug_table->sort_keys) {
+				fprintf(stderr, "Error - unrecognised option '-%c'\n", optchar);
+				debug_table_usage(state);
+				return EXIT_FAILURE;
+			}
+
+			sort_key = table_sort_find_key(debug_table->sort_keys,
+						       debug_table->num_sort_keys,
+						       optarg);
+			if (!sort_key)
+				return EXIT_FAILURE;
+			break;
+		case 'N':
+			if (!debug_table->sort_keys) {
+				fprintf(stderr, "Error - unrecognised option '-%c'\n", optchar);
+				debug_table_usage(state);
+				return EXIT_FAILURE;
+			}
+
+			sort_limit = strtoul(optarg, &endptr, 10);
+			if (!endptr || *endptr != '\0' || sort_limit == 0) {
+				fprintf(stderr, "Error - provided argument of '-%c' is not a positive number\n", optchar);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'r':
+			if (!debug_table->sort_keys) {
+				fprintf(stderr, "Error - unrecognised option '-%c'\n", optchar);
+				debug_table_usage(state);
+				return EXIT_FAILURE;
+			}
+
+			sort_reverse = true;
+			break;
+		case 'F':
+			filter_expr = optarg;
+			break;
+		case 'g':
+			if (!debug_table->group_keys) {
+				fprintf(stderr, "Error - unrecognised option '-%c'\n", optchar);
+				debug_table_usage(state);
+				return EXIT_FAILURE;
+			}
+
+			group_key = table_group_find_key(debug_table->group_keys,
+							 debug_table->num_group_keys,
+							 optarg);
+			if (!group_key)
+				return EXIT_FAILURE;
+			break;
 		case 'u':
 			if (!debug_table->option_unicast_only) {
 				fprintf(stderr, "Error - unrecognised option '-%c'\n", optchar);
@@ -122,6 +251,18 @@ int handle_debug_table(struct state *state, int argc, char **argv)
 				fprintf(stderr, "Error - option '-t' needs a number as argument\n");
 			} else if (optopt == 'i') {
 				fprintf(stderr, "Error - option '-i' needs an interface as argument\n");
+			} else if (optopt == 'o') {
+				fprintf(stderr, "Error - option '-o' needs csv or tsv as argument\n");
+			} else if (optopt == 'c') {
+				fprintf(stderr, "Error - option '-c' needs a list of columns as argument\n");
+			} else if (optopt == 's') {
+				fprintf(stderr, "Error - option '-s' needs a sort key as argument\n");
+			} else if (optopt == 'N') {
+				fprintf(stderr, "Error - option '-N' needs a number as argument\n");
+			} else if (optopt == 'F') {
+				fprintf(stderr, "Error - option '-F' needs a filter expression as argument\n");
+			} else if (optopt == 'g') {
+				fprintf(stderr, "Error - option '-g' needs a group key as argument\n");
 			} else if (optopt == 'w') {
 				read_opt |= CLR_CONT_READ;
 				break;
@@ -144,7 +285,77 @@ int handle_debug_table(struct state *state, int argc, char **argv)
 		return EXIT_FAILURE;
 	}
 
+	if (read_opt & DIFF_READ && read_opt & DIFF_CHANGES_ONLY) {
+		fprintf(stderr, "Error - '-d' and '-l' are exclusive options\n");
+		debug_table_usage(state);
+		return EXIT_FAILURE;
+	}
+
+	if (columns_output && read_opt & (DIFF_READ|DIFF_CHANGES_ONLY)) {
+		fprintf(stderr, "Error - '-o'/'-c' can't be combined with '-d' or '-l'\n");
+		debug_table_usage(state);
+		return EXIT_FAILURE;
+	}
+
+	if ((sort_limit || sort_reverse) && !sort_key) {
+		fprintf(stderr, "Error - '-N' and '-r' need a sort key ('-s')\n");
+		debug_table_usage(state);
+		return EXIT_FAILURE;
+	}
+
+	if (group_key && (columns_output || sort_key ||
+			  read_opt & (DIFF_READ|DIFF_CHANGES_ONLY))) {
+		fprintf(stderr, "Error - '-g' can't be combined with '-o', '-c', '-s', '-d' or '-l'\n");
+		debug_table_usage(state);
+		return EXIT_FAILURE;
+	}
+
+	if (columns_output) {
+		if (table_format_init(&table_format, output,
+				      debug_table->columns,
+				      debug_table->num_columns, columns) < 0)
+			return EXIT_FAILURE;
+
+		table.format = &table_format;
+	}
+
+	/* differential output is only useful when the table is refreshed */
+	if (read_opt & DIFF_READ && !(read_opt & (CONT_READ|CLR_CONT_READ)))
+		read_opt |= CLR_CONT_READ;
+
+	if (read_opt & DIFF_CHANGES_ONLY && !(read_opt & (CONT_READ|CLR_CONT_READ)))
+		read_opt |= CONT_READ;
+
+	if (filter_expr) {
+		table.filter = filter_compile(filter_expr);
+		if (!table.filter)
+			return EXIT_FAILURE;
+	}
+
+	if (sort_key) {
+		table.sort = table_sort_new(sort_key, sort_reverse, sort_limit);
+		if (!table.sort) {
+			fprintf(stderr, "Error - out of memory\n");
+			filter_free(table.filter);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (group_key) {
+		table.group = table_group_new(group_key,
+					      debug_table->group_flags,
+					      debug_table->num_group_flags);
+		if (!table.group) {
+			fprintf(stderr, "Error - out of memory\n");
+			filter_free(table.filter);
+			return EXIT_FAILURE;
+		}
+	}
+
 	err = debug_table->netlink_fn(state , orig_iface, read_opt,
-				      orig_timeout, watch_interval);
+				      orig_timeout, watch_interval, &table);
+	table_group_free(table.group);
+	table_sort_free(table.sort);
+	filter_free(table.filter);
 	return err;
 }
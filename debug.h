@@ -11,10 +11,28 @@
 
 #include <stddef.h>
 #include "main.h"
+#include "filter.h"
+#include "tablefmt.h"
+#include "tablegroup.h"
+#include "tablesort.h"
+
+struct table_opts;
+
+/* options of handle_debug_table() */
+#define DEBUG_TABLE_OPTSTRING "hnw:t:Humi:dlo:c:s:N:rF:g:"
 
 struct debug_table_data {
 	int (*netlink_fn)(struct state *state, char *hard_iface, int read_opt,
-			 float orig_timeout, float watch_interval);
+			 float orig_timeout, float watch_interval,
+			 const struct table_opts *table);
+	const struct table_column *columns;
+	size_t num_columns;
+	const struct table_sort_key *sort_keys;
+	size_t num_sort_keys;
+	const struct table_group_key *group_keys;
+	size_t num_group_keys;
+	const struct table_group_flag *group_flags;
+	size_t num_group_flags;
 	unsigned int option_unicast_only:1;
 	unsigned int option_multicast_only:1;
 	unsigned int option_timeout_interval:1;
@@ -0,0 +1,654 @@
+// SPDX-License-Identifier: GPL-2.0
+/* Copyright (C) B.A.T.M.A.N. contributors:
+ *
+ * License-Filename: LICENSES/preferred/GPL-2.0
+ */
+
+#include <arpa/inet.h>
+#include <ctype.h>
+#include <errno.h>
+#include <net/ethernet.h>
+#include <net/if.h>
+#include <netlink/attr.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "filter.h"
+#include "batadv_packet.h"
+#include "batman_adv.h"
+#include "main.h"
+
+#define FILTER_MAX_INSNS 64
+#define FILTER_MAX_DEPTH 16
+#define FILTER_MAX_VALUE 64
+
+enum filter_type {
+	FILTER_TYPE_U8,
+	FILTER_TYPE_U16,
+	FILTER_TYPE_U32,
+	FILTER_TYPE_VID,
+	FILTER_TYPE_MAC,
+	FILTER_TYPE_IPV4,
+	FILTER_TYPE_IFNAME,
+	FILTER_TYPE_FLAG,
+	FILTER_TYPE_TT_FLAG,
+};
+
+/* the first present attribute of attrs is compared, the list is terminated
+ * by BATADV_ATTR_UNSPEC
+ */
+struct filter_field {
+	const char *name;
+	enum filter_type type;
+	int attrs[4];
+	uint32_t tt_flag;
+};
+
+static const struct filter_field filter_fields[] = {
+	{ "orig", FILTER_TYPE_MAC, { BATADV_ATTR_ORIG_ADDRESS }, 0 },
+	{ "orig_address", FILTER_TYPE_MAC, { BATADV_ATTR_ORIG_ADDRESS }, 0 },
+	{ "neigh", FILTER_TYPE_MAC, { BATADV_ATTR_NEIGH_ADDRESS }, 0 },
+	{ "neigh_address", FILTER_TYPE_MAC, { BATADV_ATTR_NEIGH_ADDRESS }, 0 },
+	{ "router", FILTER_TYPE_MAC, { BATADV_ATTR_ROUTER }, 0 },
+	{ "client", FILTER_TYPE_MAC, { BATADV_ATTR_TT_ADDRESS,
+				       BATADV_ATTR_BLA_ADDRESS,
+				       BATADV_ATTR_DAT_CACHE_HWADDRESS }, 0 },
+	{ "tt_address", FILTER_TYPE_MAC, { BATADV_ATTR_TT_ADDRESS }, 0 },
+	{ "backbone", FILTER_TYPE_MAC, { BATADV_ATTR_BLA_BACKBONE }, 0 },
+	{ "ip", FILTER_TYPE_IPV4, { BATADV_ATTR_DAT_CACHE_IP4ADDRESS }, 0 },
+	{ "vid", FILTER_TYPE_VID, { BATADV_ATTR_TT_VID, BATADV_ATTR_BLA_VID,
+				    BATADV_ATTR_DAT_CACHE_VID }, 0 },
+	{ "tq", FILTER_TYPE_U8, { BATADV_ATTR_TQ }, 0 },
+	{ "ttvn", FILTER_TYPE_U8, { BATADV_ATTR_TT_TTVN }, 0 },
+	{ "throughput", FILTER_TYPE_U32, { BATADV_ATTR_THROUGHPUT }, 0 },
+	{ "last_seen", FILTER_TYPE_U32, { BATADV_ATTR_LAST_SEEN_MSECS }, 0 },
+	{ "last_seen_msecs", FILTER_TYPE_U32,
+	  { BATADV_ATTR_LAST_SEEN_MSECS }, 0 },
+	{ "bandwidth_down", FILTER_TYPE_U32,
+	  { BATADV_ATTR_BANDWIDTH_DOWN }, 0 },
+	{ "bandwidth_up", FILTER_TYPE_U32, { BATADV_ATTR_BANDWIDTH_UP }, 0 },
+	{ "ifname", FILTER_TYPE_IFNAME, { BATADV_ATTR_HARD_IFNAME,
+					  BATADV_ATTR_HARD_IFINDEX }, 0 },
+	{ "hard_ifname", FILTER_TYPE_IFNAME, { BATADV_ATTR_HARD_IFNAME,
+					       BATADV_ATTR_HARD_IFINDEX }, 0 },
+	{ "best", FILTER_TYPE_FLAG, { BATADV_ATTR_FLAG_BEST }, 0 },
+	{ "roaming", FILTER_TYPE_TT_FLAG, { BATADV_ATTR_TT_FLAGS },
+	  BATADV_TT_CLIENT_ROAM },
+	{ "wifi", FILTER_TYPE_TT_FLAG, { BATADV_ATTR_TT_FLAGS },
+	  BATADV_TT_CLIENT_WIFI },
+	{ "isolated", FILTER_TYPE_TT_FLAG, { BATADV_ATTR_TT_FLAGS },
+	  BATADV_TT_CLIENT_ISOLA },
+	{ "nopurge", FILTER_TYPE_TT_FLAG, { BATADV_ATTR_TT_FLAGS },
+	  BATADV_TT_CLIENT_NOPURGE },
+	{ "new", FILTER_TYPE_TT_FLAG, { BATADV_ATTR_TT_FLAGS },
+	  BATADV_TT_CLIENT_NEW },
+	{ "pending", FILTER_TYPE_TT_FLAG, { BATADV_ATTR_TT_FLAGS },
+	  BATADV_TT_CLIENT_PENDING },
+	{ "temp", FILTER_TYPE_TT_FLAG, { BATADV_ATTR_TT_FLAGS },
+	  BATADV_TT_CLIENT_TEMP },
+};
+
+enum filter_op {
+	FILTER_OP_TEST,
+	FILTER_OP_NOT,
+	FILTER_OP_AND,
+	FILTER_OP_OR,
+};
+
+enum filter_cmp {
+	FILTER_CMP_EQ,
+	FILTER_CMP_NE,
+	FILTER_CMP_LT,
+	FILTER_CMP_LE,
+	FILTER_CMP_GT,
+	FILTER_CMP_GE,
+};
+
+/* every comparison is reduced to an integer: the masked MAC address, the
+ * raw IPv4 address or 1 when the interface name matched
+ */
+struct filter_insn {
+	enum filter_op op;
+	enum filter_cmp cmp;
+	const struct filter_field *field;
+	int64_t value;
+	uint64_t mask;
+	char ifname[IF_NAMESIZE];
+	unsigned int ifindex;
+};
+
+/* the expression in postfix order, evaluated with a small stack */
+struct filter {
+	struct filter_insn insns[FILTER_MAX_INSNS];
+	unsigned int num_insns;
+};
+
+struct filter_parser {
+	const char *expr;
+	const char *pos;
+	struct filter *filter;
+	unsigned int depth;
+};
+
+static int filter_error(struct filter_parser *parser, const char *msg)
+{
+	fprintf(stderr, "Error - invalid filter '%s': %s at position %zu\n",
+		parser->expr, msg, (size_t)(parser->pos - parser->expr) + 1);
+
+	return -EINVAL;
+}
+
+static void filter_skip_space(struct filter_parser *parser)
+{
+	while (isspace((unsigned char)*parser->pos))
+		parser->pos++;
+}
+
+static bool filter_accept(struct filter_parser *parser, const char *token)
+{
+	size_t len = strlen(token);
+
+	filter_skip_space(parser);
+
+	if (strncmp(parser->pos, token, len) != 0)
+		return false;
+
+	parser->pos += len;
+	return true;
+}
+
+static struct filter_insn *filter_emit(struct filter_parser *parser,
+				       enum filter_op op)
+{
+	struct filter *filter = parser->filter;
+	struct filter_insn *insn;
+
+	if (filter->num_insns == FILTER_MAX_INSNS) {
+		filter_error(parser, "expression too long");
+		return NULL;
+	}
+
+	switch (op) {
+	case FILTER_OP_TEST:
+		if (parser->depth == FILTER_MAX_DEPTH) {
+			filter_error(parser, "expression nested too deeply");
+			return NULL;
+		}
+
+		parser->depth++;
+		break;
+	case FILTER_OP_AND:
+	case FILTER_OP_OR:
+		parser->depth--;
+		break;
+	case FILTER_OP_NOT:
+		break;
+	}
+
+	insn = &filter->insns[filter->num_insns++];
+	memset(insn, 0, sizeof(*insn));
+	insn->op = op;
+
+	return insn;
+}
+
+static const struct filter_field *filter_find_field(const char *name,
+						    size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(filter_fields); i++) {
+		if (strlen(filter_fields[i].name) == len &&
+		    strncmp(filter_fields[i].name, name, len) == 0)
+			return &filter_fields[i];
+	}
+
+	return NULL;
+}
+
+static int filter_parse_mac(const char *str, struct filter_insn *insn)
+{
+	uint64_t value = 0;
+	uint64_t mask = 0;
+	unsigned long octet;
+	char *endptr;
+	int i;
+
+	for (i = 0; i < ETH_ALEN; i++) {
+		value <<= 8;
+		mask <<= 8;
+
+		if (*str == '*') {
+			str++;
+
+			/* a trailing wildcard matches the remaining octets */
+			if (*str == '\0') {
+				value <<= 8 * (ETH_ALEN - 1 - i);
+				mask <<= 8 * (ETH_ALEN - 1 - i);
+				break;
+			}
+		} else {
+			if (!isxdigit((unsigned char)*str))
+				return -EINVAL;
+
+			octet = strtoul(str, &endptr, 16);
+			if (octet > 0xff || endptr - str > 2)
+				return -EINVAL;
+
+			value |= octet;
+			mask |= 0xff;
+			str = endptr;
+		}
+
+		if (i < ETH_ALEN - 1) {
+			if (*str != ':')
+				return -EINVAL;
+
+			str++;
+		}
+	}
+
+	if (*str != '\0')
+		return -EINVAL;
+
+	insn->value = value;
+	insn->mask = mask;
+
+	return 0;
+}
+
+static int filter_parse_value(struct filter_insn *insn, const char *str)
+{
+	const struct filter_field *field = insn->field;
+	struct in_addr addr;
+	long long value;
+	char *endptr;
+
+	switch (field->type) {
+	case FILTER_TYPE_MAC:
+		return filter_parse_mac(str, insn);
+	case FILTER_TYPE_IPV4:
+		if (inet_pton(AF_INET, str, &addr) != 1)
+			return -EINVAL;
+
+		insn->value = addr.s_addr;
+		return 0;
+	case FILTER_TYPE_IFNAME:
+		if (strlen(str) >= sizeof(insn->ifname))
+			return -EINVAL;
+
+		strcpy(insn->ifname, str);
+		/* kernels without HARD_IFNAME only send the index */
+		insn->ifindex = if_nametoindex(str);
+		insn->value = 1;
+		return 0;
+	default:
+		break;
+	}
+
+	value = strtoll(str, &endptr, 0);
+	if (*str == '\0' || *endptr != '\0')
+		return -EINVAL;
+
+	switch (field->type) {
+	case FILTER_TYPE_U8:
+		if (value < 0 || value > UINT8_MAX)
+			return -ERANGE;
+		break;
+	case FILTER_TYPE_U16:
+		if (value < 0 || value > UINT16_MAX)
+			return -ERANGE;
+		break;
+	case FILTER_TYPE_U32:
+		if (value < 0 || value > UINT32_MAX)
+			return -ERANGE;
+		break;
+	case FILTER_TYPE_VID:
+		if (value < -1 || value > 4095)
+			return -ERANGE;
+		break;
+	case FILTER_TYPE_FLAG:
+	case FILTER_TYPE_TT_FLAG:
+		if (value != 0 && value != 1)
+			return -ERANGE;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	insn->value = value;
+
+	return 0;
+}
+
+static int filter_parse_test(struct filter_parser *parser)
+{
+	const struct filter_field *field;
+	char value[FILTER_MAX_VALUE];
+	struct filter_insn *insn;
+	const char *start;
+	size_t len;
+
+	filter_skip_space(parser);
+
+	start = parser->pos;
+	while (isalnum((unsigned char)*parser->pos) || *parser->pos == '_')
+		parser->pos++;
+
+	if (parser->pos == start)
+		return filter_error(parser, "field name expected");
+
+	field = filter_find_field(start, parser->pos - start);
+	if (!field) {
+		parser->pos = start;
+		return filter_error(parser, "unknown field");
+	}
+
+	insn = filter_emit(parser, FILTER_OP_TEST);
+	if (!insn)
+		return -EINVAL;
+
+	insn->field = field;
+
+	if (filter_accept(parser, "==")) {
+		insn->cmp = FILTER_CMP_EQ;
+	} else if (filter_accept(parser, "!=")) {
+		insn->cmp = FILTER_CMP_NE;
+	} else if (filter_accept(parser, "<=")) {
+		insn->cmp = FILTER_CMP_LE;
+	} else if (filter_accept(parser, ">=")) {
+		insn->cmp = FILTER_CMP_GE;
+	} else if (filter_accept(parser, "<")) {
+		insn->cmp = FILTER_CMP_LT;
+	} else if (filter_accept(parser, ">")) {
+		insn->cmp = FILTER_CMP_GT;
+	} else if (field->type == FILTER_TYPE_FLAG ||
+		   field->type == FILTER_TYPE_TT_FLAG) {
+		/* flags can be tested without a value */
+		insn->cmp = FILTER_CMP_EQ;
+		insn->value = 1;
+		return 0;
+	} else {
+		return filter_error(parser, "comparison operator expected");
+	}
+
+	switch (field->type) {
+	case FILTER_TYPE_MAC:
+	case FILTER_TYPE_IPV4:
+	case FILTER_TYPE_IFNAME:
+	case FILTER_TYPE_FLAG:
+	case FILTER_TYPE_TT_FLAG:
+		if (insn->cmp != FILTER_CMP_EQ && insn->cmp != FILTER_CMP_NE)
+			return filter_error(parser, "only == and != are supported for this field");
+		break;
+	default:
+		break;
+	}
+
+	filter_skip_space(parser);
+
+	start = parser->pos;
+	if (*parser->pos == '"') {
+		start++;
+		parser->pos = strchr(start, '"');
+		if (!parser->pos) {
+			parser->pos = start - 1;
+			return filter_error(parser, "unterminated string");
+		}
+
+		len = parser->pos - start;
+		parser->pos++;
+	} else {
+		while (*parser->pos && !isspace((unsigned char)*parser->pos) &&
+		       !strchr("&|()", *parser->pos))
+			parser->pos++;
+
+		len = parser->pos - start;
+	}
+
+	if (len == 0 || len >= sizeof(value))
+		return filter_error(parser, "value expected");
+
+	memcpy(value, start, len);
+	value[len] = '\0';
+
+	if (filter_parse_value(insn, value) < 0) {
+		parser->pos = start;
+		return filter_error(parser, "invalid value");
+	}
+
+	return 0;
+}
+
+static int filter_parse_or(struct filter_parser *parser);
+
+static int filter_parse_unary(struct filter_parser *parser)
+{
+	int ret;
+
+	filter_skip_space(parser);
+
+	if (parser->pos[0] == '!' && parser->pos[1] != '=') {
+		parser->pos++;
+
+		ret = filter_parse_unary(parser);
+		if (ret < 0)
+			return ret;
+
+		if (!filter_emit(parser, FILTER_OP_NOT))
+			return -EINVAL;
+
+		return 0;
+	}
+
+	if (filter_accept(parser, "(")) {
+		ret = filter_parse_or(parser);
+		if (ret < 0)
+			return ret;
+
+		if (!filter_accept(parser, ")"))
+			return filter_error(parser, "')' expected");
+
+		return 0;
+	}
+
+	return filter_parse_test(parser);
+}
+
+static int filter_parse_and(struct filter_parser *parser)
+{
+	int ret;
+
+	ret = filter_parse_unary(parser);
+	if (ret < 0)
+		return ret;
+
+	while (filter_accept(parser, "&&")) {
+		ret = filter_parse_unary(parser);
+		if (ret < 0)
+			return ret;
+
+		if (!filter_emit(parser, FILTER_OP_AND))
+			return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int filter_parse_or(struct filter_parser *parser)
+{
+	int ret;
+
+	ret = filter_parse_and(parser);
+	if (ret < 0)
+		return ret;
+
+	while (filter_accept(parser, "||")) {
+		ret = filter_parse_and(parser);
+		if (ret < 0)
+			return ret;
+
+		if (!filter_emit(parser, FILTER_OP_OR))
+			return -EINVAL;
+	}
+
+	return 0;
+}
+
+/* compile expr once, filter_match() then only walks the postfix program */
+struct filter *filter_compile(const char *expr)
+{
+	struct filter_parser parser = {
+		.expr = expr,
+		.pos = expr,
+		.depth = 0,
+	};
+	struct filter *filter;
+
+	filter = calloc(1, sizeof(*filter));
+	if (!filter) {
+		fprintf(stderr, "Error - out of memory\n");
+		return NULL;
+	}
+
+	parser.filter = filter;
+
+	if (filter_parse_or(&parser) < 0)
+		goto err;
+
+	filter_skip_space(&parser);
+	if (*parser.pos != '\0') {
+		filter_error(&parser, "'&&' or '||' expected");
+		goto err;
+	}
+
+	return filter;
+
+err:
+	free(filter);
+	return NULL;
+}
+
+void filter_free(struct filter *filter)
+{
+	free(filter);
+}
+
+static bool filter_compare(enum filter_cmp cmp, int64_t val1, int64_t val2)
+{
+	switch (cmp) {
+	case FILTER_CMP_EQ:
+		return val1 == val2;
+	case FILTER_CMP_NE:
+		return val1 != val2;
+	case FILTER_CMP_LT:
+		return val1 < val2;
+	case FILTER_CMP_LE:
+		return val1 <= val2;
+	case FILTER_CMP_GT:
+		return val1 > val2;
+	case FILTER_CMP_GE:
+		return val1 >= val2;
+	}
+
+	return false;
+}
+
+static bool filter_test(const struct filter_insn *insn, struct nlattr *attrs[])
+{
+	const struct filter_field *field = insn->field;
+	struct nlattr *attr = NULL;
+	uint64_t mac = 0;
+	uint8_t *addr;
+	int64_t val;
+	int attr_id;
+	int i;
+
+	for (i = 0; i < (int)ARRAY_SIZE(field->attrs) && field->attrs[i]; i++) {
+		attr = attrs[field->attrs[i]];
+		if (attr)
+			break;
+	}
+
+	if (field->type == FILTER_TYPE_FLAG)
+		return filter_compare(insn->cmp, !!attr, insn->value);
+
+	/* rows without the field never match */
+	if (!attr)
+		return false;
+
+	attr_id = field->attrs[i];
+
+	switch (field->type) {
+	case FILTER_TYPE_U8:
+		val = nla_get_u8(attr);
+		break;
+	case FILTER_TYPE_U16:
+		val = nla_get_u16(attr);
+		break;
+	case FILTER_TYPE_U32:
+		val = nla_get_u32(attr);
+		break;
+	case FILTER_TYPE_VID:
+		val = BATADV_PRINT_VID(nla_get_u16(attr));
+		break;
+	case FILTER_TYPE_MAC:
+		addr = nla_data(attr);
+		for (i = 0; i < ETH_ALEN; i++)
+			mac = (mac << 8) | addr[i];
+
+		val = mac & insn->mask;
+		break;
+	case FILTER_TYPE_IPV4:
+		val = nla_get_u32(attr);
+		break;
+	case FILTER_TYPE_IFNAME:
+		if (attr_id == BATADV_ATTR_HARD_IFINDEX)
+			val = insn->ifindex &&
+			      nla_get_u32(attr) == insn->ifindex;
+		else
+			val = strcmp(nla_get_string(attr), insn->ifname) == 0;
+		break;
+	case FILTER_TYPE_TT_FLAG:
+		val = !!(nla_get_u32(attr) & field->tt_flag);
+		break;
+	default:
+		return false;
+	}
+
+	return filter_compare(insn->cmp, val, insn->value);
+}
+
+bool filter_match(const struct filter *filter, struct nlattr *attrs[])
+{
+	bool stack[FILTER_MAX_DEPTH];
+	const struct filter_insn *insn;
+	unsigned int depth = 0;
+	unsigned int i;
+
+	for (i = 0; i < filter->num_insns; i++) {
+		insn = &filter->insns[i];
+
+		switch (insn->op) {
+		case FILTER_OP_TEST:
+			stack[depth++] = filter_test(insn, attrs);
+			break;
+		case FILTER_OP_NOT:
+			stack[depth - 1] = !stack[depth - 1];
+			break;
+		case FILTER_OP_AND:
+			depth--;
+			stack[depth - 1] = stack[depth - 1] && stack[depth];
+			break;
+		case FILTER_OP_OR:
+			depth--;
+			stack[depth - 1] = stack[depth - 1] || stack[depth];
+			break;
+		}
+	}
+
+	return stack[0];
+}
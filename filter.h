@@ -0,0 +1,19 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/* Copyright (C) B.A.T.M.A.N. contributors:
+ *
+ * License-Filename: LICENSES/preferred/GPL-2.0
+ */
+
+#ifndef _BATCTL_FILTER_H
+#define _BATCTL_FILTER_H
+
+#include <stdbool.h>
+
+struct nlattr;
+struct filter;
+
+struct filter *filter_compile(const char *expr);
+void filter_free(struct filter *filter);
+bool filter_match(const struct filter *filter, struct nlattr *attrs[]);
+
+#endif /* _BATCTL_FILTER_H */
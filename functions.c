@@ -8,6 +8,7 @@
 
 
 #include <netinet/ether.h>
+#include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <netdb.h>
 #include <sys/types.h>
@@ -31,6 +32,8 @@
 #include <sys/syscall.h>
 #include <errno.h>
 #include <net/if.h>
+#include <linux/sockios.h>
+#include <linux/ethtool.h>
 #include <netlink/socket.h>
 #include <netlink/netlink.h>
 #include <netlink/handlers.h>
@@ -44,6 +47,7 @@
 #include "sys.h"
 #include "debug.h"
 #include "netlink.h"
+#include "hash.h"
 
 #define PATH_BUFF_LEN 400
 
@@ -171,9 +175,43 @@ int read_file(const char *full_path, int read_opt)
 	return res;
 }
 
+/* snapshot shared by all translate_mac() calls of this process */
+#define TRANSLATE_MAC_TTL_MS 5000
+
+static struct tt_snapshot *translate_snapshot;
+static unsigned int translate_snapshot_ifindex;
+static struct timespec translate_snapshot_stamp;
+
+static struct tt_snapshot *translate_mac_snapshot(struct state *state)
+{
+	struct timespec now;
+	long age;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	if (translate_snapshot) {
+		age = (now.tv_sec - translate_snapshot_stamp.tv_sec) * 1000 +
+		      (now.tv_nsec - translate_snapshot_stamp.tv_nsec) / 1000000;
+
+		if (translate_snapshot_ifindex == state->mesh_ifindex &&
+		    age < TRANSLATE_MAC_TTL_MS)
+			return translate_snapshot;
+
+		tt_snapshot_free(translate_snapshot);
+	}
+
+	translate_snapshot = tt_snapshot_create(state);
+	translate_snapshot_ifindex = state->mesh_ifindex;
+	translate_snapshot_stamp = now;
+
+	return translate_snapshot;
+}
+
 struct ether_addr *translate_mac(struct state *state,
 				 const struct ether_addr *mac)
 {
+	const struct tt_snapshot_entry *entry;
+	struct tt_snapshot *snapshot;
 	struct ether_addr in_mac;
 	static struct ether_addr out_mac;
 	struct ether_addr *mac_result;
@@ -188,7 +226,13 @@ struct ether_addr *translate_mac(struct state *state,
 	if (!ether_addr_valid(in_mac.ether_addr_octet))
 		return mac_result;
 
-	translate_mac_netlink(state, &in_mac, mac_result);
+	snapshot = translate_mac_snapshot(state);
+	if (!snapshot)
+		return mac_result;
+
+	entry = tt_snapshot_find(snapshot, &in_mac, TT_SNAPSHOT_VID_ANY);
+	if (entry)
+		memcpy(mac_result, &entry->orig, sizeof(*mac_result));
 
 	return mac_result;
 }
@@ -452,6 +496,250 @@ struct ether_addr *resolve_mac(const char *asc)
 	return mac_result;
 }
 
+struct neigh_cache_entry {
+	int ai_family;
+	uint8_t l3addr[16];
+	struct ether_addr mac;
+};
+
+static int neigh_cache_compare(void *data1, void *data2)
+{
+	const struct neigh_cache_entry *entry1 = data1;
+	const struct neigh_cache_entry *entry2 = data2;
+
+	if (entry1->ai_family != entry2->ai_family)
+		return 0;
+
+	return (memcmp(entry1->l3addr, entry2->l3addr,
+		       sizeof(entry1->l3addr)) == 0 ? 1 : 0);
+}
+
+static int neigh_cache_choose(void *data, int32_t size)
+{
+	const struct neigh_cache_entry *entry = data;
+
+	return (hash_bytes(entry->l3addr, sizeof(entry->l3addr)) % size);
+}
+
+static int neigh_cache_parse(struct nl_msg *msg, void *arg)
+{
+	struct hashtable_t **hash = arg;
+	struct neigh_cache_entry *entry;
+	struct hashtable_t *swaphash;
+	struct nlattr *tb[NDA_MAX + 1];
+	struct ndmsg *nm;
+	uint8_t *mac;
+	int l3_len;
+	int ret;
+
+	nm = nlmsg_data(nlmsg_hdr(msg));
+	ret = nlmsg_parse(nlmsg_hdr(msg), sizeof(*nm), tb, NDA_MAX,
+			  neigh_policy);
+	if (ret < 0)
+		return NL_OK;
+
+	switch (nm->ndm_family) {
+	case AF_INET:
+		l3_len = 4;
+		break;
+	case AF_INET6:
+		l3_len = 16;
+		break;
+	default:
+		return NL_OK;
+	}
+
+	if (!tb[NDA_LLADDR] || !tb[NDA_DST])
+		return NL_OK;
+
+	if (nla_len(tb[NDA_LLADDR]) != ETH_ALEN)
+		return NL_OK;
+
+	if (nla_len(tb[NDA_DST]) != l3_len)
+		return NL_OK;
+
+	mac = nla_data(tb[NDA_LLADDR]);
+	if (!ether_addr_valid(mac))
+		return NL_OK;
+
+	entry = calloc(1, sizeof(*entry));
+	if (!entry)
+		return NL_OK;
+
+	entry->ai_family = nm->ndm_family;
+	memcpy(entry->l3addr, nla_data(tb[NDA_DST]), l3_len);
+	memcpy(&entry->mac, mac, ETH_ALEN);
+
+	if (hash_add(*hash, entry) != 0) {
+		free(entry);
+		return NL_OK;
+	}
+
+	if ((*hash)->elements * 4 > (*hash)->size) {
+		swaphash = hash_resize(*hash, (*hash)->size * 4);
+		if (swaphash)
+			*hash = swaphash;
+	}
+
+	return NL_OK;
+}
+
+/* dump the IPv4 and IPv6 neighbor caches into a hash keyed by l3 address */
+static struct hashtable_t *neigh_cache_dump(void)
+{
+	struct rtgenmsg gmsg = {
+		.rtgen_family = AF_UNSPEC,
+	};
+	struct hashtable_t *hash;
+	struct nl_sock *sock;
+	struct nl_cb *cb = NULL;
+	int ret = -ENOMEM;
+
+	hash = hash_new(64, neigh_cache_compare, neigh_cache_choose);
+	if (!hash)
+		return NULL;
+
+	sock = nl_socket_alloc();
+	if (!sock)
+		goto err;
+
+	ret = nl_connect(sock, NETLINK_ROUTE);
+	if (ret < 0)
+		goto err;
+
+	ret = nl_send_simple(sock, RTM_GETNEIGH, NLM_F_REQUEST | NLM_F_DUMP,
+			     &gmsg, sizeof(gmsg));
+	if (ret < 0)
+		goto err;
+
+	cb = nl_cb_alloc(NL_CB_DEFAULT);
+	if (!cb) {
+		ret = -ENOMEM;
+		goto err;
+	}
+
+	nl_cb_set(cb, NL_CB_VALID, NL_CB_CUSTOM, neigh_cache_parse, &hash);
+	ret = nl_recvmsgs(sock, cb);
+
+err:
+	if (cb)
+		nl_cb_put(cb);
+	if (sock)
+		nl_socket_free(sock);
+
+	if (ret < 0) {
+		hash_delete(hash, free);
+		return NULL;
+	}
+
+	return hash;
+}
+
+struct resolve_macs_l3 {
+	int ai_family;
+	uint8_t l3addr[16];
+};
+
+static bool resolve_macs_lookup(struct hashtable_t *neigh_hash,
+				struct resolve_macs_l3 *l3,
+				struct mac_resolve_req *req)
+{
+	struct neigh_cache_entry *entry;
+	struct neigh_cache_entry key;
+	int i;
+
+	for (i = 0; i < 2; i++) {
+		if (l3[i].ai_family == AF_UNSPEC)
+			continue;
+
+		key.ai_family = l3[i].ai_family;
+		memcpy(key.l3addr, l3[i].l3addr, sizeof(key.l3addr));
+
+		entry = hash_find(neigh_hash, &key);
+		if (!entry)
+			continue;
+
+		memcpy(&req->mac, &entry->mac, sizeof(req->mac));
+		req->found = true;
+		return true;
+	}
+
+	return false;
+}
+
+/* resolve many mac/IPv4/IPv6/host name strings at once. the neighbor cache
+ * is only dumped once per retry round instead of once per address
+ */
+void resolve_macs(struct mac_resolve_req *reqs, size_t num)
+{
+	static const int ai_families[] = {AF_INET, AF_INET6};
+	struct hashtable_t *neigh_hash;
+	struct resolve_macs_l3 *l3;
+	struct ether_addr *mac;
+	size_t missing = 0;
+	int retries = 5;
+	size_t i, j;
+
+	l3 = calloc(num, 2 * sizeof(*l3));
+	if (!l3)
+		return;
+
+	for (i = 0; i < num; i++) {
+		reqs[i].found = false;
+
+		mac = ether_aton(reqs[i].asc);
+		if (mac) {
+			memcpy(&reqs[i].mac, mac, sizeof(reqs[i].mac));
+			reqs[i].found = true;
+			continue;
+		}
+
+		for (j = 0; j < ARRAY_SIZE(ai_families); j++) {
+			if (resolve_l3addr(ai_families[j], reqs[i].asc,
+					   l3[i * 2 + j].l3addr) < 0)
+				continue;
+
+			l3[i * 2 + j].ai_family = ai_families[j];
+			missing++;
+		}
+	}
+
+	while (missing && retries--) {
+		neigh_hash = neigh_cache_dump();
+		if (!neigh_hash)
+			break;
+
+		missing = 0;
+		for (i = 0; i < num; i++) {
+			if (reqs[i].found)
+				continue;
+
+			if (l3[i * 2].ai_family == AF_UNSPEC &&
+			    l3[i * 2 + 1].ai_family == AF_UNSPEC)
+				continue;
+
+			if (resolve_macs_lookup(neigh_hash, &l3[i * 2], &reqs[i]))
+				continue;
+
+			for (j = 0; j < 2; j++) {
+				if (l3[i * 2 + j].ai_family == AF_UNSPEC)
+					continue;
+
+				request_mac_resolve(l3[i * 2 + j].ai_family,
+						    l3[i * 2 + j].l3addr);
+			}
+			missing++;
+		}
+
+		hash_delete(neigh_hash, free);
+
+		if (missing && retries)
+			usleep(200000);
+	}
+
+	free(l3);
+}
+
 int query_rtnl_link(int ifindex, nl_recvmsg_msg_cb_t func, void *arg)
 {
 	struct ifinfomsg rt_hdr = {
@@ -857,6 +1145,60 @@ int check_mesh_iface(struct state *state)
 	return check_mesh_iface_netlink(state->mesh_ifindex);
 }
 
+struct mesh_iface_dump {
+	void (*cb)(const char *ifname, void *arg);
+	void *arg;
+};
+
+static int mesh_iface_dump_parse(struct nl_msg *msg, void *arg)
+{
+	static struct nla_policy link_policy[IFLA_MAX + 1] = {
+		[IFLA_IFNAME] = { .type = NLA_STRING, .maxlen = IFNAMSIZ },
+		[IFLA_LINKINFO] = { .type = NLA_NESTED },
+	};
+	static struct nla_policy link_info_policy[IFLA_INFO_MAX + 1] = {
+		[IFLA_INFO_KIND] = { .type = NLA_STRING },
+	};
+	struct mesh_iface_dump *dump = arg;
+	struct nlattr *li[IFLA_INFO_MAX + 1];
+	struct nlattr *tb[IFLA_MAX + 1];
+	int ret;
+
+	ret = nlmsg_parse(nlmsg_hdr(msg), sizeof(struct ifinfomsg), tb,
+			  IFLA_MAX, link_policy);
+	if (ret < 0)
+		return NL_OK;
+
+	if (!tb[IFLA_IFNAME] || !tb[IFLA_LINKINFO])
+		return NL_OK;
+
+	ret = nla_parse_nested(li, IFLA_INFO_MAX, tb[IFLA_LINKINFO],
+			       link_info_policy);
+	if (ret < 0)
+		return NL_OK;
+
+	if (!li[IFLA_INFO_KIND])
+		return NL_OK;
+
+	if (strcmp(nla_get_string(li[IFLA_INFO_KIND]), "batadv") != 0)
+		return NL_OK;
+
+	dump->cb(nla_get_string(tb[IFLA_IFNAME]), dump->arg);
+
+	return NL_OK;
+}
+
+int for_each_mesh_iface(void (*cb)(const char *ifname, void *arg), void *arg)
+{
+	struct mesh_iface_dump dump = {
+		.cb = cb,
+		.arg = arg,
+	};
+
+	/* master ifindex 0 dumps all links */
+	return query_rtnl_link(0, mesh_iface_dump_parse, &dump);
+}
+
 int check_mesh_iface_ownership(struct state *state, char *hard_iface)
 {
 	struct rtnl_link_iface_data link_data;
@@ -876,6 +1218,30 @@ int check_mesh_iface_ownership(struct state *state, char *hard_iface)
 	return EXIT_SUCCESS;
 }
 
+int split_command_line(char *line, char **argv, int max_args)
+{
+	int argc = 0;
+	char *saveptr;
+	char *token;
+
+	token = strtok_r(line, " \t\r\n", &saveptr);
+	while (token) {
+		/* everything after a '#' is a comment */
+		if (token[0] == '#')
+			break;
+
+		if (argc == max_args - 1)
+			return -E2BIG;
+
+		argv[argc++] = token;
+		token = strtok_r(NULL, " \t\r\n", &saveptr);
+	}
+
+	argv[argc] = NULL;
+
+	return argc;
+}
+
 static int get_random_bytes_syscall(void *buf __maybe_unused,
 				    size_t buflen __maybe_unused)
 {
@@ -941,6 +1307,91 @@ void get_random_bytes(void *buf, size_t buflen)
 	get_random_bytes_fallback(buf, buflen);
 }
 
+/* code borrowed from ethtool */
+int get_ethtool_stats(const char *ifname,
+		      void (*cb)(const char *name, uint64_t value, void *arg),
+		      void *arg)
+{
+	struct ethtool_gstrings *strings = NULL;
+	struct ethtool_stats *stats = NULL;
+	unsigned int n_stats, sz_str, sz_stats, i;
+	char name[ETH_GSTRING_LEN + 1];
+	struct ethtool_drvinfo drvinfo;
+	struct ifreq ifr;
+	int fd, ret;
+
+	memset(&ifr, 0, sizeof(ifr));
+	strncpy(ifr.ifr_name, ifname, sizeof(ifr.ifr_name));
+	ifr.ifr_name[sizeof(ifr.ifr_name) - 1] = '\0';
+
+	fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (fd < 0) {
+		ret = -errno;
+		perror("Error - can't open socket");
+		return ret;
+	}
+
+	drvinfo.cmd = ETHTOOL_GDRVINFO;
+	ifr.ifr_data = (void *)&drvinfo;
+	if (ioctl(fd, SIOCETHTOOL, &ifr) < 0) {
+		ret = -errno;
+		perror("Error - can't open driver information");
+		goto out;
+	}
+
+	n_stats = drvinfo.n_stats;
+	if (n_stats < 1) {
+		ret = 0;
+		goto out;
+	}
+
+	sz_str = n_stats * ETH_GSTRING_LEN;
+	sz_stats = n_stats * sizeof(uint64_t);
+
+	strings = calloc(1, sz_str + sizeof(struct ethtool_gstrings));
+	stats = calloc(1, sz_stats + sizeof(struct ethtool_stats));
+	if (!strings || !stats) {
+		fprintf(stderr, "Error - out of memory\n");
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	strings->cmd = ETHTOOL_GSTRINGS;
+	strings->string_set = ETH_SS_STATS;
+	strings->len = n_stats;
+	ifr.ifr_data = (void *)strings;
+	if (ioctl(fd, SIOCETHTOOL, &ifr) < 0) {
+		ret = -errno;
+		perror("Error - can't get stats strings information");
+		goto out;
+	}
+
+	stats->cmd = ETHTOOL_GSTATS;
+	stats->n_stats = n_stats;
+	ifr.ifr_data = (void *)stats;
+	if (ioctl(fd, SIOCETHTOOL, &ifr) < 0) {
+		ret = -errno;
+		perror("Error - can't get stats information");
+		goto out;
+	}
+
+	for (i = 0; i < n_stats; i++) {
+		memcpy(name, &strings->data[i * ETH_GSTRING_LEN],
+		       ETH_GSTRING_LEN);
+		name[ETH_GSTRING_LEN] = '\0';
+
+		cb(name, stats->data[i], arg);
+	}
+
+	ret = 0;
+
+out:
+	free(strings);
+	free(stats);
+	close(fd);
+	return ret;
+}
+
 void check_root_or_die(const char *cmd)
 {
 	if (geteuid() != 0) {
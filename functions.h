@@ -36,6 +36,12 @@ enum batadv_bandwidth_units {
 
 struct state;
 
+struct mac_resolve_req {
+	const char *asc;
+	struct ether_addr mac;
+	bool found;
+};
+
 /* return time delta from start to end in milliseconds */
 void start_timer(void);
 double end_timer(void);
@@ -47,6 +53,7 @@ int read_file(const char *full_path, int read_opt);
 struct ether_addr *translate_mac(struct state *state,
 				 const struct ether_addr *mac);
 struct ether_addr *resolve_mac(const char *asc);
+void resolve_macs(struct mac_resolve_req *reqs, size_t num);
 int query_rtnl_link(int ifindex, nl_recvmsg_msg_cb_t func, void *arg);
 int netlink_simple_request(struct nl_msg *msg);
 int translate_mesh_iface_vlan(struct state *state, const char *vlandev);
@@ -58,8 +65,13 @@ int get_algoname(struct state *state, unsigned int mesh_ifindex,
 		 char *algoname, size_t algoname_len);
 int check_mesh_iface(struct state *state);
 int check_mesh_iface_ownership(struct state *state, char *hard_iface);
+int for_each_mesh_iface(void (*cb)(const char *ifname, void *arg), void *arg);
 
+int split_command_line(char *line, char **argv, int max_args);
 void get_random_bytes(void *buf, size_t buflen);
+int get_ethtool_stats(const char *ifname,
+		      void (*cb)(const char *name, uint64_t value, void *arg),
+		      void *arg);
 void check_root_or_die(const char *cmd);
 
 int parse_bool(const char *val, bool *res);
@@ -80,6 +92,8 @@ enum {
 	SKIP_HEADER = 0x100,
 	UNICAST_ONLY = 0x200,
 	MULTICAST_ONLY = 0x400,
+	DIFF_READ = 0x800,
+	DIFF_CHANGES_ONLY = 0x1000,
 };
 
 #endif
@@ -24,6 +24,9 @@
 #include "functions.h"
 #include "main.h"
 #include "netlink.h"
+#include "output.h"
+#include "tablefmt.h"
+#include "tablesort.h"
 
 static const int gateways_mandatory[] = {
 	BATADV_ATTR_ORIG_ADDRESS,
@@ -33,13 +36,27 @@ static const int gateways_mandatory[] = {
 	BATADV_ATTR_BANDWIDTH_UP,
 };
 
-static int gateways_callback(struct nl_msg *msg, void *arg)
+static const struct table_column gateways_columns[] = {
+	{ "best", BATADV_ATTR_FLAG_BEST, table_column_flag },
+	{ "orig_address", BATADV_ATTR_ORIG_ADDRESS, table_column_mac },
+	{ "tq", BATADV_ATTR_TQ, table_column_u8 },
+	{ "throughput", BATADV_ATTR_THROUGHPUT, table_column_u32 },
+	{ "router", BATADV_ATTR_ROUTER, table_column_mac },
+	{ "hard_ifname", BATADV_ATTR_HARD_IFNAME, table_column_ifname },
+	{ "bandwidth_down", BATADV_ATTR_BANDWIDTH_DOWN, table_column_u32 },
+	{ "bandwidth_up", BATADV_ATTR_BANDWIDTH_UP, table_column_u32 },
+};
+
+static const struct table_sort_key gateways_sort_keys[] = {
+	{ "tq", BATADV_ATTR_TQ, TABLE_SORT_U8, true },
+	{ "throughput", BATADV_ATTR_THROUGHPUT, TABLE_SORT_U32, true },
+	{ "bandwidth", BATADV_ATTR_BANDWIDTH_DOWN, TABLE_SORT_U32, true },
+	{ "address", BATADV_ATTR_ORIG_ADDRESS, TABLE_SORT_MAC, false },
+};
+
+static void gateways_print(struct nlattr *attrs[], struct print_opts *opts)
 {
-	struct nlattr *attrs[BATADV_ATTR_MAX+1];
-	struct nlmsghdr *nlh = nlmsg_hdr(msg);
-	struct print_opts *opts = arg;
 	struct bat_host *bat_host;
-	struct genlmsghdr *ghdr;
 	const char *primary_if;
 	uint32_t bandwidth_down;
 	uint32_t bandwidth_up;
@@ -49,28 +66,6 @@ static int gateways_callback(struct nl_msg *msg, void *arg)
 	char c = ' ';
 	uint8_t tq;
 
-	if (!genlmsg_valid_hdr(nlh, 0)) {
-		fputs("Received invalid data from kernel.\n", stderr);
-		exit(1);
-	}
-
-	ghdr = nlmsg_data(nlh);
-
-	if (ghdr->cmd != BATADV_CMD_GET_GATEWAYS)
-		return NL_OK;
-
-	if (nla_parse(attrs, BATADV_ATTR_MAX, genlmsg_attrdata(ghdr, 0),
-		      genlmsg_len(ghdr), batadv_netlink_policy)) {
-		fputs("Received invalid data from kernel.\n", stderr);
-		exit(1);
-	}
-
-	if (missing_mandatory_attrs(attrs, gateways_mandatory,
-				    ARRAY_SIZE(gateways_mandatory))) {
-		fputs("Missing attributes from kernel\n", stderr);
-		exit(1);
-	}
-
 	if (attrs[BATADV_ATTR_FLAG_BEST])
 		c = '*';
 
@@ -80,42 +75,60 @@ static int gateways_callback(struct nl_msg *msg, void *arg)
 	bandwidth_down = nla_get_u32(attrs[BATADV_ATTR_BANDWIDTH_DOWN]);
 	bandwidth_up = nla_get_u32(attrs[BATADV_ATTR_BANDWIDTH_UP]);
 
-	printf("%c ", c);
+	outbuf_putc(opts->out, c);
+	outbuf_putc(opts->out, ' ');
 
 	bat_host = bat_hosts_find_by_mac((char *)orig);
 	if (!(opts->read_opt & USE_BAT_HOSTS) || !bat_host)
-		printf("%02x:%02x:%02x:%02x:%02x:%02x ",
-		       orig[0], orig[1], orig[2],
-		       orig[3], orig[4], orig[5]);
+		outbuf_mac(opts->out, orig);
 	else
-		printf("%17s ", bat_host->name);
+		outbuf_str(opts->out, bat_host->name, 17);
+	outbuf_putc(opts->out, ' ');
 
 	if (attrs[BATADV_ATTR_THROUGHPUT]) {
 		throughput = nla_get_u32(attrs[BATADV_ATTR_THROUGHPUT]);
-		printf("(%9u.%1u) ", throughput / 10, throughput % 10);
+		outbuf_putc(opts->out, '(');
+		outbuf_uint(opts->out, throughput / 10, 9);
+		outbuf_putc(opts->out, '.');
+		outbuf_uint(opts->out, throughput % 10, 1);
+		outbuf_str(opts->out, ") ", 0);
 	} else if (attrs[BATADV_ATTR_TQ]) {
 		tq = nla_get_u8(attrs[BATADV_ATTR_TQ]);
-		printf("(%3i) ", tq);
+		outbuf_putc(opts->out, '(');
+		outbuf_int(opts->out, tq, 3);
+		outbuf_str(opts->out, ") ", 0);
 	}
 
 	bat_host = bat_hosts_find_by_mac((char *)router);
 	if (!(opts->read_opt & USE_BAT_HOSTS) || !bat_host)
-		printf("%02x:%02x:%02x:%02x:%02x:%02x ",
-		       router[0], router[1], router[2],
-		       router[3], router[4], router[5]);
+		outbuf_mac(opts->out, router);
 	else
-		printf("%17s ", bat_host->name);
-
-	printf("[%10s]: %u.%u/%u.%u MBit\n",
-	       primary_if, bandwidth_down / 10, bandwidth_down % 10,
-	       bandwidth_up / 10, bandwidth_up % 10);
-
-	return NL_OK;
+		outbuf_str(opts->out, bat_host->name, 17);
+	outbuf_putc(opts->out, ' ');
+
+	outbuf_putc(opts->out, '[');
+	outbuf_str(opts->out, primary_if, 10);
+	outbuf_str(opts->out, "]: ", 0);
+	outbuf_uint(opts->out, bandwidth_down / 10, 0);
+	outbuf_putc(opts->out, '.');
+	outbuf_uint(opts->out, bandwidth_down % 10, 0);
+	outbuf_putc(opts->out, '/');
+	outbuf_uint(opts->out, bandwidth_up / 10, 0);
+	outbuf_putc(opts->out, '.');
+	outbuf_uint(opts->out, bandwidth_up % 10, 0);
+	outbuf_str(opts->out, " MBit\n", 0);
 }
 
+static const struct table_rows gateways_rows = {
+	.mandatory = gateways_mandatory,
+	.num_mandatory = ARRAY_SIZE(gateways_mandatory),
+	.print = gateways_print,
+};
+
 static int netlink_print_gateways(struct state *state, char *orig_iface,
 				  int read_opts, float orig_timeout,
-				  float watch_interval)
+				  float watch_interval,
+				  const struct table_opts *table)
 {
 	char *header = NULL;
 	char *info_header;
@@ -140,11 +153,15 @@ static int netlink_print_gateways(struct state *state, char *orig_iface,
 				    orig_timeout, watch_interval,
 				    header,
 				    BATADV_CMD_GET_GATEWAYS,
-				    gateways_callback);
+				    &gateways_rows, table);
 }
 
 static struct debug_table_data batctl_debug_table_gateways = {
 	.netlink_fn = netlink_print_gateways,
+	.columns = gateways_columns,
+	.num_columns = ARRAY_SIZE(gateways_columns),
+	.sort_keys = gateways_sort_keys,
+	.num_sort_keys = ARRAY_SIZE(gateways_sort_keys),
 };
 
 COMMAND_NAMED(DEBUGTABLE, gateways, "gwl", handle_debug_table,
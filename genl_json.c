@@ -10,125 +10,214 @@
 #include "main.h"
 
 #include <arpa/inet.h>
-#include <ctype.h>
+#include <errno.h>
 #include <getopt.h>
-#include <inttypes.h>
+#include <net/ethernet.h>
 #include <netinet/in.h>
 #include <netlink/netlink.h>
 #include <netlink/attr.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include <sys/socket.h>
 #include <unistd.h>
 
 #include "functions.h"
 #include "batadv_packet.h"
 #include "batman_adv.h"
+#include "binenc.h"
+#include "filter.h"
 #include "netlink.h"
+#include "output.h"
 
 struct nla_policy_json {
 	const char *name;
-	void (*cb)(struct nlattr *attrs[], int idx);
+	void (*cb)(struct outbuf *out, struct nlattr *attrs[], int idx);
+	void (*encode)(struct binenc *enc, struct nlattr *attrs[], int idx);
 };
 
-static void sanitize_string(const char *str)
+struct nljson_bit {
+	const char *name;
+	uint32_t mask;
+};
+
+#define NLJSON_ONES 0x0101010101010101ULL
+#define NLJSON_HIGHS 0x8080808080808080ULL
+
+/* true when any byte of the word is '"', '\\' or not printable */
+static bool nljson_word_needs_escape(uint64_t w)
 {
-	while (*str) {
-		if (*str == '"' || *str == '\\') {
-			putchar('\\');
-			putchar(*str);
-		} else if (!isprint(*str)) {
-			printf("\\x%02x", *str);
+	uint64_t quote = w ^ (NLJSON_ONES * '"');
+	uint64_t bslash = w ^ (NLJSON_ONES * '\\');
+	uint64_t t;
+
+	t = (w - NLJSON_ONES * 0x20) & ~w;
+	t |= (quote - NLJSON_ONES) & ~quote;
+	t |= (bslash - NLJSON_ONES) & ~bslash;
+	t |= w | (w + NLJSON_ONES);
+
+	return (t & NLJSON_HIGHS) != 0;
+}
+
+static void sanitize_string(struct outbuf *out, const char *str)
+{
+	const char *end = str + strlen(str);
+	const char *run = str;
+	const char *chunk_end;
+	unsigned char c;
+	uint64_t w;
+
+	while (str < end) {
+		/* copy clean words without looking at the single bytes */
+		if (end - str >= (ptrdiff_t)sizeof(w)) {
+			memcpy(&w, str, sizeof(w));
+			if (!nljson_word_needs_escape(w)) {
+				str += sizeof(w);
+				continue;
+			}
+
+			chunk_end = str + sizeof(w);
 		} else {
-			putchar(*str);
+			chunk_end = end;
+		}
+
+		for (; str < chunk_end; str++) {
+			c = *str;
+			if (c >= 0x20 && c < 0x7f && c != '"' && c != '\\')
+				continue;
+
+			outbuf_write(out, run, str - run);
+			run = str + 1;
+
+			if (c == '"' || c == '\\') {
+				outbuf_putc(out, '\\');
+				outbuf_putc(out, c);
+			} else {
+				outbuf_write(out, "\\x", 2);
+				outbuf_hex(out, c, 2);
+			}
 		}
-		str++;
 	}
+
+	outbuf_write(out, run, end - run);
+}
+
+static void nljson_print_bool_str(struct outbuf *out, bool val)
+{
+	if (val)
+		outbuf_write(out, "true", 4);
+	else
+		outbuf_write(out, "false", 5);
 }
 
-static void nljson_print_str(struct nlattr *attrs[], int idx)
+static void nljson_print_bits(struct outbuf *out, const struct nljson_bit *bits,
+			      size_t num_bits, uint32_t val)
+{
+	size_t i;
+
+	outbuf_putc(out, '{');
+	for (i = 0; i < num_bits; i++) {
+		outbuf_putc(out, '"');
+		outbuf_str(out, bits[i].name, 0);
+		outbuf_write(out, "\": ", 3);
+		nljson_print_bool_str(out, val & bits[i].mask);
+		outbuf_putc(out, ',');
+	}
+
+	outbuf_write(out, "\"raw\": ", 7);
+	outbuf_uint(out, val, 0);
+	outbuf_putc(out, '}');
+}
+
+static void nljson_print_str(struct outbuf *out, struct nlattr *attrs[],
+			     int idx)
 {
 	const char *value;
 
 	value = nla_get_string(attrs[idx]);
 
-	putchar('"');
-	sanitize_string(value);
-	putchar('"');
+	outbuf_putc(out, '"');
+	sanitize_string(out, value);
+	outbuf_putc(out, '"');
 }
 
-static void nljson_print_flag(struct nlattr *attrs[] __maybe_unused,
+static void nljson_print_flag(struct outbuf *out,
+			      struct nlattr *attrs[] __maybe_unused,
 			      int idx __maybe_unused)
 {
-	printf("true");
+	nljson_print_bool_str(out, true);
 }
 
-static void nljson_print_bool(struct nlattr *attrs[], int idx)
+static void nljson_print_bool(struct outbuf *out, struct nlattr *attrs[],
+			      int idx)
 {
-	printf("%s", nla_get_u8(attrs[idx]) ? "true" : "false");
+	nljson_print_bool_str(out, nla_get_u8(attrs[idx]));
 }
 
-static void nljson_print_uint8(struct nlattr *attrs[], int idx)
+static void nljson_print_uint8(struct outbuf *out, struct nlattr *attrs[],
+			       int idx)
 {
-	printf("%"PRIu8, nla_get_u8(attrs[idx]));
+	outbuf_uint(out, nla_get_u8(attrs[idx]), 0);
 }
 
-static void nljson_print_uint16(struct nlattr *attrs[], int idx)
+static void nljson_print_uint16(struct outbuf *out, struct nlattr *attrs[],
+				int idx)
 {
-	printf("%"PRIu16, nla_get_u16(attrs[idx]));
+	outbuf_uint(out, nla_get_u16(attrs[idx]), 0);
 }
 
-static void nljson_print_uint32(struct nlattr *attrs[], int idx)
+static void nljson_print_uint32(struct outbuf *out, struct nlattr *attrs[],
+				int idx)
 {
-	printf("%"PRIu32, nla_get_u32(attrs[idx]));
+	outbuf_uint(out, nla_get_u32(attrs[idx]), 0);
 }
 
-static void nljson_print_uint64(struct nlattr *attrs[], int idx)
+static void nljson_print_uint64(struct outbuf *out, struct nlattr *attrs[],
+				int idx)
 {
-	printf("%"PRIu64, nla_get_u64(attrs[idx]));
+	outbuf_u64(out, nla_get_u64(attrs[idx]));
 }
 
-static void nljson_print_vlanid(struct nlattr *attrs[], int idx)
+static void nljson_print_vlanid(struct outbuf *out, struct nlattr *attrs[],
+				int idx)
 {
 	uint16_t vid = nla_get_u16(attrs[idx]);
 
-	printf("%d", BATADV_PRINT_VID(vid));
+	outbuf_int(out, BATADV_PRINT_VID(vid), 0);
 }
 
-static void nljson_print_mac(struct nlattr *attrs[], int idx)
+static void nljson_print_mac(struct outbuf *out, struct nlattr *attrs[],
+			     int idx)
 {
 	uint8_t *value = nla_data(attrs[idx]);
 
-	printf("\"%02x:%02x:%02x:%02x:%02x:%02x\"",
-	       value[0], value[1], value[2], value[3], value[4], value[5]);
+	outbuf_putc(out, '"');
+	outbuf_mac(out, value);
+	outbuf_putc(out, '"');
 }
 
-static void nljson_print_ttflags(struct nlattr *attrs[], int idx)
+static const struct nljson_bit nljson_ttflags[] = {
+	{ "del", BATADV_TT_CLIENT_DEL },
+	{ "roam", BATADV_TT_CLIENT_ROAM },
+	{ "wifi", BATADV_TT_CLIENT_WIFI },
+	{ "isolated", BATADV_TT_CLIENT_ISOLA },
+	{ "nopurge", BATADV_TT_CLIENT_NOPURGE },
+	{ "new", BATADV_TT_CLIENT_NEW },
+	{ "pending", BATADV_TT_CLIENT_PENDING },
+	{ "temp", BATADV_TT_CLIENT_TEMP },
+};
+
+static void nljson_print_ttflags(struct outbuf *out, struct nlattr *attrs[],
+				 int idx)
 {
-	uint32_t val = nla_get_u32(attrs[idx]);
+	nljson_print_bits(out, nljson_ttflags, ARRAY_SIZE(nljson_ttflags),
+			  nla_get_u32(attrs[idx]));
+}
 
-	putchar('{');
-	printf("\"del\": %s,",
-	       val & BATADV_TT_CLIENT_DEL ? "true" : "false");
-	printf("\"roam\": %s,",
-	       val & BATADV_TT_CLIENT_ROAM ? "true" : "false");
-	printf("\"wifi\": %s,",
-	       val & BATADV_TT_CLIENT_WIFI ? "true" : "false");
-	printf("\"isolated\": %s,",
-	       val & BATADV_TT_CLIENT_ISOLA ? "true" : "false");
-	printf("\"nopurge\": %s,",
-	       val & BATADV_TT_CLIENT_NOPURGE ? "true" : "false");
-	printf("\"new\": %s,",
-	       val & BATADV_TT_CLIENT_NEW ? "true" : "false");
-	printf("\"pending\": %s,",
-	       val & BATADV_TT_CLIENT_PENDING ? "true" : "false");
-	printf("\"temp\": %s,",
-	       val & BATADV_TT_CLIENT_TEMP ? "true" : "false");
-	printf("\"raw\": %"PRIu32, val);
-	putchar('}');
-}
-
-static void nljson_print_ipv4(struct nlattr *attrs[], int idx)
+static void nljson_print_ipv4(struct outbuf *out, struct nlattr *attrs[],
+			      int idx)
 {
 	uint32_t val = nla_get_u32(attrs[idx]);
 	struct in_addr in_addr;
@@ -137,92 +226,206 @@ static void nljson_print_ipv4(struct nlattr *attrs[], int idx)
 	in_addr.s_addr = val;
 	addr = inet_ntoa(in_addr);
 
-	putchar('"');
-	sanitize_string(addr);
-	putchar('"');
+	outbuf_putc(out, '"');
+	sanitize_string(out, addr);
+	outbuf_putc(out, '"');
 }
 
-static void nljson_print_mcastflags(struct nlattr *attrs[], int idx)
-{
-	uint32_t val = nla_get_u32(attrs[idx]);
+static const struct nljson_bit nljson_mcastflags[] = {
+	{ "all_unsnoopables", BATADV_MCAST_WANT_ALL_UNSNOOPABLES },
+	{ "want_all_ipv4", BATADV_MCAST_WANT_ALL_IPV4 },
+	{ "want_all_ipv6", BATADV_MCAST_WANT_ALL_IPV6 },
+	{ "want_no_rtr_ipv4", BATADV_MCAST_WANT_NO_RTR4 },
+	{ "want_no_rtr_ipv6", BATADV_MCAST_WANT_NO_RTR6 },
+};
 
-	putchar('{');
-	printf("\"all_unsnoopables\": %s,",
-	       val & BATADV_MCAST_WANT_ALL_UNSNOOPABLES ? "true" : "false");
-	printf("\"want_all_ipv4\": %s,",
-	       val & BATADV_MCAST_WANT_ALL_IPV4 ? "true" : "false");
-	printf("\"want_all_ipv6\": %s,",
-	       val & BATADV_MCAST_WANT_ALL_IPV6 ? "true" : "false");
-	printf("\"want_no_rtr_ipv4\": %s,",
-	       val & BATADV_MCAST_WANT_NO_RTR4 ? "true" : "false");
-	printf("\"want_no_rtr_ipv6\": %s,",
-	       val & BATADV_MCAST_WANT_NO_RTR6 ? "true" : "false");
-	printf("\"raw\": %"PRIu32, val);
-	putchar('}');
+static void nljson_print_mcastflags(struct outbuf *out, struct nlattr *attrs[],
+				    int idx)
+{
+	nljson_print_bits(out, nljson_mcastflags,
+			  ARRAY_SIZE(nljson_mcastflags),
+			  nla_get_u32(attrs[idx]));
 }
 
-static void nljson_print_mcastflags_priv(struct nlattr *attrs[], int idx)
-{
-	uint32_t val = nla_get_u32(attrs[idx]);
+static const struct nljson_bit nljson_mcastflags_priv[] = {
+	{ "bridged", BATADV_MCAST_FLAGS_BRIDGED },
+	{ "querier_ipv4_exists", BATADV_MCAST_FLAGS_QUERIER_IPV4_EXISTS },
+	{ "querier_ipv6_exists", BATADV_MCAST_FLAGS_QUERIER_IPV6_EXISTS },
+	{ "querier_ipv4_shadowing", BATADV_MCAST_FLAGS_QUERIER_IPV4_SHADOWING },
+	{ "querier_ipv6_shadowing", BATADV_MCAST_FLAGS_QUERIER_IPV6_SHADOWING },
+};
 
-	putchar('{');
-	printf("\"bridged\": %s,",
-	       val & BATADV_MCAST_FLAGS_BRIDGED ? "true" : "false");
-	printf("\"querier_ipv4_exists\": %s,",
-	       val & BATADV_MCAST_FLAGS_QUERIER_IPV4_EXISTS ? "true" : "false");
-	printf("\"querier_ipv6_exists\": %s,",
-	       val & BATADV_MCAST_FLAGS_QUERIER_IPV6_EXISTS ? "true" : "false");
-	printf("\"querier_ipv4_shadowing\": %s,",
-	       val & BATADV_MCAST_FLAGS_QUERIER_IPV4_SHADOWING ? "true" : "false");
-	printf("\"querier_ipv6_shadowing\": %s,",
-	       val & BATADV_MCAST_FLAGS_QUERIER_IPV6_SHADOWING ? "true" : "false");
-	printf("\"raw\": %"PRIu32, val);
-	putchar('}');
+static void nljson_print_mcastflags_priv(struct outbuf *out,
+					 struct nlattr *attrs[], int idx)
+{
+	nljson_print_bits(out, nljson_mcastflags_priv,
+			  ARRAY_SIZE(nljson_mcastflags_priv),
+			  nla_get_u32(attrs[idx]));
 }
 
-static void nljson_print_gwmode(struct nlattr *attrs[], int idx)
+static const char *nljson_gwmode_name(uint8_t val)
 {
-	uint8_t val = nla_get_u8(attrs[idx]);
-
 	switch (val) {
 	case BATADV_GW_MODE_OFF:
-		printf("\"off\"");
-		break;
+		return "off";
 	case BATADV_GW_MODE_CLIENT:
-		printf("\"client\"");
-		break;
+		return "client";
 	case BATADV_GW_MODE_SERVER:
-		printf("\"server\"");
-		break;
+		return "server";
 	default:
-		printf("\"unknown\"");
-		break;
+		return "unknown";
 	}
 }
 
-static void nljson_print_loglevel(struct nlattr *attrs[], int idx)
+static void nljson_print_gwmode(struct outbuf *out, struct nlattr *attrs[],
+				int idx)
 {
-	uint32_t val = nla_get_u32(attrs[idx]);
+	outbuf_putc(out, '"');
+	outbuf_str(out, nljson_gwmode_name(nla_get_u8(attrs[idx])), 0);
+	outbuf_putc(out, '"');
+}
+
+static const struct nljson_bit nljson_loglevel[] = {
+	{ "batman", BIT(0) },
+	{ "routes", BIT(1) },
+	{ "tt", BIT(2) },
+	{ "bla", BIT(3) },
+	{ "dat", BIT(4) },
+	{ "nc", BIT(5) },
+	{ "mcast", BIT(6) },
+	{ "tp", BIT(7) },
+};
+
+static void nljson_print_loglevel(struct outbuf *out, struct nlattr *attrs[],
+				  int idx)
+{
+	nljson_print_bits(out, nljson_loglevel, ARRAY_SIZE(nljson_loglevel),
+			  nla_get_u32(attrs[idx]));
+}
+
+static void nljson_encode_bits(struct binenc *enc,
+			       const struct nljson_bit *bits, size_t num_bits,
+			       uint32_t val)
+{
+	size_t i;
+
+	binenc_map(enc, num_bits + 1);
+	for (i = 0; i < num_bits; i++) {
+		binenc_str(enc, bits[i].name, strlen(bits[i].name));
+		binenc_bool(enc, val & bits[i].mask);
+	}
+
+	binenc_str(enc, "raw", 3);
+	binenc_uint(enc, val);
+}
+
+static void nljson_encode_str(struct binenc *enc, struct nlattr *attrs[],
+			      int idx)
+{
+	const char *value = nla_get_string(attrs[idx]);
+
+	binenc_str(enc, value, strlen(value));
+}
+
+static void nljson_encode_flag(struct binenc *enc,
+			       struct nlattr *attrs[] __maybe_unused,
+			       int idx __maybe_unused)
+{
+	binenc_bool(enc, true);
+}
+
+static void nljson_encode_bool(struct binenc *enc, struct nlattr *attrs[],
+			       int idx)
+{
+	binenc_bool(enc, nla_get_u8(attrs[idx]));
+}
+
+static void nljson_encode_uint8(struct binenc *enc, struct nlattr *attrs[],
+				int idx)
+{
+	binenc_uint(enc, nla_get_u8(attrs[idx]));
+}
+
+static void nljson_encode_uint16(struct binenc *enc, struct nlattr *attrs[],
+				 int idx)
+{
+	binenc_uint(enc, nla_get_u16(attrs[idx]));
+}
+
+static void nljson_encode_uint32(struct binenc *enc, struct nlattr *attrs[],
+				 int idx)
+{
+	binenc_uint(enc, nla_get_u32(attrs[idx]));
+}
+
+static void nljson_encode_uint64(struct binenc *enc, struct nlattr *attrs[],
+				 int idx)
+{
+	binenc_uint(enc, nla_get_u64(attrs[idx]));
+}
+
+static void nljson_encode_vlanid(struct binenc *enc, struct nlattr *attrs[],
+				 int idx)
+{
+	uint16_t vid = nla_get_u16(attrs[idx]);
+
+	binenc_int(enc, BATADV_PRINT_VID(vid));
+}
+
+static void nljson_encode_mac(struct binenc *enc, struct nlattr *attrs[],
+			      int idx)
+{
+	binenc_bytes(enc, nla_data(attrs[idx]), ETH_ALEN);
+}
+
+static void nljson_encode_ttflags(struct binenc *enc, struct nlattr *attrs[],
+				  int idx)
+{
+	nljson_encode_bits(enc, nljson_ttflags, ARRAY_SIZE(nljson_ttflags),
+			   nla_get_u32(attrs[idx]));
+}
+
+static void nljson_encode_ipv4(struct binenc *enc, struct nlattr *attrs[],
+			       int idx)
+{
+	struct in_addr in_addr;
+	char *addr;
+
+	in_addr.s_addr = nla_get_u32(attrs[idx]);
+	addr = inet_ntoa(in_addr);
+
+	binenc_str(enc, addr, strlen(addr));
+}
 
-	putchar('{');
-	printf("\"batman\": %s,",
-	       val & BIT(0) ? "true" : "false");
-	printf("\"routes\": %s,",
-	       val & BIT(1) ? "true" : "false");
-	printf("\"tt\": %s,",
-	       val & BIT(2) ? "true" : "false");
-	printf("\"bla\": %s,",
-	       val & BIT(3) ? "true" : "false");
-	printf("\"dat\": %s,",
-	       val & BIT(4) ? "true" : "false");
-	printf("\"nc\": %s,",
-	       val & BIT(5) ? "true" : "false");
-	printf("\"mcast\": %s,",
-	       val & BIT(6) ? "true" : "false");
-	printf("\"tp\": %s,",
-	       val & BIT(7) ? "true" : "false");
-	printf("\"raw\": %"PRIu32, val);
-	putchar('}');
+static void nljson_encode_mcastflags(struct binenc *enc,
+				     struct nlattr *attrs[], int idx)
+{
+	nljson_encode_bits(enc, nljson_mcastflags,
+			   ARRAY_SIZE(nljson_mcastflags),
+			   nla_get_u32(attrs[idx]));
+}
+
+static void nljson_encode_mcastflags_priv(struct binenc *enc,
+					  struct nlattr *attrs[], int idx)
+{
+	nljson_encode_bits(enc, nljson_mcastflags_priv,
+			   ARRAY_SIZE(nljson_mcastflags_priv),
+			   nla_get_u32(attrs[idx]));
+}
+
+static void nljson_encode_gwmode(struct binenc *enc, struct nlattr *attrs[],
+				 int idx)
+{
+	const char *name = nljson_gwmode_name(nla_get_u8(attrs[idx]));
+
+	binenc_str(enc, name, strlen(name));
+}
+
+static void nljson_encode_loglevel(struct binenc *enc, struct nlattr *attrs[],
+				   int idx)
+{
+	nljson_encode_bits(enc, nljson_loglevel, ARRAY_SIZE(nljson_loglevel),
+			   nla_get_u32(attrs[idx]));
 }
 
 /* WARNING: attributes must also be added to batadv_netlink_policy */
@@ -230,272 +433,439 @@ static const struct nla_policy_json batadv_genl_json[NUM_BATADV_ATTR] = {
 	[BATADV_ATTR_VERSION] = {
 		.name = "version",
 		.cb = nljson_print_str,
+		.encode = nljson_encode_str,
 	},
 	[BATADV_ATTR_ALGO_NAME] = {
 		.name = "algo_name",
 		.cb = nljson_print_str,
+		.encode = nljson_encode_str,
 	},
 	[BATADV_ATTR_MESH_IFINDEX] = {
 		.name = "mesh_ifindex",
 		.cb = nljson_print_uint32,
+		.encode = nljson_encode_uint32,
 	},
 	[BATADV_ATTR_MESH_IFNAME] = {
 		.name = "mesh_ifname",
 		.cb = nljson_print_str,
+		.encode = nljson_encode_str,
 	},
 	[BATADV_ATTR_MESH_ADDRESS] = {
 		.name = "mesh_address",
 		.cb = nljson_print_mac,
+		.encode = nljson_encode_mac,
 	},
 	[BATADV_ATTR_HARD_IFINDEX] = {
 		.name = "hard_ifindex",
 		.cb = nljson_print_uint32,
+		.encode = nljson_encode_uint32,
 	},
 	[BATADV_ATTR_HARD_IFNAME] = {
 		.name = "hard_ifname",
 		.cb = nljson_print_str,
+		.encode = nljson_encode_str,
 	},
 	[BATADV_ATTR_HARD_ADDRESS] = {
 		.name = "hard_address",
 		.cb = nljson_print_mac,
+		.encode = nljson_encode_mac,
 	},
 	[BATADV_ATTR_ORIG_ADDRESS] = {
 		.name = "orig_address",
 		.cb = nljson_print_mac,
+		.encode = nljson_encode_mac,
 	},
 	[BATADV_ATTR_TPMETER_RESULT] = {
 		.name = "tpmeter_result",
 		.cb = nljson_print_uint8,
+		.encode = nljson_encode_uint8,
 	},
 	[BATADV_ATTR_TPMETER_TEST_TIME] = {
 		.name = "tpmeter_test_time",
 		.cb = nljson_print_uint32,
+		.encode = nljson_encode_uint32,
 	},
 	[BATADV_ATTR_TPMETER_BYTES] = {
 		.name = "tpmeter_bytes",
 		.cb = nljson_print_uint64,
+		.encode = nljson_encode_uint64,
 	},
 	[BATADV_ATTR_TPMETER_COOKIE] = {
 		.name = "tpmeter_cookie",
 		.cb = nljson_print_uint32,
+		.encode = nljson_encode_uint32,
 	},
 	[BATADV_ATTR_ACTIVE] = {
 		.name = "active",
 		.cb = nljson_print_flag,
+		.encode = nljson_encode_flag,
 	},
 	[BATADV_ATTR_TT_ADDRESS] = {
 		.name = "tt_address",
 		.cb = nljson_print_mac,
+		.encode = nljson_encode_mac,
 	},
 	[BATADV_ATTR_TT_TTVN] = {
 		.name = "tt_ttvn",
 		.cb = nljson_print_uint8,
+		.encode = nljson_encode_uint8,
 	},
 	[BATADV_ATTR_TT_LAST_TTVN] = {
 		.name = "tt_last_ttvn",
 		.cb = nljson_print_uint8,
+		.encode = nljson_encode_uint8,
 	},
 	[BATADV_ATTR_TT_CRC32] = {
 		.name = "tt_crc32",
 		.cb = nljson_print_uint32,
+		.encode = nljson_encode_uint32,
 	},
 	[BATADV_ATTR_TT_VID] = {
 		.name = "tt_vid",
 		.cb = nljson_print_vlanid,
+		.encode = nljson_encode_vlanid,
 	},
 	[BATADV_ATTR_TT_FLAGS] = {
 		.name = "tt_flags",
 		.cb = nljson_print_ttflags,
+		.encode = nljson_encode_ttflags,
 	},
 	[BATADV_ATTR_FLAG_BEST] = {
 		.name = "best",
 		.cb = nljson_print_flag,
+		.encode = nljson_encode_flag,
 	},
 	[BATADV_ATTR_LAST_SEEN_MSECS] = {
 		.name = "last_seen_msecs",
 		.cb = nljson_print_uint32,
+		.encode = nljson_encode_uint32,
 	},
 	[BATADV_ATTR_NEIGH_ADDRESS] = {
 		.name = "neigh_address",
 		.cb = nljson_print_mac,
+		.encode = nljson_encode_mac,
 	},
 	[BATADV_ATTR_TQ] = {
 		.name = "tq",
 		.cb = nljson_print_uint8,
+		.encode = nljson_encode_uint8,
 	},
 	[BATADV_ATTR_THROUGHPUT] = {
 		.name = "throughput",
 		.cb = nljson_print_uint32,
+		.encode = nljson_encode_uint32,
 	},
 	[BATADV_ATTR_BANDWIDTH_UP] = {
 		.name = "bandwidth_up",
 		.cb = nljson_print_uint32,
+		.encode = nljson_encode_uint32,
 	},
 	[BATADV_ATTR_BANDWIDTH_DOWN] = {
 		.name = "bandwidth_down",
 		.cb = nljson_print_uint32,
+		.encode = nljson_encode_uint32,
 	},
 	[BATADV_ATTR_ROUTER] = {
 		.name = "router",
 		.cb = nljson_print_mac,
+		.encode = nljson_encode_mac,
 	},
 	[BATADV_ATTR_BLA_OWN] = {
 		.name = "bla_own",
 		.cb = nljson_print_flag,
+		.encode = nljson_encode_flag,
 	},
 	[BATADV_ATTR_BLA_ADDRESS] = {
 		.name = "bla_address",
 		.cb = nljson_print_mac,
+		.encode = nljson_encode_mac,
 	},
 	[BATADV_ATTR_BLA_VID] = {
 		.name = "bla_vid",
 		.cb = nljson_print_vlanid,
+		.encode = nljson_encode_vlanid,
 	},
 	[BATADV_ATTR_BLA_BACKBONE] = {
 		.name = "bla_backbone",
 		.cb = nljson_print_mac,
+		.encode = nljson_encode_mac,
 	},
 	[BATADV_ATTR_BLA_CRC] = {
 		.name = "bla_crc",
 		.cb = nljson_print_uint16,
+		.encode = nljson_encode_uint16,
 	},
 	[BATADV_ATTR_DAT_CACHE_IP4ADDRESS] = {
 		.name = "dat_cache_ip4address",
 		.cb = nljson_print_ipv4,
+		.encode = nljson_encode_ipv4,
 	},
 	[BATADV_ATTR_DAT_CACHE_HWADDRESS] = {
 		.name = "dat_cache_hwaddress",
 		.cb = nljson_print_mac,
+		.encode = nljson_encode_mac,
 	},
 	[BATADV_ATTR_DAT_CACHE_VID] = {
 		.name = "dat_cache_vid",
 		.cb = nljson_print_vlanid,
+		.encode = nljson_encode_vlanid,
 	},
 	[BATADV_ATTR_MCAST_FLAGS] = {
 		.name = "mcast_flags",
 		.cb = nljson_print_mcastflags,
+		.encode = nljson_encode_mcastflags,
 	},
 	[BATADV_ATTR_MCAST_FLAGS_PRIV] = {
 		.name = "mcast_flags_priv",
 		.cb = nljson_print_mcastflags_priv,
+		.encode = nljson_encode_mcastflags_priv,
 	},
 	[BATADV_ATTR_VLANID] = {
 		.name = "vlanid",
 		.cb = nljson_print_uint16,
+		.encode = nljson_encode_uint16,
 	},
 	[BATADV_ATTR_AGGREGATED_OGMS_ENABLED] = {
 		.name = "aggregated_ogms_enabled",
 		.cb = nljson_print_bool,
+		.encode = nljson_encode_bool,
 	},
 	[BATADV_ATTR_AP_ISOLATION_ENABLED] = {
 		.name = "ap_isolation_enabled",
 		.cb = nljson_print_bool,
+		.encode = nljson_encode_bool,
 	},
 	[BATADV_ATTR_ISOLATION_MARK] = {
 		.name = "isolation_mark",
 		.cb = nljson_print_uint32,
+		.encode = nljson_encode_uint32,
 	},
 	[BATADV_ATTR_ISOLATION_MASK] = {
 		.name = "isolation_mask",
 		.cb = nljson_print_uint32,
+		.encode = nljson_encode_uint32,
 	},
 	[BATADV_ATTR_BONDING_ENABLED] = {
 		.name = "bonding_enabled",
 		.cb = nljson_print_bool,
+		.encode = nljson_encode_bool,
 	},
 	[BATADV_ATTR_BRIDGE_LOOP_AVOIDANCE_ENABLED] = {
 		.name = "bridge_loop_avoidance_enabled",
 		.cb = nljson_print_bool,
+		.encode = nljson_encode_bool,
 	},
 	[BATADV_ATTR_DISTRIBUTED_ARP_TABLE_ENABLED] = {
 		.name = "distributed_arp_table_enabled",
 		.cb = nljson_print_bool,
+		.encode = nljson_encode_bool,
 	},
 	[BATADV_ATTR_FRAGMENTATION_ENABLED] = {
 		.name = "fragmentation_enabled",
 		.cb = nljson_print_bool,
+		.encode = nljson_encode_bool,
 	},
 	[BATADV_ATTR_GW_BANDWIDTH_DOWN] = {
 		.name = "gw_bandwidth_down",
 		.cb = nljson_print_uint32,
+		.encode = nljson_encode_uint32,
 	},
 	[BATADV_ATTR_GW_BANDWIDTH_UP] = {
 		.name = "gw_bandwidth_up",
 		.cb = nljson_print_uint32,
+		.encode = nljson_encode_uint32,
 	},
 	[BATADV_ATTR_GW_MODE] = {
 		.name = "gw_mode",
 		.cb = nljson_print_gwmode,
+		.encode = nljson_encode_gwmode,
 	},
 	[BATADV_ATTR_GW_SEL_CLASS] = {
 		.name = "gw_sel_class",
 		.cb = nljson_print_uint32,
+		.encode = nljson_encode_uint32,
 	},
 	[BATADV_ATTR_HOP_PENALTY] = {
 		.name = "hop_penalty",
 		.cb = nljson_print_uint8,
+		.encode = nljson_encode_uint8,
 	},
 	[BATADV_ATTR_LOG_LEVEL] = {
 		.name = "log_level",
 		.cb = nljson_print_loglevel,
+		.encode = nljson_encode_loglevel,
 	},
 	[BATADV_ATTR_MULTICAST_FORCEFLOOD_ENABLED] = {
 		.name = "multicast_forceflood_enabled",
 		.cb = nljson_print_bool,
+		.encode = nljson_encode_bool,
 	},
 	[BATADV_ATTR_NETWORK_CODING_ENABLED] = {
 		.name = "network_coding_enabled",
 		.cb = nljson_print_bool,
+		.encode = nljson_encode_bool,
 	},
 	[BATADV_ATTR_ORIG_INTERVAL] = {
 		.name = "orig_interval",
 		.cb = nljson_print_uint32,
+		.encode = nljson_encode_uint32,
 	},
 	[BATADV_ATTR_ELP_INTERVAL] = {
 		.name = "elp_interval",
 		.cb = nljson_print_uint32,
+		.encode = nljson_encode_uint32,
 	},
 	[BATADV_ATTR_THROUGHPUT_OVERRIDE] = {
 		.name = "throughput_override",
 		.cb = nljson_print_uint32,
+		.encode = nljson_encode_uint32,
 	},
 	[BATADV_ATTR_MULTICAST_FANOUT] = {
 		.name = "multicast_fanout",
 		.cb = nljson_print_uint32,
+		.encode = nljson_encode_uint32,
 	},
 };
 
+/* "name": prefixes of all attributes, escaped only once */
+static struct {
+	struct outbuf buf;
+	size_t off[NUM_BATADV_ATTR];
+	size_t len[NUM_BATADV_ATTR];
+	bool initialized;
+} nljson_keys;
+
+static int nljson_keys_init(void)
+{
+	size_t off;
+	int i;
+
+	if (nljson_keys.initialized)
+		return 0;
+
+	if (outbuf_init(&nljson_keys.buf, NULL) < 0)
+		return -ENOMEM;
+
+	for (i = 0; i < NUM_BATADV_ATTR; i++) {
+		if (!batadv_genl_json[i].cb)
+			continue;
+
+		off = nljson_keys.buf.len;
+		outbuf_putc(&nljson_keys.buf, '"');
+		sanitize_string(&nljson_keys.buf, batadv_genl_json[i].name);
+		outbuf_write(&nljson_keys.buf, "\":", 2);
+
+		nljson_keys.off[i] = off;
+		nljson_keys.len[i] = nljson_keys.buf.len - off;
+	}
+
+	if (nljson_keys.buf.error) {
+		outbuf_free(&nljson_keys.buf);
+		return -ENOMEM;
+	}
+
+	nljson_keys.initialized = true;
+
+	return 0;
+}
+
+/* remember which attributes the kernel sends for the queried command. The
+ * entries are then printed by walking only this (sorted) list instead of
+ * all BATADV_ATTR_MAX attribute slots
+ */
+static void nljson_learn_attrs(struct json_opts *json_opts,
+			       struct genlmsghdr *ghdr)
+{
+	bool changed = false;
+	struct nlattr *nla;
+	int type;
+	int rem;
+	int i;
+
+	nla_for_each_attr(nla, genlmsg_attrdata(ghdr, 0),
+			  genlmsg_attrlen(ghdr, 0), rem) {
+		type = nla_type(nla);
+		if (type > BATADV_ATTR_MAX || json_opts->attr_known[type])
+			continue;
+
+		json_opts->attr_known[type] = true;
+		changed = true;
+	}
+
+	if (!changed)
+		return;
+
+	json_opts->num_attrs = 0;
+	for (i = 0; i < NUM_BATADV_ATTR; i++) {
+		if (!json_opts->attr_known[i] || !batadv_genl_json[i].cb)
+			continue;
+
+		json_opts->attr_list[json_opts->num_attrs++] = i;
+	}
+}
+
+static void nljson_encode_entry(struct nlattr *attrs[],
+				struct json_opts *json_opts)
+{
+	struct binenc *enc = json_opts->enc;
+	unsigned int count = 0;
+	const char *name;
+	unsigned int i;
+	int idx;
+
+	for (i = 0; i < json_opts->num_attrs; i++) {
+		if (attrs[json_opts->attr_list[i]])
+			count++;
+	}
+
+	binenc_map(enc, count);
+	for (i = 0; i < json_opts->num_attrs; i++) {
+		idx = json_opts->attr_list[i];
+		if (!attrs[idx])
+			continue;
+
+		name = batadv_genl_json[idx].name;
+		binenc_str(enc, name, strlen(name));
+		batadv_genl_json[idx].encode(enc, attrs, idx);
+	}
+
+	json_opts->num_entries++;
+}
+
 void netlink_print_json_entries(struct nlattr *attrs[], struct json_opts *json_opts)
 {
+	struct outbuf *out = json_opts->out;
 	bool first_valid_attr = true;
-	int i;
+	unsigned int i;
+	int idx;
+
+	if (json_opts->enc) {
+		nljson_encode_entry(attrs, json_opts);
+		return;
+	}
 
 	if (!json_opts->is_first)
-		putchar(',');
+		outbuf_putc(out, ',');
 	else
 		json_opts->is_first = false;
 
-	putchar('{');
-	for (i = 0; i < BATADV_ATTR_MAX + 1; i++) {
-		if (!attrs[i])
-			continue;
-
-		if (!batadv_genl_json[i].cb)
+	outbuf_putc(out, '{');
+	for (i = 0; i < json_opts->num_attrs; i++) {
+		idx = json_opts->attr_list[i];
+		if (!attrs[idx])
 			continue;
 
 		if (!first_valid_attr)
-			putchar(',');
+			outbuf_putc(out, ',');
 		else
 			first_valid_attr = false;
 
-		putchar('"');
-		sanitize_string(batadv_genl_json[i].name);
-		putchar('"');
-		putchar(':');
-		batadv_genl_json[i].cb(attrs, i);
+		outbuf_write(out, &nljson_keys.buf.data[nljson_keys.off[idx]],
+			     nljson_keys.len[idx]);
+		batadv_genl_json[idx].cb(out, attrs, idx);
 	}
 
-	putchar('}');
+	outbuf_putc(out, '}');
 }
 
 static void json_query_usage(struct state *state)
@@ -503,6 +873,8 @@ static void json_query_usage(struct state *state)
 	fprintf(stderr, "Usage: batctl [options] %s|%s [parameters]\n",
 		state->cmd->name, state->cmd->abbr);
 	fprintf(stderr, "parameters:\n");
+	fprintf(stderr, " \t -f format output format: json (default), cbor or msgpack\n");
+	fprintf(stderr, " \t -F expr only print entries matching expr, e.g. 'vid==10 && orig==aa:bb:*'\n");
 	fprintf(stderr, " \t -h print this help\n");
 }
 
@@ -529,6 +901,10 @@ static int netlink_print_query_json_cb(struct nl_msg *msg, void *arg)
 		exit(1);
 	}
 
+	if (json_opts->filter && !filter_match(json_opts->filter, attrs))
+		return NL_OK;
+
+	nljson_learn_attrs(json_opts, ghdr);
 	netlink_print_json_entries(attrs, json_opts);
 
 	return NL_OK;
@@ -541,6 +917,7 @@ static int netlink_print_query_json_attributes(struct nl_msg *msg, void *arg)
 	switch (state->selector) {
 	case SP_NONE_OR_MESHIF:
 	case SP_MESHIF:
+	case SP_ALL_MESHIFS:
 		break;
 	case SP_VLAN:
 		nla_put_u16(msg, BATADV_ATTR_VLANID, state->vid);
@@ -553,19 +930,32 @@ static int netlink_print_query_json_attributes(struct nl_msg *msg, void *arg)
 	return 0;
 }
 
-static int netlink_print_query_json(struct state *state,
-				    struct json_query_data *json_query)
+int netlink_print_query_json(struct state *state, FILE *fp,
+			     struct filter *filter)
 {
+	struct json_query_data *json_query = state->cmd->arg;
+	struct outbuf out;
 	int ret;
 	struct json_opts json_opts = {
 		.is_first = true,
+		.out = &out,
+		.filter = filter,
+		.num_attrs = 0,
 		.query_opts = {
 			.err = 0,
 		},
 	};
 
+	ret = nljson_keys_init();
+	if (ret < 0)
+		return ret;
+
+	ret = outbuf_init(&out, fp);
+	if (ret < 0)
+		return ret;
+
 	if (json_query->nlm_flags & NLM_F_DUMP)
-		putchar('[');
+		outbuf_putc(&out, '[');
 
 	ret = netlink_query_common(state, state->mesh_ifindex,
 				   json_query->cmd,
@@ -575,30 +965,128 @@ static int netlink_print_query_json(struct state *state,
 				   &json_opts.query_opts);
 
 	if (json_query->nlm_flags & NLM_F_DUMP)
-		puts("]");
+		outbuf_write(&out, "]\n", 2);
 	else
-		putchar('\n');
+		outbuf_putc(&out, '\n');
+
+	outbuf_flush(&out);
+	outbuf_free(&out);
 
 	return ret;
 }
 
-int handle_json_query(struct state *state, int argc, char **argv)
+/* the same query, encoded as CBOR or MessagePack */
+static int netlink_print_query_binary(struct state *state, FILE *fp,
+				      enum binenc_format format,
+				      struct filter *filter)
 {
 	struct json_query_data *json_query = state->cmd->arg;
+	bool is_dump = json_query->nlm_flags & NLM_F_DUMP;
+	struct outbuf entries;
+	struct outbuf out;
+	struct binenc enc = {
+		.format = format,
+		.out = &out,
+	};
+	struct json_opts json_opts = {
+		.is_first = true,
+		.out = NULL,
+		.enc = &enc,
+		.filter = filter,
+		.num_attrs = 0,
+		.num_entries = 0,
+		.query_opts = {
+			.err = 0,
+		},
+	};
+	int ret;
+
+	ret = outbuf_init(&out, fp);
+	if (ret < 0)
+		return ret;
+
+	/* the array length is only known after the dump */
+	if (is_dump) {
+		ret = outbuf_init(&entries, NULL);
+		if (ret < 0) {
+			outbuf_free(&out);
+			return ret;
+		}
+
+		enc.out = &entries;
+	}
+
+	ret = netlink_query_common(state, state->mesh_ifindex,
+				   json_query->cmd,
+				   netlink_print_query_json_cb,
+				   netlink_print_query_json_attributes,
+				   json_query->nlm_flags,
+				   &json_opts.query_opts);
+
+	if (is_dump) {
+		enc.out = &out;
+		binenc_array(&enc, json_opts.num_entries);
+		outbuf_write(&out, entries.data, entries.len);
+		outbuf_free(&entries);
+	}
+
+	outbuf_flush(&out);
+	outbuf_free(&out);
+
+	return ret;
+}
+
+int handle_json_query(struct state *state, int argc, char **argv)
+{
+	enum binenc_format format = BINENC_CBOR;
+	struct filter *filter = NULL;
+	bool binary = false;
 	int optchar;
 	int err;
 
-	while ((optchar = getopt(argc, argv, "h")) != -1) {
+	while ((optchar = getopt(argc, argv, "f:hF:")) != -1) {
 		switch (optchar) {
+		case 'f':
+			if (strcmp(optarg, "json") == 0) {
+				binary = false;
+			} else if (strcmp(optarg, "cbor") == 0) {
+				binary = true;
+				format = BINENC_CBOR;
+			} else if (strcmp(optarg, "msgpack") == 0) {
+				binary = true;
+				format = BINENC_MSGPACK;
+			} else {
+				fprintf(stderr, "Error - unknown output format: %s\n",
+					optarg);
+				json_query_usage(state);
+				filter_free(filter);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'F':
+			filter_free(filter);
+			filter = filter_compile(optarg);
+			if (!filter)
+				return EXIT_FAILURE;
+			break;
 		case 'h':
 			json_query_usage(state);
+			filter_free(filter);
 			return EXIT_SUCCESS;
+		default:
+			json_query_usage(state);
+			filter_free(filter);
+			return EXIT_FAILURE;
 		}
 	}
 
 	check_root_or_die("batctl");
 
-	err = netlink_print_query_json(state, json_query);
+	if (binary)
+		err = netlink_print_query_binary(state, stdout, format, filter);
+	else
+		err = netlink_print_query_json(state, stdout, filter);
 
+	filter_free(filter);
 	return err;
 }
@@ -9,13 +9,26 @@
 #ifndef _BATCTL_GENLJSON_H
 #define _BATCTL_GENLJSON_H
 
+#include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 
 #include "batman_adv.h"
 #include "netlink.h"
 
+struct binenc;
+struct filter;
+struct outbuf;
+
 struct json_opts {
 	uint8_t is_first:1;
+	struct outbuf *out;
+	struct binenc *enc;
+	struct filter *filter;
+	bool attr_known[NUM_BATADV_ATTR];
+	uint8_t attr_list[NUM_BATADV_ATTR];
+	unsigned int num_attrs;
+	unsigned int num_entries;
 	struct nlquery_opts query_opts;
 };
 
@@ -25,6 +38,8 @@ struct json_query_data {
 };
 
 void netlink_print_json_entries(struct nlattr *attrs[], struct json_opts *json_opts);
+int netlink_print_query_json(struct state *state, FILE *fp,
+			     struct filter *filter);
 int handle_json_query(struct state *state, int argc, char **argv);
 
 #endif /* _BATCTL_GENLJSON_H */
@@ -10,7 +10,26 @@
 #include "hash.h"
 #include <stdlib.h>
 #include <stdio.h>
-#include "allocate.h"
+
+/* one-at-a-time hash over len bytes, usable by the choose callbacks */
+uint32_t hash_bytes(const void *data, size_t len)
+{
+	const unsigned char *key = data;
+	uint32_t hash = 0;
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		hash += key[i];
+		hash += (hash << 10);
+		hash ^= (hash >> 6);
+	}
+
+	hash += (hash << 3);
+	hash ^= (hash >> 11);
+	hash += (hash << 15);
+
+	return hash;
+}
 
 /* clears the hash */
 void hash_init(struct hashtable_t *hash)
@@ -41,7 +60,7 @@ void hash_delete(struct hashtable_t *hash, hashdata_free_cb free_cb)
 
 			last_bucket = bucket;
 			bucket = bucket->next;
-			debugFree(last_bucket, 1301);
+			free(last_bucket);
 
 		}
 
@@ -87,14 +106,14 @@ static int hash_add_bucket(struct hashtable_t *hash, void *data,
 /* free only the hashtable and the hash itself. */
 void hash_destroy(struct hashtable_t *hash)
 {
-	debugFree(hash->table, 1302);
-	debugFree(hash, 1303);
+	free(hash->table);
+	free(hash);
 }
 
 /* free hash_it_t pointer when stopping hash_iterate early */
 void hash_iterate_free(struct hash_it_t *iter_in)
 {
-	debugFree(iter_in, 1304);
+	free(iter_in);
 }
 
 /* iterate though the hash. first element is selected with iter_in NULL.
@@ -106,7 +125,7 @@ struct hash_it_t *hash_iterate(struct hashtable_t *hash,
 	struct hash_it_t *iter;
 
 	if (iter_in == NULL) {
-		iter = debugMalloc(sizeof(struct hash_it_t), 301);
+		iter = malloc(sizeof(struct hash_it_t));
 		if (!iter)
 			return NULL;
 
@@ -189,15 +208,15 @@ struct hashtable_t *hash_new(int size, hashdata_compare_cb compare,
 {
 	struct hashtable_t *hash;
 
-	hash = debugMalloc(sizeof(struct hashtable_t), 302);
+	hash = malloc(sizeof(struct hashtable_t));
 	if (!hash)
 		return NULL;
 
 	hash->size = size;
-	hash->table = debugMalloc(sizeof(struct element_t *)*size, 303);
+	hash->table = malloc(sizeof(struct element_t *)*size);
 
 	if (!hash->table) {
-		debugFree(hash, 1305);
+		free(hash);
 		return NULL;
 	}
 
@@ -214,14 +233,14 @@ int hash_add(struct hashtable_t *hash, void *data)
 	struct element_t *bucket;
 
 	/* found the tail of the list, add new element */
-	bucket = debugMalloc(sizeof(struct element_t), 304);
+	bucket = malloc(sizeof(struct element_t));
 
 	if (!bucket)
 		return -1;
 
 	ret = hash_add_bucket(hash, data, bucket, 1);
 	if (ret < 0)
-		debugFree(bucket, 1307);
+		free(bucket);
 
 	return ret;
 }
@@ -262,7 +281,7 @@ void *hash_remove_bucket(struct hashtable_t *hash, struct hash_it_t *hash_it_t)
 	else if (hash_it_t->first_bucket != NULL)
 		(*hash_it_t->first_bucket) = hash_it_t->bucket->next;
 
-	debugFree(hash_it_t->bucket, 1306);
+	free(hash_it_t->bucket);
 
 	hash->elements--;
 	return data_save;
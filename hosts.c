@@ -0,0 +1,61 @@
+// SPDX-License-Identifier: GPL-2.0
+/* Copyright (C) B.A.T.M.A.N. contributors:
+ *
+ * License-Filename: LICENSES/preferred/GPL-2.0
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bat-hosts.h"
+#include "functions.h"
+#include "main.h"
+
+static void hosts_usage(void)
+{
+	fprintf(stderr, "Usage: batctl [options] hosts compile\n");
+	fprintf(stderr, "parameters:\n");
+	fprintf(stderr, " \t -h print this help\n");
+}
+
+static int hosts(struct state *state __maybe_unused, int argc, char **argv)
+{
+	int optchar;
+	int ret;
+
+	while ((optchar = getopt(argc, argv, "h")) != -1) {
+		switch (optchar) {
+		case 'h':
+			hosts_usage();
+			return EXIT_SUCCESS;
+		default:
+			hosts_usage();
+			return EXIT_FAILURE;
+		}
+	}
+
+	argc -= optind;
+	argv += optind;
+
+	if (argc != 1 || strcmp(argv[0], "compile") != 0) {
+		hosts_usage();
+		return EXIT_FAILURE;
+	}
+
+	ret = bat_hosts_compile(USE_BAT_HOSTS);
+	bat_hosts_free();
+
+	if (ret < 0) {
+		fprintf(stderr, "Error - could not write %s: %s\n",
+			BAT_HOSTS_CACHE, strerror(-ret));
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+COMMAND(SUBCOMMAND, hosts, "hs", 0, NULL,
+	"compile \tprecompile the bat-hosts files into " BAT_HOSTS_CACHE);
@@ -526,4 +526,6 @@ void icmp_interfaces_clean(void)
 
 	list_for_each_entry_safe(iface, safe, &interface_list, list)
 		icmp_interface_destroy(iface);
+
+	netlink_orig_cache_flush();
 }
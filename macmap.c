@@ -0,0 +1,429 @@
+// SPDX-License-Identifier: GPL-2.0
+/* Copyright (C) B.A.T.M.A.N. contributors:
+ *
+ * License-Filename: LICENSES/preferred/GPL-2.0
+ */
+
+#include <endian.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "macmap.h"
+
+#define MACMAP_GROUP 8
+#define MACMAP_MIN_SLOTS MACMAP_GROUP
+
+/* slots of the previous table moved by each macmap_add()/macmap_remove() */
+#define MACMAP_MOVE_SLOTS 32
+
+/* control bytes of slots with an entry have the top bit set and hold 7 bits
+ * of the hash of their key. Empty is 0, so fresh tables come from calloc()
+ */
+#define MACMAP_EMPTY 0x00
+#define MACMAP_DELETED 0x01
+#define MACMAP_FULL 0x80
+
+#define MACMAP_LSB 0x0101010101010101ULL
+#define MACMAP_MSB 0x8080808080808080ULL
+
+static uint64_t macmap_hash(uint64_t key)
+{
+	uint64_t hash = key * 0x9e3779b97f4a7c15ULL;
+
+	return hash ^ (hash >> 32);
+}
+
+static uint8_t macmap_tag(uint64_t hash)
+{
+	return MACMAP_FULL | (hash & 0x7f);
+}
+
+/* the control bytes of a group, the byte of the first slot is the lowest */
+static uint64_t macmap_group(const uint8_t *ctrl)
+{
+	uint64_t group;
+
+	memcpy(&group, ctrl, sizeof(group));
+
+	return le64toh(group);
+}
+
+/* top bit of every zero byte. Bytes above a zero byte can also be reported,
+ * so the result is only exact in telling whether there is a zero byte
+ */
+static uint64_t macmap_match_zero(uint64_t group)
+{
+	return (group - MACMAP_LSB) & ~group & MACMAP_MSB;
+}
+
+/* the key of every reported slot has to be compared */
+static uint64_t macmap_match_tag(uint64_t group, uint8_t tag)
+{
+	return macmap_match_zero(group ^ (MACMAP_LSB * tag));
+}
+
+/* only tells whether the group has an empty slot */
+static uint64_t macmap_match_empty(uint64_t group)
+{
+	return macmap_match_zero(group);
+}
+
+static uint64_t macmap_match_free(uint64_t group)
+{
+	return ~group & MACMAP_MSB;
+}
+
+static uint32_t macmap_match_next(uint64_t *match)
+{
+	uint32_t pos = __builtin_ctzll(*match) / 8;
+
+	*match &= *match - 1;
+
+	return pos;
+}
+
+static uint32_t macmap_max_used(uint32_t num_slots)
+{
+	return num_slots / 8 * 7;
+}
+
+static int macmap_num_slots(size_t size, uint32_t *num_slots)
+{
+	uint32_t slots = MACMAP_MIN_SLOTS;
+
+	while (macmap_max_used(slots) < size) {
+		if (slots > UINT32_MAX / 2)
+			return -ENOMEM;
+
+		slots *= 2;
+	}
+
+	*num_slots = slots;
+	return 0;
+}
+
+/* groups are probed at triangular offsets, which visits every group of a
+ * table with a power of two groups once
+ */
+static uint32_t macmap_probe_first(const struct macmap_table *table,
+				   uint64_t hash)
+{
+	return (hash >> 7) & table->mask & ~(MACMAP_GROUP - 1);
+}
+
+static uint32_t macmap_probe_next(const struct macmap_table *table,
+				  uint32_t pos, uint32_t *step)
+{
+	*step += MACMAP_GROUP;
+
+	return (pos + *step) & table->mask;
+}
+
+/* first empty or deleted slot in the probe sequence of hash. The table
+ * always has an empty slot
+ */
+static uint32_t macmap_find_free(const struct macmap_table *table,
+				 uint64_t hash)
+{
+	uint32_t pos = macmap_probe_first(table, hash);
+	uint32_t step = 0;
+	uint64_t match;
+
+	for (;;) {
+		match = macmap_match_free(macmap_group(&table->ctrl[pos]));
+		if (match)
+			return pos + macmap_match_next(&match);
+
+		pos = macmap_probe_next(table, pos, &step);
+	}
+}
+
+static int macmap_table_alloc(struct macmap_table *table, uint32_t num_slots)
+{
+	void *slots;
+
+	/* the control bytes are stored behind the slots */
+	slots = calloc(num_slots, sizeof(*table->slots) + 1);
+	if (!slots)
+		return -ENOMEM;
+
+	table->slots = slots;
+	table->ctrl = (uint8_t *)&table->slots[num_slots];
+	table->mask = num_slots - 1;
+	table->used = 0;
+
+	return 0;
+}
+
+static void macmap_table_free(struct macmap_table *table)
+{
+	free(table->slots);
+	memset(table, 0, sizeof(*table));
+}
+
+static void macmap_table_insert(struct macmap_table *table, uint64_t key,
+				uint64_t hash, void *data)
+{
+	uint32_t pos = macmap_find_free(table, hash);
+
+	if (table->ctrl[pos] == MACMAP_EMPTY)
+		table->used++;
+
+	table->ctrl[pos] = macmap_tag(hash);
+	table->slots[pos].key = key;
+	table->slots[pos].data = data;
+}
+
+static int macmap_table_lookup(const struct macmap_table *table, uint64_t key,
+			       uint64_t hash, uint32_t *found)
+{
+	uint8_t tag = macmap_tag(hash);
+	uint32_t pos = macmap_probe_first(table, hash);
+	uint32_t step = 0;
+	uint64_t match;
+	uint64_t group;
+	uint32_t i;
+
+	for (;;) {
+		group = macmap_group(&table->ctrl[pos]);
+
+		match = macmap_match_tag(group, tag);
+		while (match) {
+			i = pos + macmap_match_next(&match);
+			if (table->slots[i].key == key) {
+				*found = i;
+				return 0;
+			}
+		}
+
+		/* the key would have been stored in the empty slot */
+		if (macmap_match_empty(group))
+			return -ENOENT;
+
+		pos = macmap_probe_next(table, pos, &step);
+	}
+}
+
+static void macmap_table_erase(struct macmap_table *table, uint32_t pos)
+{
+	uint32_t group = pos & ~(MACMAP_GROUP - 1);
+
+	/* lookups only continue behind groups which were full when the key
+	 * was added. Such a group never gets an empty slot again, so a group
+	 * with an empty slot never had a probe pass through it
+	 */
+	if (macmap_match_empty(macmap_group(&table->ctrl[group]))) {
+		table->ctrl[pos] = MACMAP_EMPTY;
+		table->used--;
+	} else {
+		table->ctrl[pos] = MACMAP_DELETED;
+	}
+}
+
+/* the entries of the previous table are only valid from old_pos on */
+static int macmap_old_lookup(const struct macmap *map, uint64_t key,
+			     uint64_t hash, uint32_t *found)
+{
+	if (!map->old.slots)
+		return -ENOENT;
+
+	if (macmap_table_lookup(&map->old, key, hash, found) < 0)
+		return -ENOENT;
+
+	if (*found < map->old_pos)
+		return -ENOENT;
+
+	return 0;
+}
+
+/* move up to num slots of the previous table into the current one */
+static void macmap_move(struct macmap *map, uint32_t num)
+{
+	struct macmap_slot *slot;
+
+	while (map->old.slots && num--) {
+		if (map->old_pos > map->old.mask) {
+			macmap_table_free(&map->old);
+			map->old_pos = 0;
+			break;
+		}
+
+		slot = &map->old.slots[map->old_pos];
+		if (map->old.ctrl[map->old_pos] & MACMAP_FULL)
+			macmap_table_insert(&map->table, slot->key,
+					    macmap_hash(slot->key), slot->data);
+
+		map->old_pos++;
+	}
+}
+
+/* replace the current table with an empty one for size entries and keep
+ * the current one as previous table
+ */
+static int macmap_grow(struct macmap *map, size_t size)
+{
+	struct macmap_table table;
+	uint32_t num_slots;
+
+	/* only one previous table at a time */
+	macmap_move(map, UINT32_MAX);
+
+	if (size < map->elements)
+		size = map->elements;
+
+	if (macmap_num_slots(size, &num_slots) < 0)
+		return -ENOMEM;
+
+	if (macmap_table_alloc(&table, num_slots) < 0)
+		return -ENOMEM;
+
+	map->old = map->table;
+	map->old_pos = 0;
+	map->table = table;
+
+	return 0;
+}
+
+int macmap_init(struct macmap *map, size_t size)
+{
+	uint32_t num_slots;
+
+	memset(map, 0, sizeof(*map));
+
+	if (macmap_num_slots(size, &num_slots) < 0)
+		return -ENOMEM;
+
+	return macmap_table_alloc(&map->table, num_slots);
+}
+
+void macmap_destroy(struct macmap *map, void (*free_cb)(void *data))
+{
+	uint32_t iter = 0;
+	void *data;
+
+	if (free_cb) {
+		while ((data = macmap_iterate(map, &iter)))
+			free_cb(data);
+	}
+
+	macmap_table_free(&map->table);
+	macmap_table_free(&map->old);
+	memset(map, 0, sizeof(*map));
+}
+
+int macmap_resize(struct macmap *map, size_t size)
+{
+	if (!map->table.slots)
+		return -ENOMEM;
+
+	if (macmap_grow(map, size) < 0)
+		return -ENOMEM;
+
+	macmap_move(map, UINT32_MAX);
+
+	return 0;
+}
+
+int macmap_add(struct macmap *map, uint64_t key, void *data)
+{
+	uint64_t hash = macmap_hash(key);
+	uint32_t pos;
+
+	if (!map->table.slots)
+		return -ENOMEM;
+
+	if (macmap_table_lookup(&map->table, key, hash, &pos) == 0 ||
+	    macmap_old_lookup(map, key, hash, &pos) == 0)
+		return -EEXIST;
+
+	macmap_move(map, MACMAP_MOVE_SLOTS);
+
+	/* double the number of slots or only drop the deleted slots when
+	 * they fill most of the table. The new table also has room for one
+	 * entry per macmap_add()/macmap_remove() until all slots are moved,
+	 * so it never fills up before that
+	 */
+	if (map->table.used + 1 > macmap_max_used(map->table.mask + 1) &&
+	    macmap_grow(map, (size_t)map->elements * 3 / 2 + 2 +
+			     (map->table.mask + 1) / MACMAP_MOVE_SLOTS) < 0)
+		return -ENOMEM;
+
+	macmap_table_insert(&map->table, key, hash, data);
+	map->elements++;
+
+	return 0;
+}
+
+void *macmap_find(const struct macmap *map, uint64_t key)
+{
+	uint64_t hash = macmap_hash(key);
+	uint32_t pos;
+
+	if (!map->table.slots)
+		return NULL;
+
+	if (macmap_table_lookup(&map->table, key, hash, &pos) == 0)
+		return map->table.slots[pos].data;
+
+	if (macmap_old_lookup(map, key, hash, &pos) == 0)
+		return map->old.slots[pos].data;
+
+	return NULL;
+}
+
+void *macmap_remove(struct macmap *map, uint64_t key)
+{
+	uint64_t hash = macmap_hash(key);
+	void *data;
+	uint32_t pos;
+
+	if (!map->table.slots)
+		return NULL;
+
+	if (macmap_table_lookup(&map->table, key, hash, &pos) == 0) {
+		data = map->table.slots[pos].data;
+		macmap_table_erase(&map->table, pos);
+	} else if (macmap_old_lookup(map, key, hash, &pos) == 0) {
+		data = map->old.slots[pos].data;
+		macmap_table_erase(&map->old, pos);
+	} else {
+		return NULL;
+	}
+
+	map->elements--;
+	macmap_move(map, MACMAP_MOVE_SLOTS);
+
+	return data;
+}
+
+void *macmap_iterate(const struct macmap *map, uint32_t *iter)
+{
+	uint32_t num_slots = map->table.slots ? map->table.mask + 1 : 0;
+	uint32_t pos;
+
+	/* the current table first, then the remaining slots of the previous
+	 * one
+	 */
+	while (*iter < num_slots) {
+		pos = (*iter)++;
+
+		if (map->table.ctrl[pos] & MACMAP_FULL)
+			return map->table.slots[pos].data;
+	}
+
+	if (!map->old.slots)
+		return NULL;
+
+	if (*iter < num_slots + map->old_pos)
+		*iter = num_slots + map->old_pos;
+
+	while (*iter - num_slots <= map->old.mask) {
+		pos = (*iter)++ - num_slots;
+
+		if (map->old.ctrl[pos] & MACMAP_FULL)
+			return map->old.slots[pos].data;
+	}
+
+	return NULL;
+}
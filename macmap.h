@@ -0,0 +1,88 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/* Copyright (C) B.A.T.M.A.N. contributors:
+ *
+ * License-Filename: LICENSES/preferred/GPL-2.0
+ */
+
+#ifndef _BATCTL_MACMAP_H
+#define _BATCTL_MACMAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* hash table for keys of up to 64 bit, usually a packed mac address
+ *
+ * The slots are split into aligned groups of 8. Every slot has a control
+ * byte which is either empty, deleted or holds 7 bits of the hash of its key.
+ * A lookup loads the 8 control bytes of a group as one word and compares
+ * them all at once, only slots with a matching control byte are compared
+ * with the key. The number of slots is a power of two and the table grows
+ * by itself when it is 7/8 used.
+ *
+ * Growing does not move all entries at once. The previous table is kept and
+ * every macmap_add() and macmap_remove() moves a few of its slots over, so a
+ * single insert never pays for a whole rehash. Lookups consult both tables
+ * until the move is done.
+ */
+struct macmap_slot {
+	uint64_t key;
+	void *data;
+};
+
+struct macmap_table {
+	struct macmap_slot *slots;
+	uint8_t *ctrl;
+	uint32_t mask;		/* number of slots - 1 */
+	uint32_t used;		/* entries + deleted slots */
+};
+
+struct macmap {
+	struct macmap_table table;
+	/* previous table while growing, slots before old_pos are moved */
+	struct macmap_table old;
+	uint32_t old_pos;
+	uint32_t elements;	/* in both tables */
+};
+
+/* packs the 6 bytes of a mac address into the lower 48 bit of the key. The
+ * keys sort like the addresses
+ */
+static inline uint64_t macmap_key(const void *mac)
+{
+	const uint8_t *addr = mac;
+
+	return (uint64_t)addr[0] << 40 | (uint64_t)addr[1] << 32 |
+	       (uint64_t)addr[2] << 24 | (uint64_t)addr[3] << 16 |
+	       (uint64_t)addr[4] << 8 | (uint64_t)addr[5];
+}
+
+/* prepare an empty table with room for at least size entries. returns 0 on
+ * success, -ENOMEM on error
+ */
+int macmap_init(struct macmap *map, size_t size);
+
+/* free the table. if free_cb != NULL it is called for every data pointer */
+void macmap_destroy(struct macmap *map, void (*free_cb)(void *data));
+
+/* returns 0 on success, -EEXIST if key is already used or -ENOMEM */
+int macmap_add(struct macmap *map, uint64_t key, void *data);
+
+/* returns the data of key or NULL */
+void *macmap_find(const struct macmap *map, uint64_t key);
+
+/* returns the data of the removed key or NULL */
+void *macmap_remove(struct macmap *map, uint64_t key);
+
+/* resize the table to hold at least size entries and finish moving the
+ * entries of a previous table. returns 0 on success, -ENOMEM on error (the
+ * table stays usable)
+ */
+int macmap_resize(struct macmap *map, size_t size);
+
+/* returns the data of the next entry after position *iter and advances
+ * *iter, or NULL after the last entry. Start with *iter = 0. The table must
+ * not be modified while iterating.
+ */
+void *macmap_iterate(const struct macmap *map, uint32_t *iter);
+
+#endif /* _BATCTL_MACMAP_H */
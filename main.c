@@ -15,6 +15,7 @@
 #include <string.h>
 
 #include "main.h"
+#include "allmesh.h"
 #include "sys.h"
 #include "debug.h"
 #include "functions.h"
@@ -166,7 +167,7 @@ static const struct command *find_command_by_types(uint32_t types,
 	return NULL;
 }
 
-static const struct command *find_command(struct state *state, const char *name)
+const struct command *find_command(struct state *state, const char *name)
 {
 	uint32_t types = 0;
 
@@ -187,6 +188,10 @@ static const struct command *find_command(struct state *state, const char *name)
 		types = BIT(JSON_HIF) |
 			BIT(SUBCOMMAND_HIF);
 		break;
+	case SP_ALL_MESHIFS:
+		types = BIT(DEBUGTABLE) |
+			BIT(JSON_MIF);
+		break;
 	default:
 		return NULL;
 	}
@@ -230,6 +235,12 @@ static int guess_selector_prefix(int argc, char *argv[],
 	if (argc < 1)
 		return -EINVAL;
 
+	/* run the command for each mesh interface */
+	if (strcmp(argv[0], "all") == 0) {
+		*selector = SP_ALL_MESHIFS;
+		return 1;
+	}
+
 	/* don't try to parse subcommand names as network interface */
 	if (find_command_by_types(0xffffffff, argv[0]))
 		return -EEXIST;
@@ -257,6 +268,11 @@ static int parse_meshif_args(struct state *state, int argc, char *argv[])
 
 	switch (selector) {
 	case SP_MESHIF:
+		if (strcmp(dev_arg, "all") == 0) {
+			state->selector = SP_ALL_MESHIFS;
+			return parsed_args;
+		}
+
 		snprintf(state->mesh_iface, sizeof(state->mesh_iface), "%s",
 			 dev_arg);
 		state->selector = SP_MESHIF;
@@ -280,6 +296,9 @@ static int parse_meshif_args(struct state *state, int argc, char *argv[])
 		snprintf(state->hard_iface, sizeof(state->hard_iface), "%s",
 			 dev_arg);
 		return parsed_args;
+	case SP_ALL_MESHIFS:
+		state->selector = SP_ALL_MESHIFS;
+		return parsed_args;
 	case SP_NONE_OR_MESHIF:
 		/* not allowed - see detect_selector_prefix */
 		break;
@@ -291,7 +310,7 @@ static int parse_meshif_args(struct state *state, int argc, char *argv[])
 	return 0;
 }
 
-static int parse_dev_args(struct state *state, int argc, char *argv[])
+int parse_dev_args(struct state *state, int argc, char *argv[])
 {
 	int dev_arguments;
 	int ret;
@@ -399,6 +418,9 @@ int main(int argc, char **argv)
 
 	state.cmd = cmd;
 
+	if (state.selector == SP_ALL_MESHIFS)
+		return allmesh_run(&state, argc, argv);
+
 	if (cmd->flags & COMMAND_FLAG_MESH_IFACE &&
 	    check_mesh_iface(&state) < 0) {
 		fprintf(stderr,
@@ -61,6 +61,7 @@ enum selector_prefix {
 	SP_MESHIF,
 	SP_VLAN,
 	SP_HARDIF,
+	SP_ALL_MESHIFS,
 };
 
 enum command_type {
@@ -117,4 +118,7 @@ struct command {
 #define COMMAND(_type, _handler, _abbr, _flags, _arg, _usage) \
 	COMMAND_NAMED(_type, _handler, _abbr, _handler, _flags, _arg, _usage)
 
+const struct command *find_command(struct state *state, const char *name);
+int parse_dev_args(struct state *state, int argc, char *argv[]);
+
 #endif
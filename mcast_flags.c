@@ -24,78 +24,78 @@
 #include "functions.h"
 #include "main.h"
 #include "netlink.h"
+#include "output.h"
+#include "tablefmt.h"
 
 static const int mcast_flags_mandatory[] = {
 	BATADV_ATTR_ORIG_ADDRESS,
 };
 
-static int mcast_flags_callback(struct nl_msg *msg, void *arg)
-{
-	struct nlattr *attrs[BATADV_ATTR_MAX+1];
-	struct nlmsghdr *nlh = nlmsg_hdr(msg);
-	struct print_opts *opts = arg;
-	struct bat_host *bat_host;
-	struct genlmsghdr *ghdr;
-	uint32_t flags;
-	uint8_t *addr;
+static const struct table_column mcast_flags_columns[] = {
+	{ "orig_address", BATADV_ATTR_ORIG_ADDRESS, table_column_mac },
+	{ "mcast_flags", BATADV_ATTR_MCAST_FLAGS, table_column_u32 },
+};
 
-	if (!genlmsg_valid_hdr(nlh, 0)) {
-		fputs("Received invalid data from kernel.\n", stderr);
-		exit(1);
-	}
+static bool mcast_flags_match(struct nlattr *attrs[],
+			      const struct print_opts *opts)
+{
+	uint8_t *addr = nla_data(attrs[BATADV_ATTR_ORIG_ADDRESS]);
 
-	ghdr = nlmsg_data(nlh);
+	if (opts->read_opt & MULTICAST_ONLY && !(addr[0] & 0x01))
+		return false;
 
-	if (ghdr->cmd != BATADV_CMD_GET_MCAST_FLAGS)
-		return NL_OK;
+	if (opts->read_opt & UNICAST_ONLY && (addr[0] & 0x01))
+		return false;
 
-	if (nla_parse(attrs, BATADV_ATTR_MAX, genlmsg_attrdata(ghdr, 0),
-		      genlmsg_len(ghdr), batadv_netlink_policy)) {
-		fputs("Received invalid data from kernel.\n", stderr);
-		exit(1);
-	}
+	return true;
+}
 
-	if (missing_mandatory_attrs(attrs, mcast_flags_mandatory,
-				    ARRAY_SIZE(mcast_flags_mandatory))) {
-		fputs("Missing attributes from kernel\n", stderr);
-		exit(1);
-	}
+static void mcast_flags_print(struct nlattr *attrs[], struct print_opts *opts)
+{
+	struct bat_host *bat_host;
+	uint32_t flags;
+	uint8_t *addr;
 
 	addr = nla_data(attrs[BATADV_ATTR_ORIG_ADDRESS]);
 
-	if (opts->read_opt & MULTICAST_ONLY && !(addr[0] & 0x01))
-		return NL_OK;
-
-	if (opts->read_opt & UNICAST_ONLY && (addr[0] & 0x01))
-		return NL_OK;
-
 	bat_host = bat_hosts_find_by_mac((char *)addr);
 	if (!(opts->read_opt & USE_BAT_HOSTS) || !bat_host)
-		printf("%02x:%02x:%02x:%02x:%02x:%02x ",
-		       addr[0], addr[1], addr[2],
-		       addr[3], addr[4], addr[5]);
+		outbuf_mac(opts->out, addr);
 	else
-		printf("%17s ", bat_host->name);
+		outbuf_str(opts->out, bat_host->name, 17);
+	outbuf_putc(opts->out, ' ');
 
 	if (attrs[BATADV_ATTR_MCAST_FLAGS]) {
 		flags = nla_get_u32(attrs[BATADV_ATTR_MCAST_FLAGS]);
 
-		printf("[%c%c%c%s%s]\n",
-		       flags & BATADV_MCAST_WANT_ALL_UNSNOOPABLES ? 'U' : '.',
-		       flags & BATADV_MCAST_WANT_ALL_IPV4 ? '4' : '.',
-		       flags & BATADV_MCAST_WANT_ALL_IPV6 ? '6' : '.',
-		       !(flags & BATADV_MCAST_WANT_NO_RTR4) ? "R4" : ". ",
-		       !(flags & BATADV_MCAST_WANT_NO_RTR6) ? "R6" : ". ");
+		outbuf_putc(opts->out, '[');
+		outbuf_putc(opts->out,
+			    flags & BATADV_MCAST_WANT_ALL_UNSNOOPABLES ? 'U' : '.');
+		outbuf_putc(opts->out,
+			    flags & BATADV_MCAST_WANT_ALL_IPV4 ? '4' : '.');
+		outbuf_putc(opts->out,
+			    flags & BATADV_MCAST_WANT_ALL_IPV6 ? '6' : '.');
+		outbuf_str(opts->out,
+			   !(flags & BATADV_MCAST_WANT_NO_RTR4) ? "R4" : ". ", 0);
+		outbuf_str(opts->out,
+			   !(flags & BATADV_MCAST_WANT_NO_RTR6) ? "R6" : ". ", 0);
+		outbuf_str(opts->out, "]\n", 0);
 	} else {
-		printf("-\n");
+		outbuf_str(opts->out, "-\n", 0);
 	}
-
-	return NL_OK;
 }
 
+static const struct table_rows mcast_flags_rows = {
+	.mandatory = mcast_flags_mandatory,
+	.num_mandatory = ARRAY_SIZE(mcast_flags_mandatory),
+	.match = mcast_flags_match,
+	.print = mcast_flags_print,
+};
+
 static int netlink_print_mcast_flags(struct state *state, char *orig_iface,
 				     int read_opts, float orig_timeout,
-				     float watch_interval)
+				     float watch_interval,
+				     const struct table_opts *table)
 {
 	char querier4, querier6, shadowing4, shadowing6;
 	char *info_header;
@@ -146,7 +146,7 @@ static int netlink_print_mcast_flags(struct state *state, char *orig_iface,
 	ret = netlink_print_common(state, orig_iface, read_opts,
 				   orig_timeout, watch_interval, header,
 				   BATADV_CMD_GET_MCAST_FLAGS,
-				   mcast_flags_callback);
+				   &mcast_flags_rows, table);
 
 	free(header);
 	return ret;
@@ -154,6 +154,8 @@ static int netlink_print_mcast_flags(struct state *state, char *orig_iface,
 
 static struct debug_table_data batctl_debug_table_mcast_flags = {
 	.netlink_fn = netlink_print_mcast_flags,
+	.columns = mcast_flags_columns,
+	.num_columns = ARRAY_SIZE(mcast_flags_columns),
 };
 
 COMMAND_NAMED(DEBUGTABLE, mcast_flags, "mf", handle_debug_table,
@@ -0,0 +1,819 @@
+// SPDX-License-Identifier: GPL-2.0
+/* Copyright (C) B.A.T.M.A.N. contributors:
+ *
+ * License-Filename: LICENSES/preferred/GPL-2.0
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <linux/ethtool.h>
+#include <net/if.h>
+#include <netlink/genl/genl.h>
+#include <netlink/netlink.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "batadv_packet.h"
+#include "batman_adv.h"
+#include "functions.h"
+#include "hash.h"
+#include "main.h"
+#include "netlink.h"
+#include "output.h"
+
+/* one slot per printable vid: -1 (untagged) ... 4095 */
+#define METRICS_NUM_VIDS 4097
+
+enum metrics_family_id {
+	METRICS_ORIG_TQ,
+	METRICS_ORIG_THROUGHPUT,
+	METRICS_ORIG_LAST_SEEN,
+	METRICS_NEIGH_THROUGHPUT,
+	METRICS_NEIGH_LAST_SEEN,
+	METRICS_GW_BANDWIDTH_DOWN,
+	METRICS_GW_BANDWIDTH_UP,
+	METRICS_TT_LOCAL,
+	METRICS_TT_GLOBAL,
+	METRICS_DAT_ENTRIES,
+	METRICS_BLA_CLAIMS,
+	METRICS_NUM_FAMILIES,
+};
+
+struct metrics_family {
+	const char *name;
+	const char *type;
+	const char *unit;
+	const char *help;
+};
+
+static const struct metrics_family metrics_families[] = {
+	[METRICS_ORIG_TQ] = {
+		"batadv_originator_tq", "gauge", NULL,
+		"Transmit quality towards the originator via the neighbor",
+	},
+	[METRICS_ORIG_THROUGHPUT] = {
+		"batadv_originator_throughput_bits_per_second", "gauge",
+		"bits_per_second",
+		"Estimated throughput towards the originator via the neighbor",
+	},
+	[METRICS_ORIG_LAST_SEEN] = {
+		"batadv_originator_last_seen_seconds", "gauge", "seconds",
+		"Time since the last OGM of the originator was received",
+	},
+	[METRICS_NEIGH_THROUGHPUT] = {
+		"batadv_neighbor_throughput_bits_per_second", "gauge",
+		"bits_per_second",
+		"Estimated throughput of the link to the neighbor",
+	},
+	[METRICS_NEIGH_LAST_SEEN] = {
+		"batadv_neighbor_last_seen_seconds", "gauge", "seconds",
+		"Time since the neighbor was last seen",
+	},
+	[METRICS_GW_BANDWIDTH_DOWN] = {
+		"batadv_gateway_bandwidth_down_bits_per_second", "gauge",
+		"bits_per_second",
+		"Downlink bandwidth announced by the gateway",
+	},
+	[METRICS_GW_BANDWIDTH_UP] = {
+		"batadv_gateway_bandwidth_up_bits_per_second", "gauge",
+		"bits_per_second",
+		"Uplink bandwidth announced by the gateway",
+	},
+	[METRICS_TT_LOCAL] = {
+		"batadv_tt_local_clients", "gauge", NULL,
+		"Number of clients in the local translation table",
+	},
+	[METRICS_TT_GLOBAL] = {
+		"batadv_tt_global_clients", "gauge", NULL,
+		"Number of clients in the global translation table",
+	},
+	[METRICS_DAT_ENTRIES] = {
+		"batadv_dat_cache_entries", "gauge", NULL,
+		"Number of entries in the distributed ARP table cache",
+	},
+	[METRICS_BLA_CLAIMS] = {
+		"batadv_bla_claims", "gauge", NULL,
+		"Number of bridge loop avoidance claims",
+	},
+};
+
+enum metrics_label_type {
+	METRICS_LABEL_MAC,
+	METRICS_LABEL_IFNAME,
+	METRICS_LABEL_IFINDEX,
+};
+
+struct metrics_label {
+	uint8_t type;
+	uint8_t key_len;
+	uint8_t key[IF_NAMESIZE];
+	char *value;
+};
+
+struct metrics {
+	/* samples of each family, printed in one block after all dumps */
+	struct outbuf samples[METRICS_NUM_FAMILIES];
+	/* ethtool counters, each one is its own family */
+	struct outbuf counters;
+	/* label set of the row which is currently parsed */
+	struct outbuf labels;
+	/* escaped label values, keyed by mac address or interface name */
+	struct hashtable_t *interned;
+	const char *mesh_label;
+	uint32_t tt_local[METRICS_NUM_VIDS];
+	uint32_t tt_global[METRICS_NUM_VIDS];
+	long dat_entries;
+	long bla_claims;
+	struct nlquery_opts query_opts;
+};
+
+static void metrics_usage(void)
+{
+	fprintf(stderr, "Usage: batctl [options] metrics [parameters]\n");
+	fprintf(stderr, "parameters:\n");
+	fprintf(stderr, " \t -h print this help\n");
+}
+
+static int metrics_label_compare(void *data1, void *data2)
+{
+	const struct metrics_label *label1 = data1;
+	const struct metrics_label *label2 = data2;
+
+	if (label1->type != label2->type || label1->key_len != label2->key_len)
+		return 0;
+
+	return (memcmp(label1->key, label2->key, label1->key_len) == 0 ? 1 : 0);
+}
+
+static int metrics_label_choose(void *data, int32_t size)
+{
+	const struct metrics_label *label = data;
+	uint32_t hash;
+
+	hash = hash_bytes(label->key, label->key_len);
+	hash ^= label->type * 0x9e3779b1U;
+
+	return (hash % size);
+}
+
+static void metrics_label_free(void *data)
+{
+	struct metrics_label *label = data;
+
+	free(label->value);
+	free(label);
+}
+
+static char *metrics_label_escape(const char *str)
+{
+	char *value;
+	char *pos;
+
+	value = malloc(strlen(str) * 2 + 1);
+	if (!value)
+		return NULL;
+
+	for (pos = value; *str; str++) {
+		switch (*str) {
+		case '\\':
+		case '"':
+			*pos++ = '\\';
+			*pos++ = *str;
+			break;
+		case '\n':
+			*pos++ = '\\';
+			*pos++ = 'n';
+			break;
+		default:
+			*pos++ = *str;
+			break;
+		}
+	}
+
+	*pos = '\0';
+
+	return value;
+}
+
+/* most rows repeat the same neighbors and interfaces: escape/format each of
+ * them only once and hand out the same string afterwards
+ */
+static const char *metrics_intern(struct metrics *metrics,
+				  enum metrics_label_type type,
+				  const void *key, size_t key_len)
+{
+	char ifname_buf[IF_NAMESIZE];
+	struct hashtable_t *swaphash;
+	struct metrics_label *label;
+	struct metrics_label search;
+	uint32_t ifindex;
+
+	if (key_len > sizeof(search.key))
+		key_len = sizeof(search.key);
+
+	memset(&search, 0, sizeof(search));
+	search.type = type;
+	search.key_len = key_len;
+	memcpy(search.key, key, key_len);
+
+	label = hash_find(metrics->interned, &search);
+	if (label)
+		return label->value;
+
+	label = malloc(sizeof(*label));
+	if (!label)
+		return NULL;
+
+	*label = search;
+
+	switch (type) {
+	case METRICS_LABEL_MAC:
+		label->value = strdup(ether_ntoa_long(key));
+		break;
+	case METRICS_LABEL_IFNAME:
+		label->value = metrics_label_escape(key);
+		break;
+	case METRICS_LABEL_IFINDEX:
+		memcpy(&ifindex, key, sizeof(ifindex));
+		if (!if_indextoname(ifindex, ifname_buf))
+			ifname_buf[0] = '\0';
+
+		label->value = metrics_label_escape(ifname_buf);
+		break;
+	default:
+		label->value = NULL;
+		break;
+	}
+
+	if (!label->value || hash_add(metrics->interned, label) < 0) {
+		metrics_label_free(label);
+		return NULL;
+	}
+
+	if (metrics->interned->elements * 4 > metrics->interned->size) {
+		swaphash = hash_resize(metrics->interned,
+				       metrics->interned->size * 4);
+		if (swaphash)
+			metrics->interned = swaphash;
+	}
+
+	return label->value;
+}
+
+static const char *metrics_intern_mac(struct metrics *metrics,
+				      const uint8_t *mac)
+{
+	return metrics_intern(metrics, METRICS_LABEL_MAC, mac, ETH_ALEN);
+}
+
+static const char *metrics_intern_ifname(struct metrics *metrics,
+					 struct nlattr *attrs[])
+{
+	const char *ifname = "";
+	uint32_t ifindex;
+
+	/* older kernels only send the index, resolve it once per interface */
+	if (!attrs[BATADV_ATTR_HARD_IFNAME] && attrs[BATADV_ATTR_HARD_IFINDEX]) {
+		ifindex = nla_get_u32(attrs[BATADV_ATTR_HARD_IFINDEX]);
+
+		return metrics_intern(metrics, METRICS_LABEL_IFINDEX, &ifindex,
+				      sizeof(ifindex));
+	}
+
+	if (attrs[BATADV_ATTR_HARD_IFNAME])
+		ifname = nla_get_string(attrs[BATADV_ATTR_HARD_IFNAME]);
+
+	return metrics_intern(metrics, METRICS_LABEL_IFNAME, ifname,
+			      strlen(ifname) + 1);
+}
+
+static void metrics_labels_begin(struct metrics *metrics)
+{
+	metrics->labels.len = 0;
+	outbuf_str(&metrics->labels, "mesh=\"", 0);
+	outbuf_str(&metrics->labels, metrics->mesh_label, 0);
+	outbuf_putc(&metrics->labels, '"');
+}
+
+static void metrics_labels_add(struct metrics *metrics, const char *name,
+			       const char *value)
+{
+	outbuf_putc(&metrics->labels, ',');
+	outbuf_str(&metrics->labels, name, 0);
+	outbuf_str(&metrics->labels, "=\"", 0);
+	outbuf_str(&metrics->labels, value, 0);
+	outbuf_putc(&metrics->labels, '"');
+}
+
+static void metrics_sample_begin(struct metrics *metrics,
+				 enum metrics_family_id id)
+{
+	struct outbuf *out = &metrics->samples[id];
+
+	outbuf_str(out, metrics_families[id].name, 0);
+	outbuf_putc(out, '{');
+	outbuf_write(out, metrics->labels.data, metrics->labels.len);
+	outbuf_str(out, "} ", 0);
+}
+
+static void metrics_sample(struct metrics *metrics, enum metrics_family_id id,
+			   uint64_t value)
+{
+	metrics_sample_begin(metrics, id);
+	outbuf_u64(&metrics->samples[id], value);
+	outbuf_putc(&metrics->samples[id], '\n');
+}
+
+static void metrics_sample_msecs(struct metrics *metrics,
+				 enum metrics_family_id id, uint32_t msecs)
+{
+	metrics_sample_begin(metrics, id);
+	outbuf_uint(&metrics->samples[id], msecs / 1000, 0);
+	outbuf_putc(&metrics->samples[id], '.');
+	outbuf_uint_zero(&metrics->samples[id], msecs % 1000, 3);
+	outbuf_putc(&metrics->samples[id], '\n');
+}
+
+static void metrics_counter(const char *name, uint64_t value, void *arg)
+{
+	struct metrics *metrics = arg;
+	struct outbuf *out = &metrics->counters;
+	char family[ETH_GSTRING_LEN + sizeof("batadv_")];
+	char *pos;
+
+	snprintf(family, sizeof(family), "batadv_%s", name);
+	for (pos = family; *pos; pos++) {
+		if ((*pos < 'a' || *pos > 'z') && (*pos < 'A' || *pos > 'Z') &&
+		    (*pos < '0' || *pos > '9'))
+			*pos = '_';
+	}
+
+	outbuf_str(out, "# TYPE ", 0);
+	outbuf_str(out, family, 0);
+	outbuf_str(out, " counter\n# HELP ", 0);
+	outbuf_str(out, family, 0);
+	outbuf_str(out, " batman-adv traffic counter ", 0);
+	outbuf_str(out, name, 0);
+	outbuf_putc(out, '\n');
+
+	outbuf_str(out, family, 0);
+	outbuf_str(out, "_total{mesh=\"", 0);
+	outbuf_str(out, metrics->mesh_label, 0);
+	outbuf_str(out, "\"} ", 0);
+	outbuf_u64(out, value);
+	outbuf_putc(out, '\n');
+}
+
+static struct nlattr **metrics_parse(struct nl_msg *msg, uint8_t nl_cmd,
+				     struct nlattr *attrs[])
+{
+	struct nlmsghdr *nlh = nlmsg_hdr(msg);
+	struct genlmsghdr *ghdr;
+
+	if (!genlmsg_valid_hdr(nlh, 0))
+		return NULL;
+
+	ghdr = nlmsg_data(nlh);
+
+	if (ghdr->cmd != nl_cmd)
+		return NULL;
+
+	if (nla_parse(attrs, BATADV_ATTR_MAX, genlmsg_attrdata(ghdr, 0),
+		      genlmsg_len(ghdr), batadv_netlink_policy))
+		return NULL;
+
+	return attrs;
+}
+
+static const int metrics_originators_mandatory[] = {
+	BATADV_ATTR_ORIG_ADDRESS,
+	BATADV_ATTR_NEIGH_ADDRESS,
+	BATADV_ATTR_LAST_SEEN_MSECS,
+};
+
+static int metrics_originators_cb(struct nl_msg *msg, void *arg)
+{
+	struct nlattr *attrs[BATADV_ATTR_MAX+1];
+	struct nlquery_opts *query_opts = arg;
+	struct metrics *metrics;
+	const char *ifname;
+	const char *neigh;
+	const char *orig;
+
+	metrics = container_of(query_opts, struct metrics, query_opts);
+
+	if (!metrics_parse(msg, BATADV_CMD_GET_ORIGINATORS, attrs))
+		return NL_OK;
+
+	if (missing_mandatory_attrs(attrs, metrics_originators_mandatory,
+				    ARRAY_SIZE(metrics_originators_mandatory)))
+		return NL_OK;
+
+	orig = metrics_intern_mac(metrics,
+				  nla_data(attrs[BATADV_ATTR_ORIG_ADDRESS]));
+	neigh = metrics_intern_mac(metrics,
+				   nla_data(attrs[BATADV_ATTR_NEIGH_ADDRESS]));
+	ifname = metrics_intern_ifname(metrics, attrs);
+	if (!orig || !neigh || !ifname) {
+		query_opts->err = -ENOMEM;
+		return NL_STOP;
+	}
+
+	metrics_labels_begin(metrics);
+	metrics_labels_add(metrics, "orig", orig);
+	metrics_labels_add(metrics, "neigh", neigh);
+	metrics_labels_add(metrics, "hard_ifname", ifname);
+	metrics_labels_add(metrics, "best",
+			   attrs[BATADV_ATTR_FLAG_BEST] ? "1" : "0");
+
+	if (attrs[BATADV_ATTR_TQ])
+		metrics_sample(metrics, METRICS_ORIG_TQ,
+			       nla_get_u8(attrs[BATADV_ATTR_TQ]));
+
+	/* kbit/s */
+	if (attrs[BATADV_ATTR_THROUGHPUT])
+		metrics_sample(metrics, METRICS_ORIG_THROUGHPUT,
+			       nla_get_u32(attrs[BATADV_ATTR_THROUGHPUT]) * 1000ULL);
+
+	metrics_sample_msecs(metrics, METRICS_ORIG_LAST_SEEN,
+			     nla_get_u32(attrs[BATADV_ATTR_LAST_SEEN_MSECS]));
+
+	return NL_OK;
+}
+
+static const int metrics_neighbors_mandatory[] = {
+	BATADV_ATTR_NEIGH_ADDRESS,
+	BATADV_ATTR_LAST_SEEN_MSECS,
+};
+
+static int metrics_neighbors_cb(struct nl_msg *msg, void *arg)
+{
+	struct nlattr *attrs[BATADV_ATTR_MAX+1];
+	struct nlquery_opts *query_opts = arg;
+	struct metrics *metrics;
+	const char *ifname;
+	const char *neigh;
+
+	metrics = container_of(query_opts, struct metrics, query_opts);
+
+	if (!metrics_parse(msg, BATADV_CMD_GET_NEIGHBORS, attrs))
+		return NL_OK;
+
+	if (missing_mandatory_attrs(attrs, metrics_neighbors_mandatory,
+				    ARRAY_SIZE(metrics_neighbors_mandatory)))
+		return NL_OK;
+
+	neigh = metrics_intern_mac(metrics,
+				   nla_data(attrs[BATADV_ATTR_NEIGH_ADDRESS]));
+	ifname = metrics_intern_ifname(metrics, attrs);
+	if (!neigh || !ifname) {
+		query_opts->err = -ENOMEM;
+		return NL_STOP;
+	}
+
+	metrics_labels_begin(metrics);
+	metrics_labels_add(metrics, "neigh", neigh);
+	metrics_labels_add(metrics, "hard_ifname", ifname);
+
+	/* kbit/s */
+	if (attrs[BATADV_ATTR_THROUGHPUT])
+		metrics_sample(metrics, METRICS_NEIGH_THROUGHPUT,
+			       nla_get_u32(attrs[BATADV_ATTR_THROUGHPUT]) * 1000ULL);
+
+	metrics_sample_msecs(metrics, METRICS_NEIGH_LAST_SEEN,
+			     nla_get_u32(attrs[BATADV_ATTR_LAST_SEEN_MSECS]));
+
+	return NL_OK;
+}
+
+static const int metrics_gateways_mandatory[] = {
+	BATADV_ATTR_ORIG_ADDRESS,
+	BATADV_ATTR_ROUTER,
+	BATADV_ATTR_BANDWIDTH_DOWN,
+	BATADV_ATTR_BANDWIDTH_UP,
+};
+
+static int metrics_gateways_cb(struct nl_msg *msg, void *arg)
+{
+	struct nlattr *attrs[BATADV_ATTR_MAX+1];
+	struct nlquery_opts *query_opts = arg;
+	struct metrics *metrics;
+	const char *router;
+	const char *orig;
+
+	metrics = container_of(query_opts, struct metrics, query_opts);
+
+	if (!metrics_parse(msg, BATADV_CMD_GET_GATEWAYS, attrs))
+		return NL_OK;
+
+	if (missing_mandatory_attrs(attrs, metrics_gateways_mandatory,
+				    ARRAY_SIZE(metrics_gateways_mandatory)))
+		return NL_OK;
+
+	orig = metrics_intern_mac(metrics,
+				  nla_data(attrs[BATADV_ATTR_ORIG_ADDRESS]));
+	router = metrics_intern_mac(metrics,
+				    nla_data(attrs[BATADV_ATTR_ROUTER]));
+	if (!orig || !router) {
+		query_opts->err = -ENOMEM;
+		return NL_STOP;
+	}
+
+	metrics_labels_begin(metrics);
+	metrics_labels_add(metrics, "orig", orig);
+	metrics_labels_add(metrics, "router", router);
+	metrics_labels_add(metrics, "best",
+			   attrs[BATADV_ATTR_FLAG_BEST] ? "1" : "0");
+
+	/* 100 kbit/s */
+	metrics_sample(metrics, METRICS_GW_BANDWIDTH_DOWN,
+		       nla_get_u32(attrs[BATADV_ATTR_BANDWIDTH_DOWN]) * 100000ULL);
+	metrics_sample(metrics, METRICS_GW_BANDWIDTH_UP,
+		       nla_get_u32(attrs[BATADV_ATTR_BANDWIDTH_UP]) * 100000ULL);
+
+	return NL_OK;
+}
+
+static int metrics_translocal_cb(struct nl_msg *msg, void *arg)
+{
+	struct nlattr *attrs[BATADV_ATTR_MAX+1];
+	struct nlquery_opts *query_opts = arg;
+	struct metrics *metrics;
+	uint16_t vid;
+
+	metrics = container_of(query_opts, struct metrics, query_opts);
+
+	if (!metrics_parse(msg, BATADV_CMD_GET_TRANSTABLE_LOCAL, attrs))
+		return NL_OK;
+
+	if (!attrs[BATADV_ATTR_TT_VID])
+		return NL_OK;
+
+	vid = nla_get_u16(attrs[BATADV_ATTR_TT_VID]);
+	metrics->tt_local[BATADV_PRINT_VID(vid) + 1]++;
+
+	return NL_OK;
+}
+
+static int metrics_transglobal_cb(struct nl_msg *msg, void *arg)
+{
+	struct nlattr *attrs[BATADV_ATTR_MAX+1];
+	struct nlquery_opts *query_opts = arg;
+	struct metrics *metrics;
+	uint16_t vid;
+
+	metrics = container_of(query_opts, struct metrics, query_opts);
+
+	if (!metrics_parse(msg, BATADV_CMD_GET_TRANSTABLE_GLOBAL, attrs))
+		return NL_OK;
+
+	/* clients announced by several originators are only counted once */
+	if (!attrs[BATADV_ATTR_TT_VID] || !attrs[BATADV_ATTR_FLAG_BEST])
+		return NL_OK;
+
+	vid = nla_get_u16(attrs[BATADV_ATTR_TT_VID]);
+	metrics->tt_global[BATADV_PRINT_VID(vid) + 1]++;
+
+	return NL_OK;
+}
+
+static int metrics_dat_cache_cb(struct nl_msg *msg, void *arg)
+{
+	struct nlattr *attrs[BATADV_ATTR_MAX+1];
+	struct nlquery_opts *query_opts = arg;
+	struct metrics *metrics;
+
+	metrics = container_of(query_opts, struct metrics, query_opts);
+
+	if (metrics_parse(msg, BATADV_CMD_GET_DAT_CACHE, attrs))
+		metrics->dat_entries++;
+
+	return NL_OK;
+}
+
+static int metrics_claims_cb(struct nl_msg *msg, void *arg)
+{
+	struct nlattr *attrs[BATADV_ATTR_MAX+1];
+	struct nlquery_opts *query_opts = arg;
+	struct metrics *metrics;
+
+	metrics = container_of(query_opts, struct metrics, query_opts);
+
+	if (metrics_parse(msg, BATADV_CMD_GET_BLA_CLAIM, attrs))
+		metrics->bla_claims++;
+
+	return NL_OK;
+}
+
+static const struct {
+	const char *name;
+	uint8_t nl_cmd;
+	nl_recvmsg_msg_cb_t callback;
+} metrics_dumps[] = {
+	{ "originators", BATADV_CMD_GET_ORIGINATORS, metrics_originators_cb },
+	{ "neighbors", BATADV_CMD_GET_NEIGHBORS, metrics_neighbors_cb },
+	{ "gateways", BATADV_CMD_GET_GATEWAYS, metrics_gateways_cb },
+	{ "translocal", BATADV_CMD_GET_TRANSTABLE_LOCAL, metrics_translocal_cb },
+	{ "transglobal", BATADV_CMD_GET_TRANSTABLE_GLOBAL, metrics_transglobal_cb },
+	{ "dat_cache", BATADV_CMD_GET_DAT_CACHE, metrics_dat_cache_cb },
+	{ "claimtable", BATADV_CMD_GET_BLA_CLAIM, metrics_claims_cb },
+};
+
+static void metrics_vid_samples(struct metrics *metrics,
+				enum metrics_family_id id,
+				const uint32_t *counts)
+{
+	char vid[sizeof("-1") + 4];
+	unsigned int i;
+
+	for (i = 0; i < METRICS_NUM_VIDS; i++) {
+		if (!counts[i])
+			continue;
+
+		snprintf(vid, sizeof(vid), "%d", (int)i - 1);
+
+		metrics_labels_begin(metrics);
+		metrics_labels_add(metrics, "vid", vid);
+		metrics_sample(metrics, id, counts[i]);
+	}
+}
+
+static void metrics_size_sample(struct metrics *metrics,
+				enum metrics_family_id id, long size)
+{
+	/* feature not compiled into batman-adv */
+	if (size < 0)
+		return;
+
+	metrics_labels_begin(metrics);
+	metrics_sample(metrics, id, size);
+}
+
+static void metrics_print(struct metrics *metrics, struct outbuf *out)
+{
+	const struct metrics_family *family;
+	unsigned int i;
+
+	outbuf_write(out, metrics->counters.data, metrics->counters.len);
+
+	for (i = 0; i < METRICS_NUM_FAMILIES; i++) {
+		family = &metrics_families[i];
+
+		outbuf_str(out, "# TYPE ", 0);
+		outbuf_str(out, family->name, 0);
+		outbuf_putc(out, ' ');
+		outbuf_str(out, family->type, 0);
+		outbuf_putc(out, '\n');
+
+		if (family->unit) {
+			outbuf_str(out, "# UNIT ", 0);
+			outbuf_str(out, family->name, 0);
+			outbuf_putc(out, ' ');
+			outbuf_str(out, family->unit, 0);
+			outbuf_putc(out, '\n');
+		}
+
+		outbuf_str(out, "# HELP ", 0);
+		outbuf_str(out, family->name, 0);
+		outbuf_putc(out, ' ');
+		outbuf_str(out, family->help, 0);
+		outbuf_putc(out, '\n');
+
+		outbuf_write(out, metrics->samples[i].data,
+			     metrics->samples[i].len);
+	}
+
+	outbuf_str(out, "# EOF\n", 0);
+}
+
+static void metrics_free(struct metrics *metrics)
+{
+	unsigned int i;
+
+	for (i = 0; i < METRICS_NUM_FAMILIES; i++)
+		outbuf_free(&metrics->samples[i]);
+
+	outbuf_free(&metrics->counters);
+	outbuf_free(&metrics->labels);
+
+	if (metrics->interned)
+		hash_delete(metrics->interned, metrics_label_free);
+
+	free(metrics);
+}
+
+static struct metrics *metrics_new(struct state *state)
+{
+	struct metrics *metrics;
+	unsigned int i;
+	int ret = 0;
+
+	metrics = calloc(1, sizeof(*metrics));
+	if (!metrics)
+		return NULL;
+
+	for (i = 0; i < METRICS_NUM_FAMILIES; i++)
+		ret |= outbuf_init(&metrics->samples[i], NULL);
+
+	ret |= outbuf_init(&metrics->counters, NULL);
+	ret |= outbuf_init(&metrics->labels, NULL);
+
+	metrics->interned = hash_new(64, metrics_label_compare,
+				     metrics_label_choose);
+
+	if (ret < 0 || !metrics->interned)
+		goto err;
+
+	metrics->mesh_label = metrics_intern(metrics, METRICS_LABEL_IFNAME,
+					     state->mesh_iface,
+					     strlen(state->mesh_iface) + 1);
+	if (!metrics->mesh_label)
+		goto err;
+
+	return metrics;
+
+err:
+	metrics_free(metrics);
+	return NULL;
+}
+
+static int metrics(struct state *state, int argc, char **argv)
+{
+	struct metrics *metrics;
+	int ret = EXIT_SUCCESS;
+	struct outbuf out;
+	unsigned int i;
+	int optchar;
+	int err;
+
+	while ((optchar = getopt(argc, argv, "h")) != -1) {
+		switch (optchar) {
+		case 'h':
+			metrics_usage();
+			return EXIT_SUCCESS;
+		default:
+			metrics_usage();
+			return EXIT_FAILURE;
+		}
+	}
+
+	metrics = metrics_new(state);
+	if (!metrics) {
+		fprintf(stderr, "Error - out of memory\n");
+		return EXIT_FAILURE;
+	}
+
+	if (get_ethtool_stats(state->mesh_iface, metrics_counter, metrics) < 0)
+		ret = EXIT_FAILURE;
+
+	/* every table is dumped exactly once over the shared socket */
+	for (i = 0; i < ARRAY_SIZE(metrics_dumps); i++) {
+		err = netlink_query_common(state, state->mesh_ifindex,
+					   metrics_dumps[i].nl_cmd,
+					   metrics_dumps[i].callback, NULL,
+					   NLM_F_DUMP, &metrics->query_opts);
+		if (err == -EOPNOTSUPP) {
+			if (metrics_dumps[i].nl_cmd == BATADV_CMD_GET_DAT_CACHE)
+				metrics->dat_entries = -1;
+			else if (metrics_dumps[i].nl_cmd == BATADV_CMD_GET_BLA_CLAIM)
+				metrics->bla_claims = -1;
+
+			continue;
+		}
+
+		if (err < 0) {
+			fprintf(stderr, "Error - can't dump %s: %s\n",
+				metrics_dumps[i].name, strerror(-err));
+			ret = EXIT_FAILURE;
+
+			if (err == -ENOMEM)
+				goto out;
+		}
+	}
+
+	metrics_vid_samples(metrics, METRICS_TT_LOCAL, metrics->tt_local);
+	metrics_vid_samples(metrics, METRICS_TT_GLOBAL, metrics->tt_global);
+	metrics_size_sample(metrics, METRICS_DAT_ENTRIES, metrics->dat_entries);
+	metrics_size_sample(metrics, METRICS_BLA_CLAIMS, metrics->bla_claims);
+
+	if (outbuf_init(&out, stdout) < 0) {
+		fprintf(stderr, "Error - out of memory\n");
+		ret = EXIT_FAILURE;
+		goto out;
+	}
+
+	metrics_print(metrics, &out);
+	outbuf_flush(&out);
+	outbuf_free(&out);
+
+out:
+	metrics_free(metrics);
+	return ret;
+}
+
+COMMAND(SUBCOMMAND_MIF, metrics, "me",
+	COMMAND_FLAG_MESH_IFACE | COMMAND_FLAG_NETLINK, NULL,
+	"                  \tprint the mesh state in the OpenMetrics text format");
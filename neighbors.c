@@ -22,6 +22,9 @@
 #include "functions.h"
 #include "main.h"
 #include "netlink.h"
+#include "output.h"
+#include "tablefmt.h"
+#include "tablesort.h"
 
 static const int neighbors_mandatory[] = {
 	BATADV_ATTR_NEIGH_ADDRESS,
@@ -29,42 +32,29 @@ static const int neighbors_mandatory[] = {
 	BATADV_ATTR_LAST_SEEN_MSECS,
 };
 
-static int neighbors_callback(struct nl_msg *msg, void *arg)
+static const struct table_column neighbors_columns[] = {
+	{ "hard_ifname", BATADV_ATTR_HARD_IFNAME, table_column_ifname },
+	{ "neigh_address", BATADV_ATTR_NEIGH_ADDRESS, table_column_mac },
+	{ "last_seen_msecs", BATADV_ATTR_LAST_SEEN_MSECS, table_column_u32 },
+	{ "throughput", BATADV_ATTR_THROUGHPUT, table_column_u32 },
+};
+
+static const struct table_sort_key neighbors_sort_keys[] = {
+	{ "throughput", BATADV_ATTR_THROUGHPUT, TABLE_SORT_U32, true },
+	{ "last-seen", BATADV_ATTR_LAST_SEEN_MSECS, TABLE_SORT_U32, false },
+	{ "address", BATADV_ATTR_NEIGH_ADDRESS, TABLE_SORT_MAC, false },
+};
+
+static void neighbors_print(struct nlattr *attrs[], struct print_opts *opts)
 {
 	unsigned throughput_mbits, throughput_kbits;
-	struct nlattr *attrs[BATADV_ATTR_MAX+1];
-	struct nlmsghdr *nlh = nlmsg_hdr(msg);
 	int last_seen_msecs, last_seen_secs;
-	struct print_opts *opts = arg;
 	char ifname_buf[IF_NAMESIZE];
 	struct bat_host *bat_host;
-	struct genlmsghdr *ghdr;
 	uint32_t ifindex;
 	uint8_t *neigh;
 	char *ifname;
 
-	if (!genlmsg_valid_hdr(nlh, 0)) {
-		fputs("Received invalid data from kernel.\n", stderr);
-		exit(1);
-	}
-
-	ghdr = nlmsg_data(nlh);
-
-	if (ghdr->cmd != BATADV_CMD_GET_NEIGHBORS)
-		return NL_OK;
-
-	if (nla_parse(attrs, BATADV_ATTR_MAX, genlmsg_attrdata(ghdr, 0),
-		      genlmsg_len(ghdr), batadv_netlink_policy)) {
-		fputs("Received invalid data from kernel.\n", stderr);
-		exit(1);
-	}
-
-	if (missing_mandatory_attrs(attrs, neighbors_mandatory,
-				    ARRAY_SIZE(neighbors_mandatory))) {
-		fputs("Missing attributes from kernel\n", stderr);
-		exit(1);
-	}
-
 	neigh = nla_data(attrs[BATADV_ATTR_NEIGH_ADDRESS]);
 	bat_host = bat_hosts_find_by_mac((char *)neigh);
 
@@ -89,45 +79,63 @@ static int neighbors_callback(struct nl_msg *msg, void *arg)
 		throughput_kbits = throughput_kbits % 1000;
 
 		if (!(opts->read_opt & USE_BAT_HOSTS) || !bat_host)
-			printf("%02x:%02x:%02x:%02x:%02x:%02x ",
-			       neigh[0], neigh[1], neigh[2],
-			       neigh[3], neigh[4], neigh[5]);
+			outbuf_mac(opts->out, neigh);
 		else
-			printf("%17s ", bat_host->name);
-
-		printf("%4i.%03is (%9u.%1u) [%10s]\n",
-		       last_seen_secs, last_seen_msecs,
-		       throughput_mbits, throughput_kbits / 100,
-		       ifname);
+			outbuf_str(opts->out, bat_host->name, 17);
+		outbuf_putc(opts->out, ' ');
+
+		outbuf_int(opts->out, last_seen_secs, 4);
+		outbuf_putc(opts->out, '.');
+		outbuf_uint_zero(opts->out, last_seen_msecs, 3);
+		outbuf_str(opts->out, "s (", 0);
+		outbuf_uint(opts->out, throughput_mbits, 9);
+		outbuf_putc(opts->out, '.');
+		outbuf_uint(opts->out, throughput_kbits / 100, 1);
+		outbuf_str(opts->out, ") [", 0);
+		outbuf_str(opts->out, ifname, 10);
+		outbuf_str(opts->out, "]\n", 0);
 	} else {
-		printf("   %10s	  ", ifname);
+		outbuf_str(opts->out, "   ", 0);
+		outbuf_str(opts->out, ifname, 10);
+		outbuf_str(opts->out, "\t  ", 0);
 
 		if (!(opts->read_opt & USE_BAT_HOSTS) || !bat_host)
-			printf("%02x:%02x:%02x:%02x:%02x:%02x ",
-			       neigh[0], neigh[1], neigh[2],
-			       neigh[3], neigh[4], neigh[5]);
+			outbuf_mac(opts->out, neigh);
 		else
-			printf("%17s ", bat_host->name);
+			outbuf_str(opts->out, bat_host->name, 17);
+		outbuf_putc(opts->out, ' ');
 
-		printf("%4i.%03is\n", last_seen_secs, last_seen_msecs);
+		outbuf_int(opts->out, last_seen_secs, 4);
+		outbuf_putc(opts->out, '.');
+		outbuf_uint_zero(opts->out, last_seen_msecs, 3);
+		outbuf_str(opts->out, "s\n", 0);
 	}
-
-	return NL_OK;
 }
 
+static const struct table_rows neighbors_rows = {
+	.mandatory = neighbors_mandatory,
+	.num_mandatory = ARRAY_SIZE(neighbors_mandatory),
+	.print = neighbors_print,
+};
+
 static int netlink_print_neighbors(struct state *state, char *orig_iface,
 				   int read_opts, float orig_timeout,
-				   float watch_interval)
+				   float watch_interval,
+				   const struct table_opts *table)
 {
 	return netlink_print_common(state, orig_iface, read_opts,
 				    orig_timeout, watch_interval,
 				    "IF             Neighbor              last-seen\n",
 				    BATADV_CMD_GET_NEIGHBORS,
-				    neighbors_callback);
+				    &neighbors_rows, table);
 }
 
 static struct debug_table_data batctl_debug_table_neighbors = {
 	.netlink_fn = netlink_print_neighbors,
+	.columns = neighbors_columns,
+	.num_columns = ARRAY_SIZE(neighbors_columns),
+	.sort_keys = neighbors_sort_keys,
+	.num_sort_keys = ARRAY_SIZE(neighbors_sort_keys),
 };
 
 COMMAND_NAMED(DEBUGTABLE, neighbors, "n", handle_debug_table,
@@ -16,17 +16,31 @@
 #include <errno.h>
 #include <net/ethernet.h>
 #include <net/if.h>
+#include <inttypes.h>
+#include <poll.h>
 #include <netlink/netlink.h>
 #include <netlink/genl/genl.h>
 #include <netlink/genl/ctrl.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <time.h>
 
 #include "bat-hosts.h"
 #include "batadv_packet.h"
 #include "batman_adv.h"
+#include "filter.h"
 #include "netlink.h"
 #include "functions.h"
+#include "genl.h"
+#include "macmap.h"
+#include "output.h"
+#include "tablediff.h"
+#include "tablefmt.h"
+#include "tablegroup.h"
+#include "tablesort.h"
 #include "main.h"
 
 /* WARNING: attributes must also be added to batadv_genl_json */
@@ -510,27 +524,346 @@ void netlink_print_remaining_header(struct print_opts *opts)
 	opts->remaining_header = NULL;
 }
 
+static int netlink_print_table_row(struct nl_msg *msg,
+				   struct print_opts *opts)
+{
+	const struct table_rows *rows = opts->rows;
+	struct nlattr *attrs[BATADV_ATTR_MAX+1];
+	struct nlmsghdr *nlh = nlmsg_hdr(msg);
+	struct genlmsghdr *ghdr;
+
+	if (!genlmsg_valid_hdr(nlh, 0)) {
+		fputs("Received invalid data from kernel.\n", stderr);
+		exit(1);
+	}
+
+	ghdr = nlmsg_data(nlh);
+
+	if (ghdr->cmd != opts->nl_cmd)
+		return NL_OK;
+
+	if (nla_parse(attrs, BATADV_ATTR_MAX, genlmsg_attrdata(ghdr, 0),
+		      genlmsg_len(ghdr), batadv_netlink_policy)) {
+		fputs("Received invalid data from kernel.\n", stderr);
+		exit(1);
+	}
+
+	if (missing_mandatory_attrs(attrs, rows->mandatory,
+				    rows->num_mandatory)) {
+		fputs("Missing attributes from kernel\n", stderr);
+		exit(1);
+	}
+
+	if (opts->table.filter && !filter_match(opts->table.filter, attrs))
+		return NL_OK;
+
+	if (rows->match && !rows->match(attrs, opts))
+		return NL_OK;
+
+	/* rows are only collected here, table_group_flush() and
+	 * table_sort_flush() print them
+	 */
+	if (opts->table.group) {
+		table_group_add(opts->table.group, attrs);
+		return NL_OK;
+	}
+
+	if (opts->table.sort) {
+		table_sort_add(opts->table.sort, msg, attrs);
+		return NL_OK;
+	}
+
+	netlink_print_remaining_header(opts);
+
+	if (opts->diff)
+		table_diff_row_begin(opts->diff);
+
+	if (opts->table.format)
+		table_format_row(opts, attrs);
+	else
+		rows->print(attrs, opts);
+
+	if (opts->diff)
+		table_diff_row_end(opts->diff, msg);
+
+	return NL_OK;
+}
+
 int netlink_print_common_cb(struct nl_msg *msg, void *arg)
 {
 	struct print_opts *opts = arg;
 
+	if (opts->rows)
+		return netlink_print_table_row(msg, opts);
+
 	netlink_print_remaining_header(opts);
 
 	return opts->callback(msg, arg);
 }
 
+/* create a non-blocking socket subscribed to the batman-adv config
+ * notifications (BATADV_CMD_SET_*)
+ */
+struct nl_sock *netlink_config_event_sock(void)
+{
+	struct nl_sock *sock;
+	int mcid;
+
+	sock = nl_socket_alloc();
+	if (!sock)
+		return NULL;
+
+	if (genl_connect(sock) < 0)
+		goto err_free_sock;
+
+	mcid = nl_get_multicast_id(sock, BATADV_NL_NAME,
+				   BATADV_NL_MCAST_GROUP_CONFIG);
+	if (mcid < 0)
+		goto err_free_sock;
+
+	if (nl_socket_add_membership(sock, mcid) < 0)
+		goto err_free_sock;
+
+	if (nl_socket_set_nonblocking(sock) < 0)
+		goto err_free_sock;
+
+	nl_socket_disable_seq_check(sock);
+
+	return sock;
+
+err_free_sock:
+	nl_socket_free(sock);
+	return NULL;
+}
+
+/* config events of the watched mesh trigger a redraw, but not faster than
+ * this
+ */
+#define WATCH_EVENT_MIN_INTERVAL_MS 100
+
+struct netlink_watch {
+	struct nl_sock *sock;
+	struct nl_cb *cb;
+	int timer_fd;
+	unsigned int mesh_ifindex;
+	bool changed;
+	bool header_stale;
+};
+
+static int netlink_watch_event_cb(struct nl_msg *msg, void *arg)
+{
+	struct nlattr *attrs[BATADV_ATTR_MAX+1];
+	struct nlmsghdr *nlh = nlmsg_hdr(msg);
+	struct netlink_watch *watch = arg;
+	struct genlmsghdr *ghdr;
+
+	if (!genlmsg_valid_hdr(nlh, 0))
+		return NL_OK;
+
+	ghdr = nlmsg_data(nlh);
+
+	if (nla_parse(attrs, BATADV_ATTR_MAX, genlmsg_attrdata(ghdr, 0),
+		      genlmsg_len(ghdr), batadv_netlink_policy)) {
+		return NL_OK;
+	}
+
+	if (!attrs[BATADV_ATTR_MESH_IFINDEX])
+		return NL_OK;
+
+	if (nla_get_u32(attrs[BATADV_ATTR_MESH_IFINDEX]) != watch->mesh_ifindex)
+		return NL_OK;
+
+	watch->changed = true;
+	if (ghdr->cmd == BATADV_CMD_SET_MESH)
+		watch->header_stale = true;
+
+	return NL_OK;
+}
+
+/* refreshes are scheduled on absolute CLOCK_MONOTONIC deadlines so slow
+ * dumps don't shift the following samples
+ */
+static int netlink_watch_timer_init(float watch_interval)
+{
+	struct itimerspec timer;
+	double interval;
+	int timer_fd;
+
+	/* a zero interval would disarm the timer */
+	interval = watch_interval;
+	if (interval < 0.001)
+		interval = 0.001;
+
+	timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+	if (timer_fd < 0)
+		return -errno;
+
+	timer.it_interval.tv_sec = (time_t)interval;
+	timer.it_interval.tv_nsec = (interval - timer.it_interval.tv_sec) * 1e9;
+
+	clock_gettime(CLOCK_MONOTONIC, &timer.it_value);
+	timer.it_value.tv_sec += timer.it_interval.tv_sec;
+	timer.it_value.tv_nsec += timer.it_interval.tv_nsec;
+	if (timer.it_value.tv_nsec >= 1000000000) {
+		timer.it_value.tv_sec++;
+		timer.it_value.tv_nsec -= 1000000000;
+	}
+
+	if (timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &timer, NULL) < 0) {
+		close(timer_fd);
+		return -errno;
+	}
+
+	return timer_fd;
+}
+
+static void netlink_watch_init(struct netlink_watch *watch,
+			       struct state *state, float watch_interval)
+{
+	memset(watch, 0, sizeof(*watch));
+	watch->mesh_ifindex = state->mesh_ifindex;
+
+	/* without notifications, the header is fetched on each redraw */
+	watch->header_stale = true;
+
+	watch->timer_fd = netlink_watch_timer_init(watch_interval);
+
+	watch->sock = netlink_config_event_sock();
+	if (!watch->sock)
+		return;
+
+	watch->cb = nl_cb_alloc(NL_CB_DEFAULT);
+	if (!watch->cb) {
+		nl_socket_free(watch->sock);
+		watch->sock = NULL;
+		return;
+	}
+
+	nl_cb_set(watch->cb, NL_CB_VALID, NL_CB_CUSTOM, netlink_watch_event_cb,
+		  watch);
+}
+
+static void netlink_watch_free(struct netlink_watch *watch)
+{
+	if (watch->cb)
+		nl_cb_put(watch->cb);
+
+	if (watch->sock)
+		nl_socket_free(watch->sock);
+
+	if (watch->timer_fd >= 0)
+		close(watch->timer_fd);
+}
+
+static long netlink_watch_elapsed_ms(const struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec - start->tv_sec) * 1000 +
+	       (now.tv_nsec - start->tv_nsec) / 1000000;
+}
+
+static bool netlink_watch_tick(struct netlink_watch *watch)
+{
+	uint64_t expirations;
+	ssize_t ret;
+
+	ret = read(watch->timer_fd, &expirations, sizeof(expirations));
+	if (ret != sizeof(expirations))
+		return false;
+
+	/* the dump (or the output) took longer than the interval */
+	if (expirations > 1)
+		fprintf(stderr, "Warning - refresh took longer than the watch interval, skipped %" PRIu64 " tick(s)\n",
+			expirations - 1);
+
+	return true;
+}
+
+/* wait for the next tick of the watch interval or until a config change
+ * of the mesh was announced
+ */
+static void netlink_watch_wait(struct netlink_watch *watch,
+			       const struct timespec *last_dump,
+			       float watch_interval)
+{
+	struct pollfd pollfds[2];
+	int num_pollfds = 0;
+	long elapsed;
+	long timeout;
+	int ret;
+
+	if (watch->timer_fd < 0) {
+		usleep(1000000 * watch_interval);
+		return;
+	}
+
+	pollfds[num_pollfds].fd = watch->timer_fd;
+	pollfds[num_pollfds].events = POLLIN;
+	num_pollfds++;
+
+	if (watch->sock) {
+		pollfds[num_pollfds].fd = nl_socket_get_fd(watch->sock);
+		pollfds[num_pollfds].events = POLLIN;
+		num_pollfds++;
+	}
+
+	while (true) {
+		timeout = -1;
+
+		if (watch->changed) {
+			elapsed = netlink_watch_elapsed_ms(last_dump);
+			if (elapsed >= WATCH_EVENT_MIN_INTERVAL_MS)
+				break;
+
+			timeout = WATCH_EVENT_MIN_INTERVAL_MS - elapsed;
+		}
+
+		ret = poll(pollfds, num_pollfds, timeout);
+		if (ret < 0 && errno != EINTR)
+			break;
+
+		if (ret <= 0)
+			continue;
+
+		if (pollfds[0].revents & POLLIN && netlink_watch_tick(watch))
+			break;
+
+		if (num_pollfds > 1 && pollfds[1].revents & POLLIN)
+			nl_recvmsgs(watch->sock, watch->cb);
+	}
+
+	watch->changed = false;
+}
+
 int netlink_print_common(struct state *state, char *orig_iface, int read_opt,
 			 float orig_timeout, float watch_interval,
 			 const char *header, uint8_t nl_cmd,
-			 nl_recvmsg_msg_cb_t callback)
+			 const struct table_rows *rows,
+			 const struct table_opts *table)
 {
 	struct print_opts opts = {
 		.read_opt = read_opt,
 		.orig_timeout = orig_timeout,
 		.watch_interval = watch_interval,
 		.remaining_header = NULL,
-		.callback = callback,
+		.nl_cmd = nl_cmd,
+		.out = NULL,
+		.diff = NULL,
+		.rows = rows,
+		.table = *table,
 	};
+	struct netlink_watch watch = {
+		.sock = NULL,
+		.timer_fd = -1,
+		.header_stale = true,
+	};
+	bool watch_mode = read_opt & (CONT_READ|CLR_CONT_READ);
+	char *cached_header = NULL;
+	struct timespec last_dump;
+	struct outbuf out;
 	int hardifindex = 0;
 	struct nl_msg *msg;
 
@@ -549,21 +882,58 @@ int netlink_print_common(struct state *state, char *orig_iface, int read_opt,
 		}
 	}
 
-	bat_hosts_init(read_opt);
+	if (outbuf_init(&out, stdout) < 0) {
+		last_err = -ENOMEM;
+		return last_err;
+	}
+
+	opts.out = &out;
+
+	if (read_opt & USE_BAT_HOSTS)
+		bat_hosts_init(read_opt);
+
+	if (watch_mode)
+		netlink_watch_init(&watch, state, watch_interval);
+
+	if (watch_mode && read_opt & (DIFF_READ|DIFF_CHANGES_ONLY)) {
+		opts.diff = table_diff_new(nl_cmd,
+					   read_opt & DIFF_CHANGES_ONLY);
+		if (!opts.diff) {
+			last_err = -ENOMEM;
+			goto out;
+		}
+	}
 
 	nl_cb_set(state->cb, NL_CB_VALID, NL_CB_CUSTOM, netlink_print_common_cb, &opts);
 	nl_cb_set(state->cb, NL_CB_FINISH, NL_CB_CUSTOM, netlink_stop_callback, NULL);
 	nl_cb_err(state->cb, NL_CB_CUSTOM, netlink_print_error, NULL);
 
 	do {
-		if (read_opt & CLR_CONT_READ)
+		clock_gettime(CLOCK_MONOTONIC, &last_dump);
+
+		if (read_opt & CLR_CONT_READ && !opts.diff)
 			/* clear screen, set cursor back to 0,0 */
 			printf("\033[2J\033[0;0f");
 
-		if (!(read_opt & SKIP_HEADER))
-			opts.remaining_header = netlink_get_info(state,
-								 nl_cmd,
+		if (!(read_opt & SKIP_HEADER)) {
+			/* the header only changes with the mesh settings */
+			if (table->format) {
+				if (!cached_header)
+					cached_header = table_format_header(table->format);
+			} else if (table->group) {
+				if (!cached_header)
+					cached_header = table_group_header(table->group);
+			} else if (!cached_header || watch.header_stale) {
+				free(cached_header);
+				cached_header = netlink_get_info(state, nl_cmd,
 								 header);
+				watch.header_stale = !watch.sock;
+			}
+
+			/* the differential output prints the header itself */
+			if (cached_header && !opts.diff)
+				opts.remaining_header = strdup(cached_header);
+		}
 
 		msg = nlmsg_alloc();
 		if (!msg)
@@ -581,18 +951,44 @@ int netlink_print_common(struct state *state, char *orig_iface, int read_opt,
 
 		nlmsg_free(msg);
 
+		if (opts.diff) {
+			opts.out = table_diff_begin(opts.diff);
+			if (!opts.out) {
+				last_err = -ENOMEM;
+				break;
+			}
+		}
+
 		last_err = 0;
 		nl_recvmsgs(state->sock, state->cb);
 
+		if (table->sort)
+			table_sort_flush(&opts);
+
+		if (table->group)
+			table_group_flush(&opts);
+
+		if (opts.diff)
+			table_diff_end(opts.diff, cached_header, !last_err);
+		else
+			outbuf_flush(&out);
+
 		/* the header should still be printed when no entry was received */
 		if (!last_err)
 			netlink_print_remaining_header(&opts);
 
-		if (!last_err && read_opt & (CONT_READ|CLR_CONT_READ))
-			usleep(1000000 * watch_interval);
+		if (!last_err && watch_mode) {
+			fflush(stdout);
+			netlink_watch_wait(&watch, &last_dump, watch_interval);
+		}
 
-	} while (!last_err && read_opt & (CONT_READ|CLR_CONT_READ));
+	} while (!last_err && watch_mode);
 
+out:
+	table_diff_free(opts.diff);
+	free(cached_header);
+	outbuf_free(&out);
+	netlink_watch_free(&watch);
 	bat_hosts_free();
 
 	return last_err;
@@ -677,29 +1073,43 @@ int netlink_query_common(struct state *state,
 	return query_opts->err;
 }
 
-static const int translate_mac_netlink_mandatory[] = {
+static const int tt_snapshot_mandatory[] = {
 	BATADV_ATTR_TT_ADDRESS,
+	BATADV_ATTR_TT_VID,
 	BATADV_ATTR_ORIG_ADDRESS,
 };
 
-struct translate_mac_netlink_opts {
-	struct ether_addr mac;
-	uint8_t found:1;
+struct tt_snapshot {
+	/* all best entries, keyed by tt_snapshot_key(client, vid) */
+	struct macmap by_client_vid;
+	/* first best entry of each client, keyed by client */
+	struct macmap by_client;
+};
+
+struct tt_snapshot_opts {
+	struct tt_snapshot *snapshot;
 	struct nlquery_opts query_opts;
 };
 
-static int translate_mac_netlink_cb(struct nl_msg *msg, void *arg)
+/* the 48 bit client address and the 16 bit vid fill the whole key */
+static uint64_t tt_snapshot_key(const struct ether_addr *client, uint16_t vid)
+{
+	return macmap_key(client) << 16 | vid;
+}
+
+static int tt_snapshot_cb(struct nl_msg *msg, void *arg)
 {
 	struct nlattr *attrs[BATADV_ATTR_MAX+1];
 	struct nlmsghdr *nlh = nlmsg_hdr(msg);
 	struct nlquery_opts *query_opts = arg;
-	struct translate_mac_netlink_opts *opts;
+	struct tt_snapshot_entry *entry;
+	struct tt_snapshot_opts *opts;
+	struct tt_snapshot *snapshot;
 	struct genlmsghdr *ghdr;
-	uint8_t *addr;
-	uint8_t *orig;
+	uint64_t key;
 
-	opts = container_of(query_opts, struct translate_mac_netlink_opts,
-			    query_opts);
+	opts = container_of(query_opts, struct tt_snapshot_opts, query_opts);
+	snapshot = opts->snapshot;
 
 	if (!genlmsg_valid_hdr(nlh, 0))
 		return NL_OK;
@@ -714,52 +1124,110 @@ static int translate_mac_netlink_cb(struct nl_msg *msg, void *arg)
 		return NL_OK;
 	}
 
-	if (missing_mandatory_attrs(attrs, translate_mac_netlink_mandatory,
-				    ARRAY_SIZE(translate_mac_netlink_mandatory)))
+	if (missing_mandatory_attrs(attrs, tt_snapshot_mandatory,
+				    ARRAY_SIZE(tt_snapshot_mandatory)))
 		return NL_OK;
 
-	addr = nla_data(attrs[BATADV_ATTR_TT_ADDRESS]);
-	orig = nla_data(attrs[BATADV_ATTR_ORIG_ADDRESS]);
-
 	if (!attrs[BATADV_ATTR_FLAG_BEST])
 		return NL_OK;
 
-	if (memcmp(&opts->mac, addr, ETH_ALEN) != 0)
+	entry = malloc(sizeof(*entry));
+	if (!entry) {
+		opts->query_opts.err = -ENOMEM;
+		return NL_STOP;
+	}
+
+	memcpy(&entry->client, nla_data(attrs[BATADV_ATTR_TT_ADDRESS]),
+	       ETH_ALEN);
+	memcpy(&entry->orig, nla_data(attrs[BATADV_ATTR_ORIG_ADDRESS]),
+	       ETH_ALEN);
+	entry->vid = nla_get_u16(attrs[BATADV_ATTR_TT_VID]);
+	entry->flags = 0;
+	if (attrs[BATADV_ATTR_TT_FLAGS])
+		entry->flags = nla_get_u32(attrs[BATADV_ATTR_TT_FLAGS]);
+
+	key = tt_snapshot_key(&entry->client, entry->vid);
+	if (macmap_add(&snapshot->by_client_vid, key, entry) < 0) {
+		free(entry);
 		return NL_OK;
+	}
 
-	memcpy(&opts->mac, orig, ETH_ALEN);
-	opts->found = true;
-	opts->query_opts.err = 0;
+	/* client index only references entries owned by by_client_vid. The
+	 * first entry of a client stays in it
+	 */
+	macmap_add(&snapshot->by_client, macmap_key(&entry->client), entry);
 
 	return NL_OK;
 }
 
-int translate_mac_netlink(struct state *state, const struct ether_addr *mac,
-			  struct ether_addr *mac_out)
+/* build an index of the best global translation table entry of each
+ * (client, vid) tuple from a single dump. returns NULL and sets errno on
+ * error
+ */
+struct tt_snapshot *tt_snapshot_create(struct state *state)
 {
-	struct translate_mac_netlink_opts opts = {
-		.found = false,
+	struct tt_snapshot_opts opts = {
 		.query_opts = {
 			.err = 0,
 		},
 	};
+	struct tt_snapshot *snapshot;
 	int ret;
 
-	memcpy(&opts.mac, mac, ETH_ALEN);
+	snapshot = calloc(1, sizeof(*snapshot));
+	if (!snapshot)
+		return NULL;
+
+	if (macmap_init(&snapshot->by_client_vid, 128) < 0 ||
+	    macmap_init(&snapshot->by_client, 128) < 0) {
+		tt_snapshot_free(snapshot);
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	opts.snapshot = snapshot;
 
 	ret = netlink_query_common(state, state->mesh_ifindex,
 				   BATADV_CMD_GET_TRANSTABLE_GLOBAL,
-			           translate_mac_netlink_cb, NULL, NLM_F_DUMP,
+				   tt_snapshot_cb, NULL, NLM_F_DUMP,
 				   &opts.query_opts);
-	if (ret < 0)
-		return ret;
+	if (ret < 0) {
+		tt_snapshot_free(snapshot);
+		errno = -ret;
+		return NULL;
+	}
 
-	if (!opts.found)
-		return -ENOENT;
+	return snapshot;
+}
 
-	memcpy(mac_out, &opts.mac, ETH_ALEN);
+/* vid has to be given as reported by the kernel (incl. BATADV_VLAN_HAS_TAG)
+ * or TT_SNAPSHOT_VID_ANY to get the first entry of the client on any vlan
+ */
+const struct tt_snapshot_entry *
+tt_snapshot_find(const struct tt_snapshot *snapshot,
+		 const struct ether_addr *client, int vid)
+{
+	if (vid == TT_SNAPSHOT_VID_ANY)
+		return macmap_find(&snapshot->by_client, macmap_key(client));
 
-	return 0;
+	return macmap_find(&snapshot->by_client_vid,
+			   tt_snapshot_key(client, vid));
+}
+
+unsigned int tt_snapshot_count(const struct tt_snapshot *snapshot)
+{
+	return snapshot->by_client_vid.elements;
+}
+
+void tt_snapshot_free(struct tt_snapshot *snapshot)
+{
+	if (!snapshot)
+		return;
+
+	macmap_destroy(&snapshot->by_client, NULL);
+	macmap_destroy(&snapshot->by_client_vid, free);
+
+	free(snapshot);
 }
 
 static const int get_nexthop_netlink_mandatory[] = {
@@ -768,20 +1236,87 @@ static const int get_nexthop_netlink_mandatory[] = {
 	BATADV_ATTR_HARD_IFINDEX,
 };
 
+/* originator snapshot used by get_nexthop_netlink() */
+#define ORIG_CACHE_TTL_MS 5000
+#define ORIG_CACHE_MISS_REFRESH_MS 1000
+
+struct orig_cache_entry {
+	struct ether_addr orig;
+	uint8_t nexthop[ETH_ALEN];
+	char ifname[IF_NAMESIZE];
+};
+
+struct orig_cache {
+	/* keyed by orig, only valid if hash.table.slots is set */
+	struct macmap hash;
+	unsigned int mesh_ifindex;
+	struct timespec stamp;
+	struct nl_sock *event_sock;
+	bool event_sock_failed;
+};
+
+static struct orig_cache orig_cache;
+
 struct get_nexthop_netlink_opts {
-	struct ether_addr mac;
-	uint8_t *nexthop;
-	char *ifname;
-	uint8_t found:1;
+	struct macmap hash;
 	struct nlquery_opts query_opts;
 };
 
+static unsigned int orig_cache_age_ms(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec - orig_cache.stamp.tv_sec) * 1000 +
+	       (now.tv_nsec - orig_cache.stamp.tv_nsec) / 1000000;
+}
+
+static void orig_cache_event_sock_init(void)
+{
+	if (orig_cache.event_sock || orig_cache.event_sock_failed)
+		return;
+
+	/* without notifications the cache is only refreshed by its TTL */
+	orig_cache.event_sock = netlink_config_event_sock();
+	if (!orig_cache.event_sock)
+		orig_cache.event_sock_failed = true;
+}
+
+static bool orig_cache_config_changed(void)
+{
+	char buf[4096];
+	bool changed = false;
+	int fd;
+
+	if (!orig_cache.event_sock)
+		return false;
+
+	/* any config notification invalidates the snapshot */
+	fd = nl_socket_get_fd(orig_cache.event_sock);
+	while (recv(fd, buf, sizeof(buf), MSG_DONTWAIT) > 0)
+		changed = true;
+
+	return changed;
+}
+
+void netlink_orig_cache_flush(void)
+{
+	macmap_destroy(&orig_cache.hash, free);
+
+	if (orig_cache.event_sock)
+		nl_socket_free(orig_cache.event_sock);
+
+	memset(&orig_cache, 0, sizeof(orig_cache));
+}
+
 static int get_nexthop_netlink_cb(struct nl_msg *msg, void *arg)
 {
 	struct nlattr *attrs[BATADV_ATTR_MAX+1];
 	struct nlmsghdr *nlh = nlmsg_hdr(msg);
 	struct nlquery_opts *query_opts = arg;
 	struct get_nexthop_netlink_opts *opts;
+	struct orig_cache_entry *entry;
 	struct genlmsghdr *ghdr;
 	const uint8_t *orig;
 	const uint8_t *neigh;
@@ -815,54 +1350,108 @@ static int get_nexthop_netlink_cb(struct nl_msg *msg, void *arg)
 	if (!attrs[BATADV_ATTR_FLAG_BEST])
 		return NL_OK;
 
-	if (memcmp(&opts->mac, orig, ETH_ALEN) != 0)
+	if (macmap_find(&opts->hash, macmap_key(orig)))
 		return NL_OK;
 
-	/* save result */
-	memcpy(opts->nexthop, neigh, ETH_ALEN);
+	entry = malloc(sizeof(*entry));
+	if (!entry) {
+		opts->query_opts.err = -ENOMEM;
+		return NL_STOP;
+	}
+
+	memcpy(&entry->orig, orig, ETH_ALEN);
+	memcpy(entry->nexthop, neigh, ETH_ALEN);
 
 	if (attrs[BATADV_ATTR_HARD_IFNAME]) {
 		ifname = nla_get_string(attrs[BATADV_ATTR_HARD_IFNAME]);
-		strncpy(opts->ifname, ifname, IFNAMSIZ);
+		strncpy(entry->ifname, ifname, IFNAMSIZ);
+		entry->ifname[IFNAMSIZ - 1] = '\0';
 	} else {
 		/* compatibility for Linux < 5.14/batman-adv < 2021.2 */
-		ifname = if_indextoname(index, opts->ifname);
-		if (!ifname)
+		ifname = if_indextoname(index, entry->ifname);
+		if (!ifname) {
+			free(entry);
 			return NL_OK;
+		}
 	}
 
-	opts->found = true;
-	opts->query_opts.err = 0;
+	if (macmap_add(&opts->hash, macmap_key(orig), entry) < 0)
+		free(entry);
 
 	return NL_OK;
 }
 
-int get_nexthop_netlink(struct state *state, const struct ether_addr *mac,
-			uint8_t *nexthop, char *ifname)
+static int orig_cache_refresh(struct state *state)
 {
 	struct get_nexthop_netlink_opts opts = {
-		.nexthop = 0,
-		.found = false,
 		.query_opts = {
 			.err = 0,
 		},
 	};
 	int ret;
 
-	memcpy(&opts.mac, mac, ETH_ALEN);
-	opts.nexthop = nexthop;
-	opts.ifname = ifname;
+	/* join before the dump to not miss changes during the dump */
+	orig_cache_event_sock_init();
+	orig_cache_config_changed();
+
+	if (macmap_init(&opts.hash, 64) < 0)
+		return -ENOMEM;
 
 	ret = netlink_query_common(state, state->mesh_ifindex,
 				   BATADV_CMD_GET_ORIGINATORS,
 			           get_nexthop_netlink_cb, NULL, NLM_F_DUMP,
 				   &opts.query_opts);
-	if (ret < 0)
+	if (ret < 0) {
+		macmap_destroy(&opts.hash, free);
 		return ret;
+	}
 
-	if (!opts.found)
+	macmap_destroy(&orig_cache.hash, free);
+
+	orig_cache.hash = opts.hash;
+	orig_cache.mesh_ifindex = state->mesh_ifindex;
+	clock_gettime(CLOCK_MONOTONIC, &orig_cache.stamp);
+
+	return 0;
+}
+
+int get_nexthop_netlink(struct state *state, const struct ether_addr *mac,
+			uint8_t *nexthop, char *ifname)
+{
+	struct orig_cache_entry *entry;
+	bool fresh = false;
+	int ret;
+
+	if (orig_cache.hash.table.slots &&
+	    orig_cache.mesh_ifindex == state->mesh_ifindex &&
+	    orig_cache_age_ms() < ORIG_CACHE_TTL_MS &&
+	    !orig_cache_config_changed())
+		fresh = true;
+
+	if (!fresh) {
+		ret = orig_cache_refresh(state);
+		if (ret < 0)
+			return ret;
+	}
+
+	entry = macmap_find(&orig_cache.hash, macmap_key(mac));
+
+	/* the originator might be new - retry once with a newer snapshot */
+	if (!entry && fresh &&
+	    orig_cache_age_ms() >= ORIG_CACHE_MISS_REFRESH_MS) {
+		ret = orig_cache_refresh(state);
+		if (ret < 0)
+			return ret;
+
+		entry = macmap_find(&orig_cache.hash, macmap_key(mac));
+	}
+
+	if (!entry)
 		return -ENOENT;
 
+	memcpy(nexthop, entry->nexthop, ETH_ALEN);
+	memcpy(ifname, entry->ifname, IF_NAMESIZE);
+
 	return 0;
 }
 
@@ -11,9 +11,40 @@
 
 #include <netlink/genl/genl.h>
 #include <netlink/genl/ctrl.h>
+#include <net/ethernet.h>
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
 
+struct filter;
+struct outbuf;
+struct print_opts;
 struct state;
+struct table_diff;
+struct table_format;
+struct table_group;
+struct table_sort;
+
+/* options of a debug table. They are applied to every row in this order */
+struct table_opts {
+	struct filter *filter;
+	struct table_group *group;
+	struct table_sort *sort;
+	struct table_format *format;
+};
+
+/* rows of a debug table. netlink_print_common_cb() parses them, checks the
+ * mandatory attributes and applies the table options, only the rows which
+ * are printed in the native format of the table reach print()
+ */
+struct table_rows {
+	const int *mandatory;
+	size_t num_mandatory;
+	/* optional, hides rows which are not selected by read_opt */
+	bool (*match)(struct nlattr *attrs[], const struct print_opts *opts);
+	void (*print)(struct nlattr *attrs[], struct print_opts *opts);
+};
 
 struct print_opts {
 	int read_opt;
@@ -23,22 +54,40 @@ struct print_opts {
 	char *remaining_header;
 	const char *static_header;
 	uint8_t nl_cmd;
+	struct outbuf *out;
+	struct table_diff *diff;
+	const struct table_rows *rows;
+	struct table_opts table;
 };
 
 struct nlquery_opts {
 	int err;
 };
 
-struct ether_addr;
+#define TT_SNAPSHOT_VID_ANY -1
+
+struct tt_snapshot;
+
+struct tt_snapshot_entry {
+	struct ether_addr client;
+	uint16_t vid;
+	struct ether_addr orig;
+	uint32_t flags;
+};
 
 int netlink_create(struct state *state);
 void netlink_destroy(struct state *state);
 
 char *netlink_get_info(struct state *state, uint8_t nl_cmd, const char *header);
-int translate_mac_netlink(struct state *state, const struct ether_addr *mac,
-			  struct ether_addr *mac_out);
+struct tt_snapshot *tt_snapshot_create(struct state *state);
+const struct tt_snapshot_entry *
+tt_snapshot_find(const struct tt_snapshot *snapshot,
+		 const struct ether_addr *client, int vid);
+unsigned int tt_snapshot_count(const struct tt_snapshot *snapshot);
+void tt_snapshot_free(struct tt_snapshot *snapshot);
 int get_nexthop_netlink(struct state *state, const struct ether_addr *mac,
 			uint8_t *nexthop, char *ifname);
+void netlink_orig_cache_flush(void);
 int get_primarymac_netlink(struct state *state, uint8_t *primarymac);
 int get_algoname_netlink(struct state *state, unsigned int mesh_ifindex,
 			 char *algoname, size_t algoname_len);
@@ -47,10 +96,12 @@ extern struct nla_policy batadv_netlink_policy[];
 
 int missing_mandatory_attrs(struct nlattr *attrs[], const int mandatory[],
 			    int num);
+struct nl_sock *netlink_config_event_sock(void);
 int netlink_print_common(struct state *state, char *orig_iface, int read_opt,
 			 float orig_timeout, float watch_interval,
 			 const char *header, uint8_t nl_cmd,
-			 nl_recvmsg_msg_cb_t callback);
+			 const struct table_rows *rows,
+			 const struct table_opts *table);
 
 int netlink_print_common_cb(struct nl_msg *msg, void *arg);
 int netlink_stop_callback(struct nl_msg *msg, void *arg);
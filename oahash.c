@@ -0,0 +1,447 @@
+// SPDX-License-Identifier: GPL-2.0
+/* Copyright (C) B.A.T.M.A.N. contributors:
+ *
+ * License-Filename: LICENSES/preferred/GPL-2.0
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "oahash.h"
+
+#define OAHASH_MIN_SLOTS 8
+
+/* slots of the previous table emptied by each oahash_add()/oahash_remove() */
+#define OAHASH_MOVE_SLOTS 32
+
+struct oahash_slot {
+	uint32_t hash;		/* 0 marks an empty slot */
+	void *data;
+	unsigned char key[];
+};
+
+static struct oahash_slot *oahash_slot(const struct oahash *hash,
+				       unsigned char *slots, uint32_t pos)
+{
+	return (struct oahash_slot *)(slots + (size_t)pos * hash->slot_size);
+}
+
+/* the keys have a fixed size and are hashed a word at a time. The values
+ * depend on the byte order but never leave the process
+ */
+static uint32_t oahash_key_hash(const struct oahash *hash, const void *key)
+{
+	const unsigned char *data = key;
+	size_t len = hash->key_len;
+	uint64_t key_hash = len;
+	uint64_t word;
+
+	for (; len >= sizeof(word); len -= sizeof(word)) {
+		memcpy(&word, data, sizeof(word));
+		data += sizeof(word);
+
+		key_hash = (key_hash ^ word) * 0xff51afd7ed558ccdULL;
+		key_hash ^= key_hash >> 32;
+	}
+
+	if (len > 0) {
+		word = 0;
+		while (len > 0)
+			word = (word << 8) | data[--len];
+
+		key_hash = (key_hash ^ word) * 0xff51afd7ed558ccdULL;
+		key_hash ^= key_hash >> 32;
+	}
+
+	key_hash ^= key_hash >> 33;
+	key_hash *= 0xc4ceb9fe1a85ec53ULL;
+	key_hash ^= key_hash >> 33;
+
+	return (uint32_t)key_hash ? (uint32_t)key_hash : 1;
+}
+
+/* how far the slot pos is away from the preferred slot of key_hash */
+static uint32_t oahash_dist(uint32_t mask, uint32_t pos, uint32_t key_hash)
+{
+	return (pos - key_hash) & mask;
+}
+
+static uint32_t oahash_max_elements(uint32_t num_slots)
+{
+	return num_slots / 4 * 3;
+}
+
+static int oahash_num_slots(size_t size, uint32_t *num_slots)
+{
+	uint32_t slots = OAHASH_MIN_SLOTS;
+
+	while (oahash_max_elements(slots) < size) {
+		if (slots > UINT32_MAX / 2)
+			return -ENOMEM;
+
+		slots *= 2;
+	}
+
+	*num_slots = slots;
+	return 0;
+}
+
+/* two scratch slots behind the last slot hold the entry which is moved
+ * around by oahash_place()
+ */
+static int oahash_table_alloc(const struct oahash *hash,
+			      struct oahash_table *table, uint32_t num_slots)
+{
+	table->slots = calloc((size_t)num_slots + 2, hash->slot_size);
+	if (!table->slots)
+		return -ENOMEM;
+
+	table->mask = num_slots - 1;
+
+	return 0;
+}
+
+static void oahash_table_free(struct oahash_table *table)
+{
+	free(table->slots);
+	memset(table, 0, sizeof(*table));
+}
+
+/* store the entry in carry starting at slot pos, dist slots away from its
+ * preferred slot. Entries closer to their preferred slot are pushed further
+ * down the table (Robin Hood). carry is overwritten.
+ */
+static void oahash_place(const struct oahash *hash,
+			 const struct oahash_table *table,
+			 struct oahash_slot *carry, uint32_t pos, uint32_t dist)
+{
+	struct oahash_slot *tmp = oahash_slot(hash, table->slots,
+					      table->mask + 2);
+	struct oahash_slot *slot;
+	uint32_t slot_dist;
+
+	for (;;) {
+		slot = oahash_slot(hash, table->slots, pos);
+		if (!slot->hash) {
+			memcpy(slot, carry, hash->slot_size);
+			return;
+		}
+
+		slot_dist = oahash_dist(table->mask, pos, slot->hash);
+		if (slot_dist < dist) {
+			memcpy(tmp, slot, hash->slot_size);
+			memcpy(slot, carry, hash->slot_size);
+			memcpy(carry, tmp, hash->slot_size);
+			dist = slot_dist;
+		}
+
+		pos = (pos + 1) & table->mask;
+		dist++;
+	}
+}
+
+static int oahash_table_lookup(const struct oahash *hash,
+			       const struct oahash_table *table,
+			       const void *key, uint32_t key_hash,
+			       uint32_t *found)
+{
+	struct oahash_slot *slot;
+	uint32_t dist = 0;
+	uint32_t pos;
+
+	if (!table->slots)
+		return -ENOENT;
+
+	pos = key_hash & table->mask;
+
+	for (;;) {
+		slot = oahash_slot(hash, table->slots, pos);
+		if (!slot->hash)
+			return -ENOENT;
+
+		if (oahash_dist(table->mask, pos, slot->hash) < dist)
+			return -ENOENT;
+
+		if (slot->hash == key_hash &&
+		    memcmp(slot->key, key, hash->key_len) == 0) {
+			*found = pos;
+			return 0;
+		}
+
+		pos = (pos + 1) & table->mask;
+		dist++;
+	}
+}
+
+/* the slot must not be part of the table yet */
+static void oahash_table_insert(const struct oahash *hash,
+				const struct oahash_table *table,
+				const struct oahash_slot *entry)
+{
+	struct oahash_slot *carry;
+
+	carry = oahash_slot(hash, table->slots, table->mask + 1);
+	memcpy(carry, entry, hash->slot_size);
+	oahash_place(hash, table, carry, entry->hash & table->mask, 0);
+}
+
+/* pull the entries behind pos one slot closer to their preferred slot */
+static void oahash_table_erase(const struct oahash *hash,
+			       const struct oahash_table *table, uint32_t pos)
+{
+	struct oahash_slot *slot;
+	struct oahash_slot *next;
+	uint32_t next_pos;
+
+	slot = oahash_slot(hash, table->slots, pos);
+
+	for (;;) {
+		next_pos = (pos + 1) & table->mask;
+		next = oahash_slot(hash, table->slots, next_pos);
+
+		if (!next->hash ||
+		    oahash_dist(table->mask, next_pos, next->hash) == 0)
+			break;
+
+		memcpy(slot, next, hash->slot_size);
+		slot = next;
+		pos = next_pos;
+	}
+
+	slot->hash = 0;
+}
+
+/* empty up to num slots of the previous table into the current one. An
+ * entry is erased from the previous table when it is moved, so the entries
+ * behind it are shifted back and the previous table stays a valid table
+ * for lookups. Entries are never shifted into the slots before old_pos.
+ */
+static void oahash_move(struct oahash *hash, uint32_t num)
+{
+	struct oahash_slot *slot;
+
+	while (hash->old.slots && num--) {
+		if (hash->old_pos > hash->old.mask) {
+			oahash_table_free(&hash->old);
+			hash->old_pos = 0;
+			break;
+		}
+
+		slot = oahash_slot(hash, hash->old.slots, hash->old_pos);
+		if (!slot->hash) {
+			hash->old_pos++;
+			continue;
+		}
+
+		oahash_table_insert(hash, &hash->table, slot);
+		oahash_table_erase(hash, &hash->old, hash->old_pos);
+	}
+}
+
+/* replace the current table with an empty one for size entries and keep
+ * the current one as previous table
+ */
+static int oahash_grow(struct oahash *hash, size_t size)
+{
+	struct oahash_table table;
+	uint32_t num_slots;
+
+	/* only one previous table at a time */
+	oahash_move(hash, UINT32_MAX);
+
+	if (size < hash->elements)
+		size = hash->elements;
+
+	if (oahash_num_slots(size, &num_slots) < 0)
+		return -ENOMEM;
+
+	if (oahash_table_alloc(hash, &table, num_slots) < 0)
+		return -ENOMEM;
+
+	hash->old = hash->table;
+	hash->old_pos = 0;
+	hash->table = table;
+
+	return 0;
+}
+
+int oahash_init(struct oahash *hash, size_t key_len, size_t size)
+{
+	uint32_t num_slots;
+	size_t slot_size;
+
+	memset(hash, 0, sizeof(*hash));
+
+	if (oahash_num_slots(size, &num_slots) < 0)
+		return -ENOMEM;
+
+	slot_size = offsetof(struct oahash_slot, key) + key_len;
+	slot_size = (slot_size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+
+	hash->key_len = key_len;
+	hash->slot_size = slot_size;
+
+	return oahash_table_alloc(hash, &hash->table, num_slots);
+}
+
+void oahash_destroy(struct oahash *hash, void (*free_cb)(void *data))
+{
+	uint32_t iter = 0;
+	void *data;
+
+	if (free_cb) {
+		while ((data = oahash_iterate(hash, &iter)))
+			free_cb(data);
+	}
+
+	oahash_table_free(&hash->table);
+	oahash_table_free(&hash->old);
+	memset(hash, 0, sizeof(*hash));
+}
+
+int oahash_resize(struct oahash *hash, size_t size)
+{
+	if (!hash->table.slots)
+		return -ENOMEM;
+
+	if (oahash_grow(hash, size) < 0)
+		return -ENOMEM;
+
+	oahash_move(hash, UINT32_MAX);
+
+	return 0;
+}
+
+int oahash_add(struct oahash *hash, const void *key, void *data)
+{
+	struct oahash_slot *carry;
+	struct oahash_slot *slot;
+	uint32_t key_hash;
+	uint32_t dist = 0;
+	uint32_t pos;
+
+	if (!hash->table.slots)
+		return -ENOMEM;
+
+	key_hash = oahash_key_hash(hash, key);
+
+	if (oahash_table_lookup(hash, &hash->table, key, key_hash, &pos) == 0 ||
+	    oahash_table_lookup(hash, &hash->old, key, key_hash, &pos) == 0)
+		return -EEXIST;
+
+	oahash_move(hash, OAHASH_MOVE_SLOTS);
+
+	/* double the number of slots. The previous table is empty long before
+	 * the new one is 3/4 full again
+	 */
+	if (hash->elements + 1 > oahash_max_elements(hash->table.mask + 1) &&
+	    oahash_grow(hash, (size_t)hash->elements + 1) < 0)
+		return -ENOMEM;
+
+	/* the new entry takes the first slot which is closer to its preferred
+	 * slot than the new entry would be
+	 */
+	pos = key_hash & hash->table.mask;
+
+	for (;;) {
+		slot = oahash_slot(hash, hash->table.slots, pos);
+		if (!slot->hash)
+			break;
+
+		if (oahash_dist(hash->table.mask, pos, slot->hash) < dist)
+			break;
+
+		pos = (pos + 1) & hash->table.mask;
+		dist++;
+	}
+
+	if (slot->hash) {
+		carry = oahash_slot(hash, hash->table.slots,
+				    hash->table.mask + 1);
+		memcpy(carry, slot, hash->slot_size);
+		oahash_place(hash, &hash->table, carry,
+			     (pos + 1) & hash->table.mask,
+			     oahash_dist(hash->table.mask, pos, carry->hash) + 1);
+	}
+
+	slot->hash = key_hash;
+	slot->data = data;
+	memcpy(slot->key, key, hash->key_len);
+	hash->elements++;
+
+	return 0;
+}
+
+void *oahash_find(const struct oahash *hash, const void *key)
+{
+	uint32_t key_hash;
+	uint32_t pos;
+
+	if (!hash->table.slots)
+		return NULL;
+
+	key_hash = oahash_key_hash(hash, key);
+
+	if (oahash_table_lookup(hash, &hash->table, key, key_hash, &pos) == 0)
+		return oahash_slot(hash, hash->table.slots, pos)->data;
+
+	if (oahash_table_lookup(hash, &hash->old, key, key_hash, &pos) == 0)
+		return oahash_slot(hash, hash->old.slots, pos)->data;
+
+	return NULL;
+}
+
+void *oahash_remove(struct oahash *hash, const void *key)
+{
+	uint32_t key_hash;
+	uint32_t pos;
+	void *data;
+
+	if (!hash->table.slots)
+		return NULL;
+
+	key_hash = oahash_key_hash(hash, key);
+
+	if (oahash_table_lookup(hash, &hash->table, key, key_hash, &pos) == 0) {
+		data = oahash_slot(hash, hash->table.slots, pos)->data;
+		oahash_table_erase(hash, &hash->table, pos);
+	} else if (oahash_table_lookup(hash, &hash->old, key, key_hash,
+				       &pos) == 0) {
+		data = oahash_slot(hash, hash->old.slots, pos)->data;
+		oahash_table_erase(hash, &hash->old, pos);
+	} else {
+		return NULL;
+	}
+
+	hash->elements--;
+	oahash_move(hash, OAHASH_MOVE_SLOTS);
+
+	return data;
+}
+
+void *oahash_iterate(const struct oahash *hash, uint32_t *iter)
+{
+	uint32_t num_slots = hash->table.slots ? hash->table.mask + 1 : 0;
+	struct oahash_slot *slot;
+
+	/* the current table first, then the remaining entries of the previous
+	 * one
+	 */
+	while (*iter < num_slots) {
+		slot = oahash_slot(hash, hash->table.slots, (*iter)++);
+		if (slot->hash)
+			return slot->data;
+	}
+
+	if (!hash->old.slots)
+		return NULL;
+
+	while (*iter - num_slots <= hash->old.mask) {
+		slot = oahash_slot(hash, hash->old.slots, (*iter)++ - num_slots);
+		if (slot->hash)
+			return slot->data;
+	}
+
+	return NULL;
+}
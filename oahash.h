@@ -0,0 +1,71 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/* Copyright (C) B.A.T.M.A.N. contributors:
+ *
+ * License-Filename: LICENSES/preferred/GPL-2.0
+ */
+
+#ifndef _BATCTL_OAHASH_H
+#define _BATCTL_OAHASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* open addressing hash table with Robin Hood probing
+ *
+ * Every slot stores the hash of its key, the data pointer and a copy of the
+ * fixed size key, so lookups only touch the slot array and never call back
+ * into the user. The number of slots is a power of two and the table grows
+ * by itself when it is 3/4 full. Removing entries shifts the following
+ * entries back instead of leaving tombstones.
+ *
+ * Like the macmap, growing keeps the previous table. Every oahash_add() and
+ * oahash_remove() removes a few of its entries and adds them to the new
+ * table, lookups consult both tables until the previous one is empty.
+ */
+struct oahash_table {
+	unsigned char *slots;
+	uint32_t mask;		/* number of slots - 1 */
+};
+
+struct oahash {
+	struct oahash_table table;
+	/* previous table while growing, only holds entries not moved yet.
+	 * Slots before old_pos are empty
+	 */
+	struct oahash_table old;
+	uint32_t old_pos;
+	uint32_t elements;	/* in both tables */
+	uint32_t key_len;
+	uint32_t slot_size;
+};
+
+/* prepare an empty table for keys of key_len bytes with room for at least
+ * size entries. returns 0 on success, -ENOMEM on error
+ */
+int oahash_init(struct oahash *hash, size_t key_len, size_t size);
+
+/* free the table. if free_cb != NULL it is called for every data pointer */
+void oahash_destroy(struct oahash *hash, void (*free_cb)(void *data));
+
+/* returns 0 on success, -EEXIST if key is already used or -ENOMEM */
+int oahash_add(struct oahash *hash, const void *key, void *data);
+
+/* returns the data of key or NULL */
+void *oahash_find(const struct oahash *hash, const void *key);
+
+/* returns the data of the removed key or NULL */
+void *oahash_remove(struct oahash *hash, const void *key);
+
+/* resize the table to hold at least size entries and finish moving the
+ * entries of a previous table. returns 0 on success, -ENOMEM on error (the
+ * table stays usable)
+ */
+int oahash_resize(struct oahash *hash, size_t size);
+
+/* returns the data of the next entry after position *iter and advances
+ * *iter, or NULL after the last entry. Start with *iter = 0. The table must
+ * not be modified while iterating.
+ */
+void *oahash_iterate(const struct oahash *hash, uint32_t *iter);
+
+#endif /* _BATCTL_OAHASH_H */
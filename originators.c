@@ -25,6 +25,9 @@
 #include "functions.h"
 #include "main.h"
 #include "netlink.h"
+#include "output.h"
+#include "tablefmt.h"
+#include "tablesort.h"
 
 static const int originators_mandatory[] = {
 	BATADV_ATTR_ORIG_ADDRESS,
@@ -33,46 +36,65 @@ static const int originators_mandatory[] = {
 	BATADV_ATTR_LAST_SEEN_MSECS,
 };
 
-static int originators_callback(struct nl_msg *msg, void *arg)
+static const struct table_column originators_columns[] = {
+	{ "best", BATADV_ATTR_FLAG_BEST, table_column_flag },
+	{ "orig_address", BATADV_ATTR_ORIG_ADDRESS, table_column_mac },
+	{ "last_seen_msecs", BATADV_ATTR_LAST_SEEN_MSECS, table_column_u32 },
+	{ "tq", BATADV_ATTR_TQ, table_column_u8 },
+	{ "throughput", BATADV_ATTR_THROUGHPUT, table_column_u32 },
+	{ "neigh_address", BATADV_ATTR_NEIGH_ADDRESS, table_column_mac },
+	{ "hard_ifname", BATADV_ATTR_HARD_IFNAME, table_column_ifname },
+};
+
+static const struct table_sort_key originators_sort_keys[] = {
+	{ "tq", BATADV_ATTR_TQ, TABLE_SORT_U8, true },
+	{ "throughput", BATADV_ATTR_THROUGHPUT, TABLE_SORT_U32, true },
+	{ "last-seen", BATADV_ATTR_LAST_SEEN_MSECS, TABLE_SORT_U32, false },
+	{ "address", BATADV_ATTR_ORIG_ADDRESS, TABLE_SORT_MAC, false },
+};
+
+static void originators_print_addr(struct print_opts *opts, uint8_t *addr)
+{
+	struct bat_host *bat_host = NULL;
+
+	if (opts->read_opt & USE_BAT_HOSTS)
+		bat_host = bat_hosts_find_by_mac((char *)addr);
+
+	if (bat_host)
+		outbuf_str(opts->out, bat_host->name, 17);
+	else
+		outbuf_mac(opts->out, addr);
+}
+
+/* skip timed out originators */
+static bool originators_match(struct nlattr *attrs[],
+			      const struct print_opts *opts)
+{
+	uint32_t last_seen_msecs;
+	float last_seen;
+
+	if (!(opts->read_opt & NO_OLD_ORIGS))
+		return true;
+
+	last_seen_msecs = nla_get_u32(attrs[BATADV_ATTR_LAST_SEEN_MSECS]);
+	last_seen = (float)last_seen_msecs / 1000.0;
+
+	return last_seen <= opts->orig_timeout;
+}
+
+static void originators_print(struct nlattr *attrs[], struct print_opts *opts)
 {
 	unsigned throughput_mbits, throughput_kbits;
-	struct nlattr *attrs[BATADV_ATTR_MAX+1];
-	struct nlmsghdr *nlh = nlmsg_hdr(msg);
 	int last_seen_msecs, last_seen_secs;
-	struct print_opts *opts = arg;
 	char ifname_buf[IF_NAMESIZE];
 	struct bat_host *bat_host;
-	struct genlmsghdr *ghdr;
 	uint32_t ifindex;
-	float last_seen;
 	uint8_t *neigh;
 	uint8_t *orig;
 	char *ifname;
 	char c = ' ';
 	uint8_t tq;
 
-	if (!genlmsg_valid_hdr(nlh, 0)) {
-		fputs("Received invalid data from kernel.\n", stderr);
-		exit(1);
-	}
-
-	ghdr = nlmsg_data(nlh);
-
-	if (ghdr->cmd != BATADV_CMD_GET_ORIGINATORS)
-		return NL_OK;
-
-	if (nla_parse(attrs, BATADV_ATTR_MAX, genlmsg_attrdata(ghdr, 0),
-		      genlmsg_len(ghdr), batadv_netlink_policy)) {
-		fputs("Received invalid data from kernel.\n", stderr);
-		exit(1);
-	}
-
-	if (missing_mandatory_attrs(attrs, originators_mandatory,
-				       ARRAY_SIZE(originators_mandatory))) {
-		fputs("Missing attributes from kernel\n", stderr);
-		exit(1);
-	}
-
 	orig = nla_data(attrs[BATADV_ATTR_ORIG_ADDRESS]);
 	neigh = nla_data(attrs[BATADV_ATTR_NEIGH_ADDRESS]);
 
@@ -91,92 +113,67 @@ static int originators_callback(struct nl_msg *msg, void *arg)
 		c = '*';
 
 	last_seen_msecs = nla_get_u32(attrs[BATADV_ATTR_LAST_SEEN_MSECS]);
-	last_seen = (float)last_seen_msecs / 1000.0;
 	last_seen_secs = last_seen_msecs / 1000;
 	last_seen_msecs = last_seen_msecs % 1000;
 
-	/* skip timed out originators */
-	if (opts->read_opt & NO_OLD_ORIGS)
-		if (last_seen > opts->orig_timeout)
-			return NL_OK;
+	if (!attrs[BATADV_ATTR_THROUGHPUT] && !attrs[BATADV_ATTR_TQ])
+		return;
+
+	outbuf_putc(opts->out, ' ');
+	outbuf_putc(opts->out, c);
+	outbuf_putc(opts->out, ' ');
+	originators_print_addr(opts, orig);
+	outbuf_putc(opts->out, ' ');
+	outbuf_int(opts->out, last_seen_secs, 4);
+	outbuf_putc(opts->out, '.');
+	outbuf_uint_zero(opts->out, last_seen_msecs, 3);
+	outbuf_putc(opts->out, 's');
 
 	if (attrs[BATADV_ATTR_THROUGHPUT]) {
 		throughput_kbits = nla_get_u32(attrs[BATADV_ATTR_THROUGHPUT]);
 		throughput_mbits = throughput_kbits / 1000;
 		throughput_kbits = throughput_kbits % 1000;
 
-		if (!(opts->read_opt & USE_BAT_HOSTS)) {
-			printf(" %c %02x:%02x:%02x:%02x:%02x:%02x %4i.%03is (%9u.%1u) %02x:%02x:%02x:%02x:%02x:%02x [%10s]\n",
-			       c,
-			       orig[0], orig[1], orig[2],
-			       orig[3], orig[4], orig[5],
-			       last_seen_secs, last_seen_msecs,
-			       throughput_mbits, throughput_kbits / 100,
-			       neigh[0], neigh[1], neigh[2],
-			       neigh[3], neigh[4], neigh[5],
-			       ifname);
-		} else {
-			bat_host = bat_hosts_find_by_mac((char *)orig);
-			if (bat_host)
-				printf(" %c %17s ", c, bat_host->name);
-			else
-				printf(" %c %02x:%02x:%02x:%02x:%02x:%02x ",
-				       c,
-				       orig[0], orig[1], orig[2],
-				       orig[3], orig[4], orig[5]);
-			printf("%4i.%03is (%9u.%1u) ",
-			       last_seen_secs, last_seen_msecs,
-			       throughput_mbits, throughput_kbits / 100);
+		outbuf_str(opts->out, " (", 0);
+		outbuf_uint(opts->out, throughput_mbits, 9);
+		outbuf_putc(opts->out, '.');
+		outbuf_uint(opts->out, throughput_kbits / 100, 1);
+		outbuf_str(opts->out, ") ", 0);
+
+		if (opts->read_opt & USE_BAT_HOSTS) {
+			outbuf_putc(opts->out, ' ');
+
 			bat_host = bat_hosts_find_by_mac((char *)neigh);
-			if (bat_host)
-				printf(" %c %17s ", c, bat_host->name);
-			else
-				printf(" %02x:%02x:%02x:%02x:%02x:%02x ",
-				       neigh[0], neigh[1], neigh[2],
-				       neigh[3], neigh[4], neigh[5]);
-			printf("[%10s]\n", ifname);
+			if (bat_host) {
+				outbuf_putc(opts->out, c);
+				outbuf_putc(opts->out, ' ');
+			}
 		}
-	}
-	if (attrs[BATADV_ATTR_TQ]) {
+	} else {
 		tq = nla_get_u8(attrs[BATADV_ATTR_TQ]);
 
-		if (!(opts->read_opt & USE_BAT_HOSTS)) {
-			printf(" %c %02x:%02x:%02x:%02x:%02x:%02x %4i.%03is   (%3i) %02x:%02x:%02x:%02x:%02x:%02x [%10s]\n",
-			       c,
-			       orig[0], orig[1], orig[2],
-			       orig[3], orig[4], orig[5],
-			       last_seen_secs, last_seen_msecs, tq,
-			       neigh[0], neigh[1], neigh[2],
-			       neigh[3], neigh[4], neigh[5],
-			       ifname);
-		} else {
-			bat_host = bat_hosts_find_by_mac((char *)orig);
-			if (bat_host)
-				printf(" %c %17s ", c, bat_host->name);
-			else
-				printf(" %c %02x:%02x:%02x:%02x:%02x:%02x ",
-				       c,
-				       orig[0], orig[1], orig[2],
-				       orig[3], orig[4], orig[5]);
-			printf("%4i.%03is   (%3i) ",
-			       last_seen_secs, last_seen_msecs, tq);
-			bat_host = bat_hosts_find_by_mac((char *)neigh);
-			if (bat_host)
-				printf("%17s ", bat_host->name);
-			else
-				printf("%02x:%02x:%02x:%02x:%02x:%02x ",
-				       neigh[0], neigh[1], neigh[2],
-				       neigh[3], neigh[4], neigh[5]);
-			printf("[%10s]\n", ifname);
-		}
+		outbuf_str(opts->out, "   (", 0);
+		outbuf_int(opts->out, tq, 3);
+		outbuf_str(opts->out, ") ", 0);
 	}
 
-	return NL_OK;
+	originators_print_addr(opts, neigh);
+	outbuf_str(opts->out, " [", 0);
+	outbuf_str(opts->out, ifname, 10);
+	outbuf_str(opts->out, "]\n", 0);
 }
 
+static const struct table_rows originators_rows = {
+	.mandatory = originators_mandatory,
+	.num_mandatory = ARRAY_SIZE(originators_mandatory),
+	.match = originators_match,
+	.print = originators_print,
+};
+
 static int netlink_print_originators(struct state *state, char *orig_iface,
 				     int read_opts, float orig_timeout,
-				     float watch_interval)
+				     float watch_interval,
+				     const struct table_opts *table)
 {
 	char *header = NULL;
 	char *info_header;
@@ -200,11 +197,15 @@ static int netlink_print_originators(struct state *state, char *orig_iface,
 	return netlink_print_common(state, orig_iface, read_opts,
 				    orig_timeout, watch_interval, header,
 				    BATADV_CMD_GET_ORIGINATORS,
-				    originators_callback);
+				    &originators_rows, table);
 }
 
 static struct debug_table_data batctl_debug_table_originators = {
 	.netlink_fn = netlink_print_originators,
+	.columns = originators_columns,
+	.num_columns = ARRAY_SIZE(originators_columns),
+	.sort_keys = originators_sort_keys,
+	.num_sort_keys = ARRAY_SIZE(originators_sort_keys),
 	.option_timeout_interval = 1,
 	.option_orig_iface = 1,
 };
@@ -0,0 +1,263 @@
+// SPDX-License-Identifier: GPL-2.0
+/* Copyright (C) B.A.T.M.A.N. contributors:
+ *
+ * License-Filename: LICENSES/preferred/GPL-2.0
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "output.h"
+
+static const char outbuf_hex_digits[] = "0123456789abcdef";
+
+static const char outbuf_dec_pairs[] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+int outbuf_init(struct outbuf *ob, FILE *fp)
+{
+	memset(ob, 0, sizeof(*ob));
+
+	ob->data = malloc(OUTBUF_SIZE);
+	if (!ob->data)
+		return -ENOMEM;
+
+	ob->size = OUTBUF_SIZE;
+	ob->fp = fp;
+
+	return 0;
+}
+
+void outbuf_free(struct outbuf *ob)
+{
+	free(ob->data);
+	memset(ob, 0, sizeof(*ob));
+}
+
+void outbuf_flush(struct outbuf *ob)
+{
+	if (!ob->fp || ob->len == 0)
+		return;
+
+	if (fwrite(ob->data, 1, ob->len, ob->fp) != ob->len)
+		ob->error = true;
+
+	ob->len = 0;
+}
+
+/* returns space for len more bytes; the caller has to advance ob->len */
+static char *outbuf_reserve(struct outbuf *ob, size_t len)
+{
+	size_t size;
+	char *data;
+
+	if (ob->size - ob->len >= len)
+		return &ob->data[ob->len];
+
+	if (ob->fp) {
+		outbuf_flush(ob);
+
+		if (ob->size - ob->len >= len)
+			return &ob->data[ob->len];
+	}
+
+	size = ob->size ? ob->size : OUTBUF_SIZE;
+	while (size - ob->len < len)
+		size *= 2;
+
+	data = realloc(ob->data, size);
+	if (!data) {
+		ob->error = true;
+		return NULL;
+	}
+
+	ob->data = data;
+	ob->size = size;
+
+	return &ob->data[ob->len];
+}
+
+void outbuf_write(struct outbuf *ob, const void *data, size_t len)
+{
+	char *dst;
+
+	/* don't grow the buffer just to copy large blocks to the stream */
+	if (ob->fp && len >= ob->size) {
+		outbuf_flush(ob);
+		if (fwrite(data, 1, len, ob->fp) != len)
+			ob->error = true;
+
+		return;
+	}
+
+	dst = outbuf_reserve(ob, len);
+	if (!dst)
+		return;
+
+	memcpy(dst, data, len);
+	ob->len += len;
+}
+
+void outbuf_putc(struct outbuf *ob, char c)
+{
+	char *dst;
+
+	dst = outbuf_reserve(ob, 1);
+	if (!dst)
+		return;
+
+	*dst = c;
+	ob->len++;
+}
+
+static void outbuf_pad(struct outbuf *ob, const char *str, size_t len,
+		       unsigned int width, char pad)
+{
+	size_t pad_len = 0;
+	char *dst;
+
+	if (width > len)
+		pad_len = width - len;
+
+	dst = outbuf_reserve(ob, pad_len + len);
+	if (!dst)
+		return;
+
+	memset(dst, pad, pad_len);
+	memcpy(dst + pad_len, str, len);
+	ob->len += pad_len + len;
+}
+
+/* like printf("%*s") */
+void outbuf_str(struct outbuf *ob, const char *str, unsigned int width)
+{
+	outbuf_pad(ob, str, strlen(str), width, ' ');
+}
+
+/* converts val to decimal digits at the end of buf, two digits per step */
+static char *outbuf_itoa(char *end, unsigned long val)
+{
+	char *p = end;
+	unsigned int idx;
+
+	while (val >= 100) {
+		idx = (val % 100) * 2;
+		val /= 100;
+		*--p = outbuf_dec_pairs[idx + 1];
+		*--p = outbuf_dec_pairs[idx];
+	}
+
+	if (val >= 10) {
+		idx = val * 2;
+		*--p = outbuf_dec_pairs[idx + 1];
+		*--p = outbuf_dec_pairs[idx];
+	} else {
+		*--p = '0' + val;
+	}
+
+	return p;
+}
+
+/* like printf("%*ld") */
+void outbuf_int(struct outbuf *ob, long val, unsigned int width)
+{
+	char buf[24];
+	char *end = buf + sizeof(buf);
+	char *p;
+
+	if (val < 0) {
+		p = outbuf_itoa(end, -(unsigned long)val);
+		*--p = '-';
+	} else {
+		p = outbuf_itoa(end, val);
+	}
+
+	outbuf_pad(ob, p, end - p, width, ' ');
+}
+
+/* like printf("%*lu") */
+void outbuf_uint(struct outbuf *ob, unsigned long val, unsigned int width)
+{
+	char buf[24];
+	char *end = buf + sizeof(buf);
+	char *p;
+
+	p = outbuf_itoa(end, val);
+	outbuf_pad(ob, p, end - p, width, ' ');
+}
+
+/* like printf("%0*lu") */
+void outbuf_uint_zero(struct outbuf *ob, unsigned long val,
+		      unsigned int width)
+{
+	char buf[24];
+	char *end = buf + sizeof(buf);
+	char *p;
+
+	p = outbuf_itoa(end, val);
+	outbuf_pad(ob, p, end - p, width, '0');
+}
+
+/* like printf("%" PRIu64) - unsigned long is only 32 bit on some targets */
+void outbuf_u64(struct outbuf *ob, uint64_t val)
+{
+	char buf[24];
+	char *end = buf + sizeof(buf);
+	char *p = end;
+
+	do {
+		*--p = '0' + val % 10;
+		val /= 10;
+	} while (val);
+
+	outbuf_write(ob, p, end - p);
+}
+
+/* like printf("%0*lx") */
+void outbuf_hex(struct outbuf *ob, unsigned long val, unsigned int digits)
+{
+	char buf[2 * sizeof(val)];
+	char *end = buf + sizeof(buf);
+	char *p = end;
+
+	do {
+		*--p = outbuf_hex_digits[val & 0xf];
+		val >>= 4;
+	} while (val);
+
+	outbuf_pad(ob, p, end - p, digits, '0');
+}
+
+/* like printf("%02x:%02x:%02x:%02x:%02x:%02x") */
+void outbuf_mac(struct outbuf *ob, const uint8_t *mac)
+{
+	char *dst;
+	int i;
+
+	dst = outbuf_reserve(ob, 17);
+	if (!dst)
+		return;
+
+	for (i = 0; i < 6; i++) {
+		if (i)
+			*dst++ = ':';
+
+		*dst++ = outbuf_hex_digits[mac[i] >> 4];
+		*dst++ = outbuf_hex_digits[mac[i] & 0xf];
+	}
+
+	ob->len += 17;
+}
@@ -0,0 +1,43 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/* Copyright (C) B.A.T.M.A.N. contributors:
+ *
+ * License-Filename: LICENSES/preferred/GPL-2.0
+ */
+
+#ifndef _BATCTL_OUTPUT_H
+#define _BATCTL_OUTPUT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define OUTBUF_SIZE (64 * 1024)
+
+/* append buffer for the debug table rows. it is written to fp with a single
+ * fwrite when it is full or flushed. without fp, everything is kept in memory
+ */
+struct outbuf {
+	char *data;
+	size_t len;
+	size_t size;
+	FILE *fp;
+	bool error;
+};
+
+int outbuf_init(struct outbuf *ob, FILE *fp);
+void outbuf_free(struct outbuf *ob);
+void outbuf_flush(struct outbuf *ob);
+
+void outbuf_write(struct outbuf *ob, const void *data, size_t len);
+void outbuf_putc(struct outbuf *ob, char c);
+void outbuf_str(struct outbuf *ob, const char *str, unsigned int width);
+void outbuf_int(struct outbuf *ob, long val, unsigned int width);
+void outbuf_uint(struct outbuf *ob, unsigned long val, unsigned int width);
+void outbuf_uint_zero(struct outbuf *ob, unsigned long val,
+		      unsigned int width);
+void outbuf_u64(struct outbuf *ob, uint64_t val);
+void outbuf_hex(struct outbuf *ob, unsigned long val, unsigned int digits);
+void outbuf_mac(struct outbuf *ob, const uint8_t *mac);
+
+#endif /* _BATCTL_OUTPUT_H */
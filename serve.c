@@ -0,0 +1,417 @@
+// SPDX-License-Identifier: GPL-2.0
+/* Copyright (C) B.A.T.M.A.N. contributors:
+ *
+ * License-Filename: LICENSES/preferred/GPL-2.0
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "main.h"
+#include "functions.h"
+#include "genl_json.h"
+#include "netlink.h"
+
+#define SERVE_MAX_ARGS 16
+#define SERVE_LINE_LEN 256
+#define SERVE_CACHE_SIZE 32
+#define SERVE_DEFAULT_MAX_AGE 1000
+#define SERVE_CLIENT_TIMEOUT 2
+
+struct serve_cache_entry {
+	const struct command *cmd;
+	unsigned int mesh_ifindex;
+	enum selector_prefix selector;
+	unsigned int hif_vid;
+	struct timespec stamp;
+	char *buf;
+	size_t len;
+};
+
+struct serve_opts {
+	unsigned int max_age;
+	unsigned int num_entries;
+	struct serve_cache_entry cache[SERVE_CACHE_SIZE];
+};
+
+static volatile sig_atomic_t is_aborted = 0;
+
+static void serve_usage(void)
+{
+	fprintf(stderr, "Usage: batctl [options] serve [parameters] <path>\n");
+	fprintf(stderr, "parameters:\n");
+	fprintf(stderr, " \t -h print this help\n");
+	fprintf(stderr, " \t -t <ms> reuse dumps younger than <ms> milliseconds (default %u)\n",
+		SERVE_DEFAULT_MAX_AGE);
+}
+
+static void sig_handler(int sig)
+{
+	switch (sig) {
+	case SIGINT:
+	case SIGTERM:
+		is_aborted = 1;
+		break;
+	default:
+		break;
+	}
+}
+
+static unsigned int serve_age_ms(const struct timespec *stamp)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (now.tv_sec - stamp->tv_sec) * 1000 +
+	       (now.tv_nsec - stamp->tv_nsec) / 1000000;
+}
+
+static int serve_write(int fd, const char *buf, size_t len)
+{
+	ssize_t ret;
+
+	while (len > 0) {
+		ret = send(fd, buf, len, MSG_NOSIGNAL);
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+
+			return -errno;
+		}
+
+		buf += ret;
+		len -= ret;
+	}
+
+	return 0;
+}
+
+static void serve_error(int fd, const char *msg)
+{
+	char buf[SERVE_LINE_LEN];
+	int len;
+
+	len = snprintf(buf, sizeof(buf), "{\"error\": \"%s\"}\n", msg);
+	if (len < 0)
+		return;
+
+	if ((size_t)len >= sizeof(buf))
+		len = sizeof(buf) - 1;
+
+	serve_write(fd, buf, len);
+}
+
+static struct serve_cache_entry *serve_cache_get(struct serve_opts *opts,
+						 struct state *state)
+{
+	struct serve_cache_entry *oldest = NULL;
+	struct serve_cache_entry *entry;
+	unsigned int hif_vid = 0;
+	unsigned int i;
+
+	if (state->selector == SP_VLAN || state->selector == SP_HARDIF)
+		hif_vid = state->hif;
+
+	for (i = 0; i < opts->num_entries; i++) {
+		entry = &opts->cache[i];
+
+		if (entry->cmd == state->cmd &&
+		    entry->mesh_ifindex == state->mesh_ifindex &&
+		    entry->selector == state->selector &&
+		    entry->hif_vid == hif_vid)
+			return entry;
+
+		if (!oldest ||
+		    serve_age_ms(&entry->stamp) > serve_age_ms(&oldest->stamp))
+			oldest = entry;
+	}
+
+	if (opts->num_entries < SERVE_CACHE_SIZE) {
+		entry = &opts->cache[opts->num_entries++];
+	} else {
+		entry = oldest;
+		free(entry->buf);
+	}
+
+	memset(entry, 0, sizeof(*entry));
+	entry->cmd = state->cmd;
+	entry->mesh_ifindex = state->mesh_ifindex;
+	entry->selector = state->selector;
+	entry->hif_vid = hif_vid;
+
+	return entry;
+}
+
+static int serve_cache_refresh(struct state *state,
+			       struct serve_cache_entry *entry)
+{
+	char *buf = NULL;
+	size_t len = 0;
+	FILE *fp;
+	int ret;
+
+	fp = open_memstream(&buf, &len);
+	if (!fp)
+		return -errno;
+
+	ret = netlink_print_query_json(state, fp, NULL);
+	fclose(fp);
+
+	if (ret < 0) {
+		free(buf);
+		return ret;
+	}
+
+	free(entry->buf);
+	entry->buf = buf;
+	entry->len = len;
+	clock_gettime(CLOCK_MONOTONIC, &entry->stamp);
+
+	return 0;
+}
+
+static void serve_cache_free(struct serve_opts *opts)
+{
+	unsigned int i;
+
+	for (i = 0; i < opts->num_entries; i++)
+		free(opts->cache[i].buf);
+
+	opts->num_entries = 0;
+}
+
+static void serve_request(struct serve_opts *opts, struct state *serve_state,
+			  int fd, char *line)
+{
+	struct serve_cache_entry *entry;
+	char *argv[SERVE_MAX_ARGS];
+	const struct command *cmd;
+	int dev_arguments;
+	struct state state = {
+		.arg_iface = serve_state->arg_iface,
+		.selector = SP_NONE_OR_MESHIF,
+		.cmd = NULL,
+		.sock = serve_state->sock,
+		.cb = serve_state->cb,
+		.batadv_family = serve_state->batadv_family,
+	};
+	int argc;
+	int ret;
+
+	argc = split_command_line(line, argv, SERVE_MAX_ARGS);
+	if (argc <= 0) {
+		serve_error(fd, "invalid request");
+		return;
+	}
+
+	dev_arguments = parse_dev_args(&state, argc, argv);
+	if (dev_arguments < 0 || dev_arguments + 1 != argc ||
+	    state.selector == SP_ALL_MESHIFS) {
+		serve_error(fd, "invalid request");
+		return;
+	}
+
+	cmd = find_command(&state, argv[dev_arguments]);
+	if (!cmd || cmd->handler != handle_json_query) {
+		serve_error(fd, "no valid JSON query specified");
+		return;
+	}
+
+	state.cmd = cmd;
+
+	if (check_mesh_iface(&state) < 0) {
+		serve_error(fd, "not a batman-adv interface");
+		return;
+	}
+
+	entry = serve_cache_get(opts, &state);
+	if (!entry->buf || serve_age_ms(&entry->stamp) >= opts->max_age) {
+		ret = serve_cache_refresh(&state, entry);
+		if (ret < 0) {
+			serve_error(fd, strerror(-ret));
+			return;
+		}
+	}
+
+	serve_write(fd, entry->buf, entry->len);
+}
+
+static void serve_client(struct serve_opts *opts, struct state *state, int fd)
+{
+	struct timeval timeout = {
+		.tv_sec = SERVE_CLIENT_TIMEOUT,
+	};
+	char line[SERVE_LINE_LEN];
+	size_t len = 0;
+	ssize_t ret;
+
+	/* a stalled client must not block the other collectors for long */
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+	while (len < sizeof(line) - 1) {
+		ret = recv(fd, line + len, sizeof(line) - 1 - len, 0);
+		if (ret < 0 && errno == EINTR && !is_aborted)
+			continue;
+
+		if (ret <= 0)
+			break;
+
+		len += ret;
+		if (memchr(line + len - ret, '\n', ret))
+			break;
+	}
+
+	line[len] = '\0';
+	if (!memchr(line, '\n', len) && len == sizeof(line) - 1) {
+		serve_error(fd, "request too long");
+		return;
+	}
+
+	serve_request(opts, state, fd, line);
+}
+
+static int serve_listen(const char *path)
+{
+	struct sockaddr_un addr = {
+		.sun_family = AF_UNIX,
+	};
+	struct stat st;
+	int fd;
+
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		fprintf(stderr, "Error - socket path too long: %s\n", path);
+		return -ENAMETOOLONG;
+	}
+
+	strcpy(addr.sun_path, path);
+
+	/* only remove stale sockets, never regular files */
+	if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode))
+		unlink(path);
+
+	fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		fprintf(stderr, "Error - can't create socket: %s\n",
+			strerror(errno));
+		return -errno;
+	}
+
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		fprintf(stderr, "Error - can't bind to %s: %s\n", path,
+			strerror(errno));
+		close(fd);
+		return -errno;
+	}
+
+	if (listen(fd, 16) < 0) {
+		fprintf(stderr, "Error - can't listen on %s: %s\n", path,
+			strerror(errno));
+		close(fd);
+		unlink(path);
+		return -errno;
+	}
+
+	return fd;
+}
+
+static int serve(struct state *state, int argc, char **argv)
+{
+	struct serve_opts *opts;
+	struct sigaction sa;
+	unsigned long max_age;
+	char *endptr;
+	int listen_fd;
+	int optchar;
+	int fd;
+
+	opts = calloc(1, sizeof(*opts));
+	if (!opts) {
+		fprintf(stderr, "Error - could not allocate cache\n");
+		return EXIT_FAILURE;
+	}
+
+	opts->max_age = SERVE_DEFAULT_MAX_AGE;
+
+	while ((optchar = getopt(argc, argv, "ht:")) != -1) {
+		switch (optchar) {
+		case 'h':
+			serve_usage();
+			free(opts);
+			return EXIT_SUCCESS;
+		case 't':
+			max_age = strtoul(optarg, &endptr, 10);
+			if (!endptr || *endptr != '\0' || max_age > 3600000) {
+				fprintf(stderr, "Error - invalid freshness window: %s\n",
+					optarg);
+				free(opts);
+				return EXIT_FAILURE;
+			}
+			opts->max_age = max_age;
+			break;
+		default:
+			serve_usage();
+			free(opts);
+			return EXIT_FAILURE;
+		}
+	}
+
+	if (argc - optind != 1) {
+		fprintf(stderr, "Error - socket path not specified\n");
+		serve_usage();
+		free(opts);
+		return EXIT_FAILURE;
+	}
+
+	check_root_or_die("batctl serve");
+
+	listen_fd = serve_listen(argv[optind]);
+	if (listen_fd < 0) {
+		free(opts);
+		return EXIT_FAILURE;
+	}
+
+	/* no SA_RESTART: accept() has to return on SIGINT/SIGTERM */
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = sig_handler;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+
+	while (!is_aborted) {
+		fd = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC);
+		if (fd < 0) {
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+
+			fprintf(stderr, "Error - accept failed: %s\n",
+				strerror(errno));
+			break;
+		}
+
+		serve_client(opts, state, fd);
+		close(fd);
+	}
+
+	close(listen_fd);
+	unlink(argv[optind]);
+	serve_cache_free(opts);
+	free(opts);
+
+	return EXIT_SUCCESS;
+}
+
+COMMAND(SUBCOMMAND, serve, "se", COMMAND_FLAG_NETLINK, NULL,
+	"<path>            \tanswer JSON queries on a UNIX socket with cached dumps");
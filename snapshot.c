@@ -0,0 +1,1221 @@
+// SPDX-License-Identifier: GPL-2.0
+/* Copyright (C) B.A.T.M.A.N. contributors:
+ *
+ * License-Filename: LICENSES/preferred/GPL-2.0
+ */
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <getopt.h>
+#include <net/ethernet.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <netlink/genl/genl.h>
+#include <netlink/netlink.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "batadv_packet.h"
+#include "batman_adv.h"
+#include "bat-hosts.h"
+#include "functions.h"
+#include "main.h"
+#include "netlink.h"
+#include "output.h"
+
+/* file layout (all integers are LEB128 varints unless noted otherwise):
+ *
+ *   "BATS" u8:version varint:unix_time varint:len mesh_iface
+ *   section* (u8:table_id varint:len payload)
+ *   u8:0 (end of file)
+ *
+ * a section payload is varint:num_fields varint:num_records followed by the
+ * records, sorted by their key fields. each record starts with a bitmap of
+ * the present fields; flags are only stored in the bitmap, MAC addresses as
+ * 6 bytes (48 bit big endian integer), IPv4 addresses as 4 bytes and
+ * interface names as varint:len bytes
+ */
+#define SNAPSHOT_MAGIC "BATS"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_MAX_FIELDS 10
+
+enum snapshot_field_type {
+	SNAPSHOT_MAC,
+	SNAPSHOT_U8,
+	SNAPSHOT_U16,
+	SNAPSHOT_U32,
+	SNAPSHOT_VID,
+	SNAPSHOT_IPV4,
+	SNAPSHOT_FLAG,
+	SNAPSHOT_IFNAME,
+};
+
+enum snapshot_field_flags {
+	/* printed in hex */
+	SNAPSHOT_F_HEX = BIT(0),
+	/* changes with every dump, saved but not compared */
+	SNAPSHOT_F_TRANSIENT = BIT(1),
+};
+
+struct snapshot_field {
+	const char *name;
+	int attr;
+	enum snapshot_field_type type;
+	unsigned int flags;
+};
+
+/* the first num_keys fields identify a row. at most one field per table can
+ * be an interface name
+ */
+struct snapshot_table {
+	uint8_t id;
+	const char *name;
+	uint8_t nl_cmd;
+	const struct snapshot_field *fields;
+	size_t num_fields;
+	size_t num_keys;
+};
+
+struct snapshot_record {
+	uint32_t present;
+	uint64_t values[SNAPSHOT_MAX_FIELDS];
+	char ifname[IF_NAMESIZE];
+};
+
+struct snapshot_section {
+	struct snapshot_record *records;
+	size_t num_records;
+	size_t max_records;
+};
+
+struct snapshot_dump {
+	const struct snapshot_table *table;
+	struct snapshot_section section;
+	struct nlquery_opts query_opts;
+};
+
+struct snapshot_cursor {
+	const uint8_t *pos;
+	const uint8_t *end;
+	bool error;
+};
+
+static const struct snapshot_field snapshot_originators_fields[] = {
+	{ "orig", BATADV_ATTR_ORIG_ADDRESS, SNAPSHOT_MAC, 0 },
+	{ "neigh", BATADV_ATTR_NEIGH_ADDRESS, SNAPSHOT_MAC, 0 },
+	{ "ifname", BATADV_ATTR_HARD_IFNAME, SNAPSHOT_IFNAME, 0 },
+	{ "tq", BATADV_ATTR_TQ, SNAPSHOT_U8, 0 },
+	{ "throughput", BATADV_ATTR_THROUGHPUT, SNAPSHOT_U32, 0 },
+	{ "best", BATADV_ATTR_FLAG_BEST, SNAPSHOT_FLAG, 0 },
+	{ "last_seen", BATADV_ATTR_LAST_SEEN_MSECS, SNAPSHOT_U32,
+	  SNAPSHOT_F_TRANSIENT },
+};
+
+static const struct snapshot_field snapshot_neighbors_fields[] = {
+	{ "ifname", BATADV_ATTR_HARD_IFNAME, SNAPSHOT_IFNAME, 0 },
+	{ "neigh", BATADV_ATTR_NEIGH_ADDRESS, SNAPSHOT_MAC, 0 },
+	{ "throughput", BATADV_ATTR_THROUGHPUT, SNAPSHOT_U32, 0 },
+	{ "last_seen", BATADV_ATTR_LAST_SEEN_MSECS, SNAPSHOT_U32,
+	  SNAPSHOT_F_TRANSIENT },
+};
+
+static const struct snapshot_field snapshot_translocal_fields[] = {
+	{ "client", BATADV_ATTR_TT_ADDRESS, SNAPSHOT_MAC, 0 },
+	{ "vid", BATADV_ATTR_TT_VID, SNAPSHOT_VID, 0 },
+	{ "flags", BATADV_ATTR_TT_FLAGS, SNAPSHOT_U32, SNAPSHOT_F_HEX },
+	{ "crc32", BATADV_ATTR_TT_CRC32, SNAPSHOT_U32, SNAPSHOT_F_HEX },
+	{ "last_seen", BATADV_ATTR_LAST_SEEN_MSECS, SNAPSHOT_U32,
+	  SNAPSHOT_F_TRANSIENT },
+};
+
+static const struct snapshot_field snapshot_transglobal_fields[] = {
+	{ "client", BATADV_ATTR_TT_ADDRESS, SNAPSHOT_MAC, 0 },
+	{ "vid", BATADV_ATTR_TT_VID, SNAPSHOT_VID, 0 },
+	{ "orig", BATADV_ATTR_ORIG_ADDRESS, SNAPSHOT_MAC, 0 },
+	{ "ttvn", BATADV_ATTR_TT_TTVN, SNAPSHOT_U8, 0 },
+	{ "last_ttvn", BATADV_ATTR_TT_LAST_TTVN, SNAPSHOT_U8, 0 },
+	{ "crc32", BATADV_ATTR_TT_CRC32, SNAPSHOT_U32, SNAPSHOT_F_HEX },
+	{ "flags", BATADV_ATTR_TT_FLAGS, SNAPSHOT_U32, SNAPSHOT_F_HEX },
+	{ "best", BATADV_ATTR_FLAG_BEST, SNAPSHOT_FLAG, 0 },
+};
+
+static const struct snapshot_field snapshot_gateways_fields[] = {
+	{ "orig", BATADV_ATTR_ORIG_ADDRESS, SNAPSHOT_MAC, 0 },
+	{ "router", BATADV_ATTR_ROUTER, SNAPSHOT_MAC, 0 },
+	{ "ifname", BATADV_ATTR_HARD_IFNAME, SNAPSHOT_IFNAME, 0 },
+	{ "bandwidth_down", BATADV_ATTR_BANDWIDTH_DOWN, SNAPSHOT_U32, 0 },
+	{ "bandwidth_up", BATADV_ATTR_BANDWIDTH_UP, SNAPSHOT_U32, 0 },
+	{ "throughput", BATADV_ATTR_THROUGHPUT, SNAPSHOT_U32, 0 },
+	{ "tq", BATADV_ATTR_TQ, SNAPSHOT_U8, 0 },
+	{ "best", BATADV_ATTR_FLAG_BEST, SNAPSHOT_FLAG, 0 },
+};
+
+static const struct snapshot_field snapshot_claims_fields[] = {
+	{ "client", BATADV_ATTR_BLA_ADDRESS, SNAPSHOT_MAC, 0 },
+	{ "vid", BATADV_ATTR_BLA_VID, SNAPSHOT_VID, 0 },
+	{ "backbone", BATADV_ATTR_BLA_BACKBONE, SNAPSHOT_MAC, 0 },
+	{ "crc", BATADV_ATTR_BLA_CRC, SNAPSHOT_U16, SNAPSHOT_F_HEX },
+	{ "own", BATADV_ATTR_BLA_OWN, SNAPSHOT_FLAG, 0 },
+};
+
+static const struct snapshot_field snapshot_backbones_fields[] = {
+	{ "backbone", BATADV_ATTR_BLA_ADDRESS, SNAPSHOT_MAC, 0 },
+	{ "vid", BATADV_ATTR_BLA_VID, SNAPSHOT_VID, 0 },
+	{ "crc", BATADV_ATTR_BLA_CRC, SNAPSHOT_U16, SNAPSHOT_F_HEX },
+	{ "own", BATADV_ATTR_BLA_OWN, SNAPSHOT_FLAG, 0 },
+	{ "last_seen", BATADV_ATTR_LAST_SEEN_MSECS, SNAPSHOT_U32,
+	  SNAPSHOT_F_TRANSIENT },
+};
+
+static const struct snapshot_field snapshot_dat_cache_fields[] = {
+	{ "ip", BATADV_ATTR_DAT_CACHE_IP4ADDRESS, SNAPSHOT_IPV4, 0 },
+	{ "vid", BATADV_ATTR_DAT_CACHE_VID, SNAPSHOT_VID, 0 },
+	{ "mac", BATADV_ATTR_DAT_CACHE_HWADDRESS, SNAPSHOT_MAC, 0 },
+	{ "last_seen", BATADV_ATTR_LAST_SEEN_MSECS, SNAPSHOT_U32,
+	  SNAPSHOT_F_TRANSIENT },
+};
+
+static const struct snapshot_field snapshot_mcast_flags_fields[] = {
+	{ "orig", BATADV_ATTR_ORIG_ADDRESS, SNAPSHOT_MAC, 0 },
+	{ "flags", BATADV_ATTR_MCAST_FLAGS, SNAPSHOT_U32, SNAPSHOT_F_HEX },
+};
+
+/* the ids are part of the file format and must never be reused */
+static const struct snapshot_table snapshot_tables[] = {
+	{
+		1, "originators", BATADV_CMD_GET_ORIGINATORS,
+		snapshot_originators_fields,
+		ARRAY_SIZE(snapshot_originators_fields), 3,
+	},
+	{
+		2, "neighbors", BATADV_CMD_GET_NEIGHBORS,
+		snapshot_neighbors_fields,
+		ARRAY_SIZE(snapshot_neighbors_fields), 2,
+	},
+	{
+		3, "translocal", BATADV_CMD_GET_TRANSTABLE_LOCAL,
+		snapshot_translocal_fields,
+		ARRAY_SIZE(snapshot_translocal_fields), 2,
+	},
+	{
+		4, "transglobal", BATADV_CMD_GET_TRANSTABLE_GLOBAL,
+		snapshot_transglobal_fields,
+		ARRAY_SIZE(snapshot_transglobal_fields), 3,
+	},
+	{
+		5, "gateways", BATADV_CMD_GET_GATEWAYS,
+		snapshot_gateways_fields,
+		ARRAY_SIZE(snapshot_gateways_fields), 1,
+	},
+	{
+		6, "claimtable", BATADV_CMD_GET_BLA_CLAIM,
+		snapshot_claims_fields,
+		ARRAY_SIZE(snapshot_claims_fields), 2,
+	},
+	{
+		7, "backbonetable", BATADV_CMD_GET_BLA_BACKBONE,
+		snapshot_backbones_fields,
+		ARRAY_SIZE(snapshot_backbones_fields), 2,
+	},
+	{
+		8, "dat_cache", BATADV_CMD_GET_DAT_CACHE,
+		snapshot_dat_cache_fields,
+		ARRAY_SIZE(snapshot_dat_cache_fields), 2,
+	},
+	{
+		9, "mcast_flags", BATADV_CMD_GET_MCAST_FLAGS,
+		snapshot_mcast_flags_fields,
+		ARRAY_SIZE(snapshot_mcast_flags_fields), 1,
+	},
+};
+
+static void snapshot_usage(void)
+{
+	fprintf(stderr, "Usage: batctl [options] snapshot save <file>\n");
+	fprintf(stderr, "       batctl [options] snapshot diff [parameters] <file1> <file2>\n");
+	fprintf(stderr, "parameters:\n");
+	fprintf(stderr, " \t -h print this help\n");
+	fprintf(stderr, " \t -n don't replace mac addresses with bat-host names\n");
+}
+
+static void snapshot_put_varint(struct outbuf *out, uint64_t val)
+{
+	while (val >= 0x80) {
+		outbuf_putc(out, (char)(val | 0x80));
+		val >>= 7;
+	}
+
+	outbuf_putc(out, (char)val);
+}
+
+static uint64_t snapshot_get_varint(struct snapshot_cursor *cur)
+{
+	unsigned int shift = 0;
+	uint64_t val = 0;
+	uint8_t byte;
+
+	do {
+		if (cur->pos >= cur->end || shift > 63) {
+			cur->error = true;
+			return 0;
+		}
+
+		byte = *cur->pos++;
+		val |= (uint64_t)(byte & 0x7f) << shift;
+		shift += 7;
+	} while (byte & 0x80);
+
+	return val;
+}
+
+static const uint8_t *snapshot_get_bytes(struct snapshot_cursor *cur,
+					 uint64_t len)
+{
+	const uint8_t *data = cur->pos;
+
+	if (cur->error || len > (uint64_t)(cur->end - cur->pos)) {
+		cur->error = true;
+		return NULL;
+	}
+
+	cur->pos += len;
+
+	return data;
+}
+
+static int snapshot_section_add(struct snapshot_section *section,
+				const struct snapshot_record *record)
+{
+	struct snapshot_record *records;
+	size_t max_records;
+
+	if (section->num_records == section->max_records) {
+		max_records = section->max_records ? section->max_records * 2 : 64;
+		records = realloc(section->records,
+				  max_records * sizeof(*records));
+		if (!records)
+			return -ENOMEM;
+
+		section->records = records;
+		section->max_records = max_records;
+	}
+
+	section->records[section->num_records++] = *record;
+
+	return 0;
+}
+
+static uint64_t snapshot_mac_value(const uint8_t *mac)
+{
+	uint64_t val = 0;
+	int i;
+
+	for (i = 0; i < ETH_ALEN; i++)
+		val = (val << 8) | mac[i];
+
+	return val;
+}
+
+static void snapshot_value_mac(uint64_t val, uint8_t *mac)
+{
+	int i;
+
+	for (i = ETH_ALEN - 1; i >= 0; i--) {
+		mac[i] = val & 0xff;
+		val >>= 8;
+	}
+}
+
+static void snapshot_record_ifname(struct snapshot_record *record,
+				   struct nlattr *attrs[], int attr)
+{
+	uint32_t ifindex;
+
+	if (attrs[attr]) {
+		snprintf(record->ifname, sizeof(record->ifname), "%s",
+			 nla_get_string(attrs[attr]));
+		return;
+	}
+
+	/* older kernels only send the index */
+	if (!attrs[BATADV_ATTR_HARD_IFINDEX])
+		return;
+
+	ifindex = nla_get_u32(attrs[BATADV_ATTR_HARD_IFINDEX]);
+	if (!if_indextoname(ifindex, record->ifname))
+		record->ifname[0] = '\0';
+}
+
+static void snapshot_record_parse(const struct snapshot_table *table,
+				  struct nlattr *attrs[],
+				  struct snapshot_record *record)
+{
+	const struct snapshot_field *field;
+	struct nlattr *attr;
+	size_t i;
+
+	memset(record, 0, sizeof(*record));
+
+	for (i = 0; i < table->num_fields; i++) {
+		field = &table->fields[i];
+		attr = attrs[field->attr];
+
+		if (field->type == SNAPSHOT_IFNAME) {
+			snapshot_record_ifname(record, attrs, field->attr);
+			if (record->ifname[0] != '\0')
+				record->present |= BIT(i);
+			continue;
+		}
+
+		if (!attr)
+			continue;
+
+		switch (field->type) {
+		case SNAPSHOT_MAC:
+			record->values[i] = snapshot_mac_value(nla_data(attr));
+			break;
+		case SNAPSHOT_U8:
+			record->values[i] = nla_get_u8(attr);
+			break;
+		case SNAPSHOT_U16:
+		case SNAPSHOT_VID:
+			record->values[i] = nla_get_u16(attr);
+			break;
+		case SNAPSHOT_U32:
+			record->values[i] = nla_get_u32(attr);
+			break;
+		case SNAPSHOT_IPV4:
+			record->values[i] = ntohl(nla_get_u32(attr));
+			break;
+		case SNAPSHOT_FLAG:
+		case SNAPSHOT_IFNAME:
+			break;
+		}
+
+		record->present |= BIT(i);
+	}
+}
+
+static int snapshot_record_compare_keys(const struct snapshot_table *table,
+					const struct snapshot_record *record1,
+					const struct snapshot_record *record2)
+{
+	const struct snapshot_field *field;
+	uint32_t bit;
+	size_t i;
+	int ret;
+
+	for (i = 0; i < table->num_keys; i++) {
+		field = &table->fields[i];
+		bit = BIT(i);
+
+		if ((record1->present & bit) != (record2->present & bit))
+			return (record1->present & bit) ? 1 : -1;
+
+		if (field->type == SNAPSHOT_IFNAME) {
+			ret = strcmp(record1->ifname, record2->ifname);
+			if (ret)
+				return ret;
+
+			continue;
+		}
+
+		if (record1->values[i] != record2->values[i])
+			return record1->values[i] < record2->values[i] ? -1 : 1;
+	}
+
+	return 0;
+}
+
+/* qsort() has no context argument, the table is set right before sorting */
+static const struct snapshot_table *snapshot_sort_table;
+
+static int snapshot_record_sort(const void *data1, const void *data2)
+{
+	return snapshot_record_compare_keys(snapshot_sort_table, data1, data2);
+}
+
+static int snapshot_dump_cb(struct nl_msg *msg, void *arg)
+{
+	struct nlattr *attrs[BATADV_ATTR_MAX+1];
+	struct nlmsghdr *nlh = nlmsg_hdr(msg);
+	struct nlquery_opts *query_opts = arg;
+	struct snapshot_record record;
+	struct snapshot_dump *dump;
+	struct genlmsghdr *ghdr;
+
+	dump = container_of(query_opts, struct snapshot_dump, query_opts);
+
+	if (!genlmsg_valid_hdr(nlh, 0))
+		return NL_OK;
+
+	ghdr = nlmsg_data(nlh);
+	if (ghdr->cmd != dump->table->nl_cmd)
+		return NL_OK;
+
+	if (nla_parse(attrs, BATADV_ATTR_MAX, genlmsg_attrdata(ghdr, 0),
+		      genlmsg_len(ghdr), batadv_netlink_policy))
+		return NL_OK;
+
+	snapshot_record_parse(dump->table, attrs, &record);
+
+	if (snapshot_section_add(&dump->section, &record) < 0) {
+		query_opts->err = -ENOMEM;
+		return NL_STOP;
+	}
+
+	return NL_OK;
+}
+
+static void snapshot_record_encode(const struct snapshot_table *table,
+				   const struct snapshot_record *record,
+				   struct outbuf *out)
+{
+	const struct snapshot_field *field;
+	uint8_t mac[ETH_ALEN];
+	uint32_t ipv4;
+	size_t len;
+	size_t i;
+
+	snapshot_put_varint(out, record->present);
+
+	for (i = 0; i < table->num_fields; i++) {
+		field = &table->fields[i];
+
+		if (!(record->present & BIT(i)))
+			continue;
+
+		switch (field->type) {
+		case SNAPSHOT_MAC:
+			snapshot_value_mac(record->values[i], mac);
+			outbuf_write(out, mac, sizeof(mac));
+			break;
+		case SNAPSHOT_IPV4:
+			ipv4 = htonl(record->values[i]);
+			outbuf_write(out, &ipv4, sizeof(ipv4));
+			break;
+		case SNAPSHOT_U8:
+		case SNAPSHOT_U16:
+		case SNAPSHOT_U32:
+		case SNAPSHOT_VID:
+			snapshot_put_varint(out, record->values[i]);
+			break;
+		case SNAPSHOT_IFNAME:
+			len = strlen(record->ifname);
+			snapshot_put_varint(out, len);
+			outbuf_write(out, record->ifname, len);
+			break;
+		case SNAPSHOT_FLAG:
+			break;
+		}
+	}
+}
+
+static bool snapshot_record_decode(const struct snapshot_table *table,
+				   struct snapshot_cursor *cur,
+				   struct snapshot_record *record)
+{
+	const struct snapshot_field *field;
+	const uint8_t *data;
+	uint64_t present;
+	uint32_t ipv4;
+	uint64_t len;
+	size_t i;
+
+	memset(record, 0, sizeof(*record));
+
+	present = snapshot_get_varint(cur);
+	if (present >> table->num_fields)
+		cur->error = true;
+
+	record->present = present;
+
+	for (i = 0; i < table->num_fields && !cur->error; i++) {
+		field = &table->fields[i];
+
+		if (!(record->present & BIT(i)))
+			continue;
+
+		switch (field->type) {
+		case SNAPSHOT_MAC:
+			data = snapshot_get_bytes(cur, ETH_ALEN);
+			if (data)
+				record->values[i] = snapshot_mac_value(data);
+			break;
+		case SNAPSHOT_IPV4:
+			data = snapshot_get_bytes(cur, sizeof(ipv4));
+			if (data) {
+				memcpy(&ipv4, data, sizeof(ipv4));
+				record->values[i] = ntohl(ipv4);
+			}
+			break;
+		case SNAPSHOT_U8:
+		case SNAPSHOT_U16:
+		case SNAPSHOT_U32:
+		case SNAPSHOT_VID:
+			record->values[i] = snapshot_get_varint(cur);
+			break;
+		case SNAPSHOT_IFNAME:
+			len = snapshot_get_varint(cur);
+			if (len >= sizeof(record->ifname)) {
+				cur->error = true;
+				break;
+			}
+
+			data = snapshot_get_bytes(cur, len);
+			if (data)
+				memcpy(record->ifname, data, len);
+			break;
+		case SNAPSHOT_FLAG:
+			break;
+		}
+	}
+
+	return !cur->error;
+}
+
+static void snapshot_section_free(struct snapshot_section *section)
+{
+	free(section->records);
+	memset(section, 0, sizeof(*section));
+}
+
+static int snapshot_save_table(struct state *state,
+			       const struct snapshot_table *table,
+			       struct outbuf *payload)
+{
+	struct snapshot_dump dump = {
+		.table = table,
+	};
+	size_t i;
+	int err;
+
+	err = netlink_query_common(state, state->mesh_ifindex, table->nl_cmd,
+				   snapshot_dump_cb, NULL, NLM_F_DUMP,
+				   &dump.query_opts);
+	if (err < 0) {
+		snapshot_section_free(&dump.section);
+		return err;
+	}
+
+	snapshot_sort_table = table;
+	qsort(dump.section.records, dump.section.num_records,
+	      sizeof(*dump.section.records), snapshot_record_sort);
+
+	payload->len = 0;
+	snapshot_put_varint(payload, table->num_fields);
+	snapshot_put_varint(payload, dump.section.num_records);
+
+	for (i = 0; i < dump.section.num_records; i++)
+		snapshot_record_encode(table, &dump.section.records[i],
+				       payload);
+
+	snapshot_section_free(&dump.section);
+
+	return 0;
+}
+
+static int snapshot_save(struct state *state, const char *path)
+{
+	const struct snapshot_table *table;
+	struct outbuf payload;
+	struct outbuf out;
+	int ret = EXIT_SUCCESS;
+	size_t len;
+	FILE *fp;
+	size_t i;
+	int err;
+
+	if (check_mesh_iface(state) < 0) {
+		fprintf(stderr,
+			"Error - interface %s is not present or not a batman-adv interface\n",
+			state->mesh_iface);
+		return EXIT_FAILURE;
+	}
+
+	if (netlink_create(state) < 0) {
+		fprintf(stderr, "Error - failed to connect to batadv\n");
+		return EXIT_FAILURE;
+	}
+
+	fp = fopen(path, "wb");
+	if (!fp) {
+		fprintf(stderr, "Error - can't open %s: %s\n", path,
+			strerror(errno));
+		netlink_destroy(state);
+		return EXIT_FAILURE;
+	}
+
+	if (outbuf_init(&out, fp) < 0 || outbuf_init(&payload, NULL) < 0) {
+		fprintf(stderr, "Error - out of memory\n");
+		fclose(fp);
+		netlink_destroy(state);
+		return EXIT_FAILURE;
+	}
+
+	len = strlen(state->mesh_iface);
+	outbuf_write(&out, SNAPSHOT_MAGIC, strlen(SNAPSHOT_MAGIC));
+	outbuf_putc(&out, SNAPSHOT_VERSION);
+	snapshot_put_varint(&out, time(NULL));
+	snapshot_put_varint(&out, len);
+	outbuf_write(&out, state->mesh_iface, len);
+
+	for (i = 0; i < ARRAY_SIZE(snapshot_tables); i++) {
+		table = &snapshot_tables[i];
+
+		err = snapshot_save_table(state, table, &payload);
+
+		/* feature not compiled into batman-adv */
+		if (err == -EOPNOTSUPP)
+			continue;
+
+		if (err < 0) {
+			fprintf(stderr, "Error - can't dump %s: %s\n",
+				table->name, strerror(-err));
+			ret = EXIT_FAILURE;
+			break;
+		}
+
+		outbuf_putc(&out, table->id);
+		snapshot_put_varint(&out, payload.len);
+		outbuf_write(&out, payload.data, payload.len);
+	}
+
+	outbuf_putc(&out, 0);
+	outbuf_flush(&out);
+
+	if (out.error || fclose(fp) != 0) {
+		fprintf(stderr, "Error - can't write %s\n", path);
+		ret = EXIT_FAILURE;
+	}
+
+	outbuf_free(&payload);
+	outbuf_free(&out);
+	netlink_destroy(state);
+
+	return ret;
+}
+
+struct snapshot_file {
+	const char *path;
+	struct outbuf data;
+	char mesh_iface[IF_NAMESIZE];
+	time_t timestamp;
+	struct snapshot_section sections[ARRAY_SIZE(snapshot_tables)];
+	/* tables which were dumped; the others were not available */
+	bool available[ARRAY_SIZE(snapshot_tables)];
+};
+
+static int snapshot_read_data(struct snapshot_file *file)
+{
+	char buf[4096];
+	size_t len;
+	FILE *fp;
+
+	fp = fopen(file->path, "rb");
+	if (!fp) {
+		fprintf(stderr, "Error - can't open %s: %s\n", file->path,
+			strerror(errno));
+		return -1;
+	}
+
+	while ((len = fread(buf, 1, sizeof(buf), fp)) > 0)
+		outbuf_write(&file->data, buf, len);
+
+	if (ferror(fp) || file->data.error) {
+		fprintf(stderr, "Error - can't read %s\n", file->path);
+		fclose(fp);
+		return -1;
+	}
+
+	fclose(fp);
+
+	return 0;
+}
+
+static int snapshot_read_section(struct snapshot_file *file, size_t idx,
+				 struct snapshot_cursor *cur)
+{
+	const struct snapshot_table *table = &snapshot_tables[idx];
+	struct snapshot_section *section = &file->sections[idx];
+	struct snapshot_record record;
+	uint64_t num_records;
+	uint64_t i;
+
+	/* the layout of the table changed, a newer batctl wrote it */
+	if (snapshot_get_varint(cur) != table->num_fields) {
+		fprintf(stderr, "Warning - %s: unsupported layout of %s, skipped\n",
+			file->path, table->name);
+		return 0;
+	}
+
+	num_records = snapshot_get_varint(cur);
+
+	for (i = 0; i < num_records && !cur->error; i++) {
+		if (!snapshot_record_decode(table, cur, &record))
+			break;
+
+		if (snapshot_section_add(section, &record) < 0) {
+			fprintf(stderr, "Error - out of memory\n");
+			return -1;
+		}
+	}
+
+	if (cur->error || cur->pos != cur->end) {
+		fprintf(stderr, "Error - %s: corrupt %s section\n", file->path,
+			table->name);
+		return -1;
+	}
+
+	file->available[idx] = true;
+
+	return 0;
+}
+
+static int snapshot_read(struct snapshot_file *file)
+{
+	struct snapshot_cursor section_cur;
+	struct snapshot_cursor cur;
+	const uint8_t *data;
+	uint64_t len;
+	uint8_t id;
+	size_t i;
+
+	if (snapshot_read_data(file) < 0)
+		return -1;
+
+	cur.pos = (const uint8_t *)file->data.data;
+	cur.end = cur.pos + file->data.len;
+	cur.error = false;
+
+	data = snapshot_get_bytes(&cur, strlen(SNAPSHOT_MAGIC) + 1);
+	if (!data || memcmp(data, SNAPSHOT_MAGIC, strlen(SNAPSHOT_MAGIC)) != 0) {
+		fprintf(stderr, "Error - %s is not a batctl snapshot\n",
+			file->path);
+		return -1;
+	}
+
+	if (data[strlen(SNAPSHOT_MAGIC)] != SNAPSHOT_VERSION) {
+		fprintf(stderr, "Error - %s: unsupported snapshot version %u\n",
+			file->path, data[strlen(SNAPSHOT_MAGIC)]);
+		return -1;
+	}
+
+	file->timestamp = snapshot_get_varint(&cur);
+	len = snapshot_get_varint(&cur);
+	if (len >= sizeof(file->mesh_iface))
+		cur.error = true;
+
+	data = snapshot_get_bytes(&cur, len);
+	if (data)
+		memcpy(file->mesh_iface, data, len);
+
+	while (!cur.error) {
+		data = snapshot_get_bytes(&cur, 1);
+		if (!data)
+			break;
+
+		id = *data;
+		if (id == 0)
+			return 0;
+
+		len = snapshot_get_varint(&cur);
+		data = snapshot_get_bytes(&cur, len);
+		if (!data)
+			break;
+
+		section_cur.pos = data;
+		section_cur.end = data + len;
+		section_cur.error = false;
+
+		/* sections of unknown tables are skipped */
+		for (i = 0; i < ARRAY_SIZE(snapshot_tables); i++) {
+			if (snapshot_tables[i].id != id)
+				continue;
+
+			if (snapshot_read_section(file, i, &section_cur) < 0)
+				return -1;
+
+			break;
+		}
+	}
+
+	fprintf(stderr, "Error - %s is truncated\n", file->path);
+
+	return -1;
+}
+
+static void snapshot_file_free(struct snapshot_file *file)
+{
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(snapshot_tables); i++)
+		snapshot_section_free(&file->sections[i]);
+
+	outbuf_free(&file->data);
+}
+
+static void snapshot_print_mac(struct outbuf *out, uint64_t val, int read_opt)
+{
+	struct bat_host *bat_host;
+	uint8_t mac[ETH_ALEN];
+
+	snapshot_value_mac(val, mac);
+
+	if (!(read_opt & USE_BAT_HOSTS)) {
+		outbuf_mac(out, mac);
+		return;
+	}
+
+	bat_host = bat_hosts_find_by_mac((char *)mac);
+	if (!bat_host)
+		outbuf_mac(out, mac);
+	else
+		outbuf_str(out, bat_host->name, 0);
+}
+
+static void snapshot_print_value(struct outbuf *out,
+				 const struct snapshot_field *field,
+				 const struct snapshot_record *record,
+				 size_t idx, int read_opt)
+{
+	uint64_t val = record->values[idx];
+	struct in_addr in_addr;
+
+	if (!(record->present & BIT(idx))) {
+		outbuf_putc(out, '-');
+		return;
+	}
+
+	switch (field->type) {
+	case SNAPSHOT_MAC:
+		snapshot_print_mac(out, val, read_opt);
+		break;
+	case SNAPSHOT_IPV4:
+		in_addr.s_addr = htonl(val);
+		outbuf_str(out, inet_ntoa(in_addr), 0);
+		break;
+	case SNAPSHOT_VID:
+		outbuf_int(out, BATADV_PRINT_VID(val), 0);
+		break;
+	case SNAPSHOT_U8:
+	case SNAPSHOT_U16:
+	case SNAPSHOT_U32:
+		if (field->flags & SNAPSHOT_F_HEX) {
+			outbuf_str(out, "0x", 0);
+			outbuf_hex(out, val, field->type == SNAPSHOT_U16 ? 4 : 8);
+		} else {
+			outbuf_u64(out, val);
+		}
+		break;
+	case SNAPSHOT_FLAG:
+		outbuf_putc(out, '1');
+		break;
+	case SNAPSHOT_IFNAME:
+		outbuf_str(out, record->ifname, 0);
+		break;
+	}
+}
+
+static void snapshot_print_key(struct outbuf *out,
+			       const struct snapshot_table *table,
+			       const struct snapshot_record *record,
+			       char prefix, int read_opt)
+{
+	size_t i;
+
+	outbuf_putc(out, prefix);
+
+	for (i = 0; i < table->num_keys; i++) {
+		outbuf_putc(out, ' ');
+		snapshot_print_value(out, &table->fields[i], record, i,
+				     read_opt);
+	}
+}
+
+static void snapshot_print_record(struct outbuf *out,
+				  const struct snapshot_table *table,
+				  const struct snapshot_record *record,
+				  char prefix, int read_opt)
+{
+	const struct snapshot_field *field;
+	size_t i;
+
+	snapshot_print_key(out, table, record, prefix, read_opt);
+
+	for (i = table->num_keys; i < table->num_fields; i++) {
+		field = &table->fields[i];
+
+		if (!(record->present & BIT(i)))
+			continue;
+
+		outbuf_putc(out, ' ');
+		outbuf_str(out, field->name, 0);
+
+		if (field->type == SNAPSHOT_FLAG)
+			continue;
+
+		outbuf_putc(out, '=');
+		snapshot_print_value(out, field, record, i, read_opt);
+	}
+
+	outbuf_putc(out, '\n');
+}
+
+static bool snapshot_field_changed(const struct snapshot_field *field,
+				   const struct snapshot_record *record1,
+				   const struct snapshot_record *record2,
+				   size_t idx)
+{
+	uint32_t bit = BIT(idx);
+
+	if (field->flags & SNAPSHOT_F_TRANSIENT)
+		return false;
+
+	if ((record1->present & bit) != (record2->present & bit))
+		return true;
+
+	if (!(record1->present & bit))
+		return false;
+
+	if (field->type == SNAPSHOT_IFNAME)
+		return strcmp(record1->ifname, record2->ifname) != 0;
+
+	return record1->values[idx] != record2->values[idx];
+}
+
+/* returns false when the rows have the same (non transient) content */
+static bool snapshot_print_changed(struct outbuf *out,
+				   const struct snapshot_table *table,
+				   const struct snapshot_record *record1,
+				   const struct snapshot_record *record2,
+				   int read_opt)
+{
+	const struct snapshot_field *field;
+	bool changed = false;
+	size_t i;
+
+	for (i = table->num_keys; i < table->num_fields; i++) {
+		field = &table->fields[i];
+
+		if (!snapshot_field_changed(field, record1, record2, i))
+			continue;
+
+		if (!changed)
+			snapshot_print_key(out, table, record2, '*', read_opt);
+
+		changed = true;
+
+		outbuf_putc(out, ' ');
+		outbuf_str(out, field->name, 0);
+		outbuf_putc(out, ' ');
+		snapshot_print_value(out, field, record1, i, read_opt);
+		outbuf_str(out, " -> ", 0);
+		snapshot_print_value(out, field, record2, i, read_opt);
+	}
+
+	if (changed)
+		outbuf_putc(out, '\n');
+
+	return changed;
+}
+
+/* both sections are sorted by their keys: walk them like a merge */
+static void snapshot_diff_table(struct outbuf *out, struct outbuf *rows,
+				const struct snapshot_table *table,
+				const struct snapshot_section *section1,
+				const struct snapshot_section *section2,
+				int read_opt)
+{
+	unsigned long added = 0, removed = 0, changed = 0;
+	const struct snapshot_record *record1;
+	const struct snapshot_record *record2;
+	size_t i = 0, j = 0;
+	int cmp;
+
+	rows->len = 0;
+
+	while (i < section1->num_records || j < section2->num_records) {
+		record1 = i < section1->num_records ? &section1->records[i] : NULL;
+		record2 = j < section2->num_records ? &section2->records[j] : NULL;
+
+		if (!record1)
+			cmp = 1;
+		else if (!record2)
+			cmp = -1;
+		else
+			cmp = snapshot_record_compare_keys(table, record1,
+							   record2);
+
+		if (cmp < 0) {
+			snapshot_print_record(rows, table, record1, '-',
+					      read_opt);
+			removed++;
+			i++;
+		} else if (cmp > 0) {
+			snapshot_print_record(rows, table, record2, '+',
+					      read_opt);
+			added++;
+			j++;
+		} else {
+			if (snapshot_print_changed(rows, table, record1,
+						   record2, read_opt))
+				changed++;
+			i++;
+			j++;
+		}
+	}
+
+	if (!added && !removed && !changed)
+		return;
+
+	outbuf_str(out, table->name, 0);
+	outbuf_str(out, ": ", 0);
+	outbuf_uint(out, added, 0);
+	outbuf_str(out, " added, ", 0);
+	outbuf_uint(out, removed, 0);
+	outbuf_str(out, " removed, ", 0);
+	outbuf_uint(out, changed, 0);
+	outbuf_str(out, " changed\n", 0);
+	outbuf_write(out, rows->data, rows->len);
+}
+
+static void snapshot_print_file(struct outbuf *out, const char *prefix,
+				const struct snapshot_file *file)
+{
+	char stamp[32];
+	struct tm tm;
+
+	if (!localtime_r(&file->timestamp, &tm) ||
+	    !strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &tm))
+		snprintf(stamp, sizeof(stamp), "?");
+
+	outbuf_str(out, prefix, 0);
+	outbuf_putc(out, ' ');
+	outbuf_str(out, file->path, 0);
+	outbuf_str(out, " (", 0);
+	outbuf_str(out, file->mesh_iface, 0);
+	outbuf_str(out, ", ", 0);
+	outbuf_str(out, stamp, 0);
+	outbuf_str(out, ")\n", 0);
+}
+
+static int snapshot_diff(const char *path1, const char *path2, int read_opt)
+{
+	struct snapshot_file *files;
+	struct outbuf rows;
+	struct outbuf out;
+	int ret = EXIT_FAILURE;
+	size_t i;
+
+	files = calloc(2, sizeof(*files));
+	if (!files) {
+		fprintf(stderr, "Error - out of memory\n");
+		return EXIT_FAILURE;
+	}
+
+	files[0].path = path1;
+	files[1].path = path2;
+
+	if (outbuf_init(&files[0].data, NULL) < 0 ||
+	    outbuf_init(&files[1].data, NULL) < 0 ||
+	    outbuf_init(&rows, NULL) < 0 ||
+	    outbuf_init(&out, stdout) < 0) {
+		fprintf(stderr, "Error - out of memory\n");
+		goto free_files;
+	}
+
+	if (snapshot_read(&files[0]) < 0 || snapshot_read(&files[1]) < 0)
+		goto free_out;
+
+	if (read_opt & USE_BAT_HOSTS)
+		bat_hosts_init(read_opt);
+
+	snapshot_print_file(&out, "---", &files[0]);
+	snapshot_print_file(&out, "+++", &files[1]);
+
+	for (i = 0; i < ARRAY_SIZE(snapshot_tables); i++) {
+		/* a table which could not be dumped is not an empty table */
+		if (files[0].available[i] != files[1].available[i]) {
+			outbuf_str(&out, snapshot_tables[i].name, 0);
+			outbuf_str(&out, ": only in ", 0);
+			outbuf_str(&out, files[0].available[i] ? path1 : path2, 0);
+			outbuf_putc(&out, '\n');
+			continue;
+		}
+
+		snapshot_diff_table(&out, &rows, &snapshot_tables[i],
+				    &files[0].sections[i],
+				    &files[1].sections[i], read_opt);
+	}
+
+	outbuf_flush(&out);
+	ret = EXIT_SUCCESS;
+
+free_out:
+	outbuf_free(&out);
+	outbuf_free(&rows);
+free_files:
+	snapshot_file_free(&files[0]);
+	snapshot_file_free(&files[1]);
+	free(files);
+
+	return ret;
+}
+
+static int snapshot(struct state *state, int argc, char **argv)
+{
+	int read_opt = USE_BAT_HOSTS;
+	const char *subcmd;
+	int optchar;
+
+	if (argc < 2) {
+		snapshot_usage();
+		return EXIT_FAILURE;
+	}
+
+	if (strcmp(argv[1], "-h") == 0) {
+		snapshot_usage();
+		return EXIT_SUCCESS;
+	}
+
+	subcmd = argv[1];
+	argc--;
+	argv++;
+
+	while ((optchar = getopt(argc, argv, "hn")) != -1) {
+		switch (optchar) {
+		case 'h':
+			snapshot_usage();
+			return EXIT_SUCCESS;
+		case 'n':
+			read_opt &= ~USE_BAT_HOSTS;
+			break;
+		default:
+			snapshot_usage();
+			return EXIT_FAILURE;
+		}
+	}
+
+	argc -= optind;
+	argv += optind;
+
+	if (strcmp(subcmd, "save") == 0 && argc == 1) {
+		check_root_or_die("batctl");
+		return snapshot_save(state, argv[0]);
+	}
+
+	if (strcmp(subcmd, "diff") == 0 && argc == 2)
+		return snapshot_diff(argv[0], argv[1], read_opt);
+
+	snapshot_usage();
+	return EXIT_FAILURE;
+}
+
+/* the mesh interface is only checked by "save", "diff" works offline */
+COMMAND(SUBCOMMAND_MIF, snapshot, "ss", 0, NULL,
+	"save|diff <files> \tsave the mesh state or compare two snapshots");
@@ -0,0 +1,599 @@
+// SPDX-License-Identifier: GPL-2.0
+/* Copyright (C) B.A.T.M.A.N. contributors:
+ *
+ * License-Filename: LICENSES/preferred/GPL-2.0
+ */
+
+#include <errno.h>
+#include <netlink/genl/genl.h>
+#include <netlink/attr.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include "tablediff.h"
+#include "batman_adv.h"
+#include "hash.h"
+#include "main.h"
+#include "netlink.h"
+#include "output.h"
+
+#define TABLE_DIFF_KEY_LEN 32
+
+struct table_diff_key {
+	uint8_t nl_cmd;
+	int attrs[4];
+};
+
+/* attributes identifying a row; everything else is the value of the row.
+ * the lists are terminated by BATADV_ATTR_UNSPEC
+ */
+static const struct table_diff_key table_diff_keys[] = {
+	{
+		.nl_cmd = BATADV_CMD_GET_ORIGINATORS,
+		.attrs = { BATADV_ATTR_ORIG_ADDRESS, BATADV_ATTR_NEIGH_ADDRESS,
+			   BATADV_ATTR_HARD_IFINDEX },
+	},
+	{
+		.nl_cmd = BATADV_CMD_GET_NEIGHBORS,
+		.attrs = { BATADV_ATTR_NEIGH_ADDRESS, BATADV_ATTR_HARD_IFINDEX },
+	},
+	{
+		.nl_cmd = BATADV_CMD_GET_GATEWAYS,
+		.attrs = { BATADV_ATTR_ORIG_ADDRESS },
+	},
+	{
+		.nl_cmd = BATADV_CMD_GET_TRANSTABLE_LOCAL,
+		.attrs = { BATADV_ATTR_TT_ADDRESS, BATADV_ATTR_TT_VID },
+	},
+	{
+		.nl_cmd = BATADV_CMD_GET_TRANSTABLE_GLOBAL,
+		.attrs = { BATADV_ATTR_TT_ADDRESS, BATADV_ATTR_TT_VID,
+			   BATADV_ATTR_ORIG_ADDRESS },
+	},
+	{
+		.nl_cmd = BATADV_CMD_GET_BLA_CLAIM,
+		.attrs = { BATADV_ATTR_BLA_ADDRESS, BATADV_ATTR_BLA_VID },
+	},
+	{
+		.nl_cmd = BATADV_CMD_GET_BLA_BACKBONE,
+		.attrs = { BATADV_ATTR_BLA_ADDRESS, BATADV_ATTR_BLA_VID },
+	},
+	{
+		.nl_cmd = BATADV_CMD_GET_DAT_CACHE,
+		.attrs = { BATADV_ATTR_DAT_CACHE_IP4ADDRESS,
+			   BATADV_ATTR_DAT_CACHE_VID },
+	},
+	{
+		.nl_cmd = BATADV_CMD_GET_MCAST_FLAGS,
+		.attrs = { BATADV_ATTR_ORIG_ADDRESS },
+	},
+};
+
+struct table_diff_row {
+	uint8_t key[TABLE_DIFF_KEY_LEN];
+	size_t key_len;
+	uint32_t value_hash;
+	size_t text_off;
+	size_t text_len;
+	size_t slot;
+	bool has_slot;
+	bool seen;
+	bool changed;
+	bool added;
+};
+
+struct table_diff_snapshot {
+	struct table_diff_row *rows;
+	size_t num_rows;
+	size_t max_rows;
+	char *buf;
+	size_t buf_len;
+	struct hashtable_t *hash;
+};
+
+struct table_diff {
+	const int *key_attrs;
+	bool changes_only;
+	bool drawn;
+
+	struct outbuf out;
+	size_t row_start;
+
+	struct table_diff_snapshot prev;
+	struct table_diff_snapshot cur;
+
+	/* screen lines below the header; true when a row is shown there */
+	bool *slot_used;
+	size_t num_slots;
+	size_t header_lines;
+	/* slots which fit into the terminal when the table was drawn */
+	size_t visible_slots;
+	char *header;
+};
+
+static int table_diff_compare(void *data1, void *data2)
+{
+	const struct table_diff_row *row1 = data1;
+	const struct table_diff_row *row2 = data2;
+
+	if (row1->key_len != row2->key_len)
+		return 0;
+
+	return (memcmp(row1->key, row2->key, row1->key_len) == 0 ? 1 : 0);
+}
+
+static int table_diff_choose(void *data, int32_t size)
+{
+	const struct table_diff_row *row = data;
+
+	return (hash_bytes(row->key, row->key_len) % size);
+}
+
+static void table_diff_snapshot_free(struct table_diff_snapshot *snapshot)
+{
+	if (snapshot->hash)
+		hash_delete(snapshot->hash, NULL);
+
+	free(snapshot->rows);
+	free(snapshot->buf);
+	memset(snapshot, 0, sizeof(*snapshot));
+}
+
+struct table_diff *table_diff_new(uint8_t nl_cmd, bool changes_only)
+{
+	struct table_diff *diff;
+	size_t i;
+
+	diff = calloc(1, sizeof(*diff));
+	if (!diff)
+		return NULL;
+
+	diff->changes_only = changes_only;
+
+	for (i = 0; i < ARRAY_SIZE(table_diff_keys); i++) {
+		if (table_diff_keys[i].nl_cmd != nl_cmd)
+			continue;
+
+		diff->key_attrs = table_diff_keys[i].attrs;
+		break;
+	}
+
+	return diff;
+}
+
+void table_diff_free(struct table_diff *diff)
+{
+	if (!diff)
+		return;
+
+	outbuf_free(&diff->out);
+	table_diff_snapshot_free(&diff->prev);
+	table_diff_snapshot_free(&diff->cur);
+	free(diff->slot_used);
+	free(diff->header);
+	free(diff);
+}
+
+/* returns the buffer the table callbacks have to print the rows to */
+struct outbuf *table_diff_begin(struct table_diff *diff)
+{
+	table_diff_snapshot_free(&diff->cur);
+	outbuf_free(&diff->out);
+
+	if (outbuf_init(&diff->out, NULL) < 0)
+		return NULL;
+
+	return &diff->out;
+}
+
+void table_diff_row_begin(struct table_diff *diff)
+{
+	diff->row_start = diff->out.len;
+}
+
+static void table_diff_row_key(struct table_diff *diff,
+			       struct table_diff_row *row,
+			       struct nlattr *attrs[])
+{
+	bool is_key[BATADV_ATTR_MAX + 1] = { false };
+	uint32_t hash = 0;
+	size_t len;
+	int attr;
+	int i;
+
+	row->key_len = 0;
+
+	for (i = 0; diff->key_attrs && diff->key_attrs[i]; i++) {
+		attr = diff->key_attrs[i];
+		is_key[attr] = true;
+
+		if (!attrs[attr])
+			continue;
+
+		len = nla_len(attrs[attr]);
+		if (row->key_len + len > sizeof(row->key))
+			len = sizeof(row->key) - row->key_len;
+
+		memcpy(&row->key[row->key_len], nla_data(attrs[attr]), len);
+		row->key_len += len;
+	}
+
+	/* the last seen timestamp changes with every dump */
+	is_key[BATADV_ATTR_LAST_SEEN_MSECS] = true;
+
+	for (i = 0; i < BATADV_ATTR_MAX + 1; i++) {
+		if (!attrs[i] || is_key[i])
+			continue;
+
+		hash = hash * 31 + i;
+		hash ^= hash_bytes(nla_data(attrs[i]), nla_len(attrs[i]));
+	}
+
+	row->value_hash = hash;
+
+	/* unknown table - the whole row is the key */
+	if (row->key_len == 0) {
+		memcpy(row->key, &hash, sizeof(hash));
+		row->key_len = sizeof(hash);
+	}
+}
+
+void table_diff_row_end(struct table_diff *diff, struct nl_msg *msg)
+{
+	struct nlattr *attrs[BATADV_ATTR_MAX + 1];
+	struct nlmsghdr *nlh = nlmsg_hdr(msg);
+	struct table_diff_snapshot *cur = &diff->cur;
+	struct table_diff_row *rows;
+	struct table_diff_row *row;
+	struct genlmsghdr *ghdr;
+	size_t row_end;
+	size_t max;
+
+	row_end = diff->out.len;
+
+	/* entry was filtered by the table callback */
+	if (row_end <= diff->row_start)
+		return;
+
+	if (!genlmsg_valid_hdr(nlh, 0))
+		return;
+
+	ghdr = nlmsg_data(nlh);
+
+	if (nla_parse(attrs, BATADV_ATTR_MAX, genlmsg_attrdata(ghdr, 0),
+		      genlmsg_len(ghdr), batadv_netlink_policy))
+		return;
+
+	if (cur->num_rows == cur->max_rows) {
+		max = cur->max_rows ? cur->max_rows * 2 : 128;
+		rows = realloc(cur->rows, max * sizeof(*rows));
+		if (!rows)
+			return;
+
+		cur->rows = rows;
+		cur->max_rows = max;
+	}
+
+	row = &cur->rows[cur->num_rows++];
+	memset(row, 0, sizeof(*row));
+	row->text_off = diff->row_start;
+	row->text_len = row_end - diff->row_start;
+
+	table_diff_row_key(diff, row, attrs);
+}
+
+static const char *table_diff_text(const struct table_diff_snapshot *snapshot,
+				   const struct table_diff_row *row, int *len)
+{
+	const char *text = &snapshot->buf[row->text_off];
+
+	*len = row->text_len;
+	while (*len > 0 && text[*len - 1] == '\n')
+		(*len)--;
+
+	return text;
+}
+
+static size_t table_diff_count_lines(const char *header)
+{
+	size_t lines = 0;
+
+	if (!header)
+		return 0;
+
+	for (; *header; header++) {
+		if (*header == '\n')
+			lines++;
+	}
+
+	return lines;
+}
+
+/* rows which fit into the terminal below the header, SIZE_MAX when the
+ * height of the terminal is unknown
+ */
+static size_t table_diff_visible_slots(size_t header_lines)
+{
+	struct winsize ws;
+
+	if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) < 0 || ws.ws_row == 0)
+		return SIZE_MAX;
+
+	if (ws.ws_row <= header_lines)
+		return 0;
+
+	return ws.ws_row - header_lines;
+}
+
+static bool table_diff_row_changed(struct table_diff *diff,
+				   const struct table_diff_row *row,
+				   const struct table_diff_row *old)
+{
+	const char *text, *old_text;
+	int len, old_len;
+
+	if (diff->changes_only)
+		return row->value_hash != old->value_hash;
+
+	text = table_diff_text(&diff->cur, row, &len);
+	old_text = table_diff_text(&diff->prev, old, &old_len);
+
+	return len != old_len || memcmp(text, old_text, len) != 0;
+}
+
+static void table_diff_print_row(struct table_diff *diff,
+				 const struct table_diff_snapshot *snapshot,
+				 const struct table_diff_row *row,
+				 const char *prefix)
+{
+	const char *text;
+	int len;
+
+	text = table_diff_text(snapshot, row, &len);
+
+	if (diff->changes_only)
+		printf("%s%.*s\n", prefix, len, text);
+	else
+		printf("\033[%zu;1H%.*s\033[K", diff->header_lines + row->slot + 1,
+		       len, text);
+}
+
+static void table_diff_clear_slot(struct table_diff *diff, size_t slot)
+{
+	printf("\033[%zu;1H\033[K", diff->header_lines + slot + 1);
+}
+
+static void table_diff_redraw(struct table_diff *diff, const char *header)
+{
+	struct table_diff_row *row;
+	size_t i;
+
+	if (!diff->changes_only)
+		printf("\033[2J\033[H");
+
+	if (header)
+		fputs(header, stdout);
+
+	for (i = 0; i < diff->cur.num_rows; i++) {
+		row = &diff->cur.rows[i];
+		row->slot = i;
+		diff->slot_used[i] = true;
+
+		/* no newline behind the rows, the last line of the terminal
+		 * must not scroll the table
+		 */
+		table_diff_print_row(diff, &diff->cur, row, "+ ");
+	}
+
+	diff->num_slots = diff->cur.num_rows;
+}
+
+/* the table is taller than the terminal, so the rows can't be updated at
+ * their position. Print all of them like the plain watch mode does
+ */
+static void table_diff_print_all(struct table_diff *diff, const char *header)
+{
+	const char *text;
+	size_t i;
+	int len;
+
+	printf("\033[2J\033[H");
+
+	if (header)
+		fputs(header, stdout);
+
+	for (i = 0; i < diff->cur.num_rows; i++) {
+		text = table_diff_text(&diff->cur, &diff->cur.rows[i], &len);
+		printf("%.*s\n", len, text);
+	}
+}
+
+/* find the previous row of every row and give the new rows a slot */
+static void table_diff_match(struct table_diff *diff)
+{
+	struct table_diff_row *old;
+	struct table_diff_row *row;
+	size_t free_slot = 0;
+	size_t i;
+
+	for (i = 0; i < diff->cur.num_rows; i++) {
+		row = &diff->cur.rows[i];
+
+		old = hash_find(diff->prev.hash, row);
+		if (!old || old->seen)
+			continue;
+
+		old->seen = true;
+		row->slot = old->slot;
+		row->has_slot = true;
+		row->changed = table_diff_row_changed(diff, row, old);
+	}
+
+	for (i = 0; i < diff->prev.num_rows; i++) {
+		old = &diff->prev.rows[i];
+		if (!old->seen)
+			diff->slot_used[old->slot] = false;
+	}
+
+	/* new rows fill the holes left by removed rows first */
+	for (i = 0; i < diff->cur.num_rows; i++) {
+		row = &diff->cur.rows[i];
+		if (row->has_slot)
+			continue;
+
+		while (free_slot < diff->num_slots && diff->slot_used[free_slot])
+			free_slot++;
+
+		row->slot = free_slot;
+		row->added = true;
+		diff->slot_used[free_slot] = true;
+		if (free_slot == diff->num_slots)
+			diff->num_slots++;
+	}
+
+	while (diff->num_slots > 0 && !diff->slot_used[diff->num_slots - 1])
+		diff->num_slots--;
+}
+
+/* print the rows found by table_diff_match(). All slots are visible */
+static void table_diff_update(struct table_diff *diff, const char *header)
+{
+	struct table_diff_row *old;
+	struct table_diff_row *row;
+	size_t i;
+
+	/* header changes are rare - just rewrite it at the top */
+	if (!diff->changes_only && header && diff->header &&
+	    strcmp(header, diff->header) != 0)
+		printf("\033[H%s", header);
+
+	for (i = 0; i < diff->cur.num_rows; i++) {
+		row = &diff->cur.rows[i];
+		if (row->changed)
+			table_diff_print_row(diff, &diff->cur, row, "* ");
+	}
+
+	for (i = 0; i < diff->prev.num_rows; i++) {
+		old = &diff->prev.rows[i];
+		if (old->seen)
+			continue;
+
+		if (diff->changes_only)
+			table_diff_print_row(diff, &diff->prev, old, "- ");
+		else
+			table_diff_clear_slot(diff, old->slot);
+	}
+
+	for (i = 0; i < diff->cur.num_rows; i++) {
+		row = &diff->cur.rows[i];
+		if (row->added)
+			table_diff_print_row(diff, &diff->cur, row, "+ ");
+	}
+
+	/* the line below the table is outside of a full terminal */
+	if (!diff->changes_only && diff->num_slots < diff->visible_slots)
+		printf("\033[%zu;1H\033[J", diff->header_lines + diff->num_slots + 1);
+}
+
+/* compare the collected rows with the previous dump and print the changes */
+int table_diff_end(struct table_diff *diff, const char *header, bool valid)
+{
+	struct table_diff_row *row;
+	size_t visible_slots;
+	size_t header_lines;
+	size_t num_slots;
+	bool *slot_used;
+	bool redraw;
+	size_t i;
+	int ret = 0;
+
+	diff->cur.buf = diff->out.data;
+	diff->cur.buf_len = diff->out.len;
+	if (diff->out.error)
+		valid = false;
+
+	diff->out.data = NULL;
+	outbuf_free(&diff->out);
+
+	if (!valid) {
+		table_diff_snapshot_free(&diff->cur);
+		return 0;
+	}
+
+	diff->cur.hash = hash_new(diff->cur.num_rows * 2 + 1,
+				  table_diff_compare, table_diff_choose);
+	if (!diff->cur.hash) {
+		ret = -ENOMEM;
+		goto err;
+	}
+
+	for (i = 0; i < diff->cur.num_rows; i++) {
+		row = &diff->cur.rows[i];
+		hash_add(diff->cur.hash, row);
+	}
+
+	num_slots = diff->num_slots + diff->cur.num_rows + 1;
+	slot_used = realloc(diff->slot_used, num_slots * sizeof(*slot_used));
+	if (!slot_used) {
+		ret = -ENOMEM;
+		goto err;
+	}
+
+	diff->slot_used = slot_used;
+	memset(&diff->slot_used[diff->num_slots], 0,
+	       (diff->cur.num_rows + 1) * sizeof(*slot_used));
+
+	header_lines = table_diff_count_lines(header);
+	visible_slots = SIZE_MAX;
+	if (!diff->changes_only)
+		visible_slots = table_diff_visible_slots(header_lines);
+
+	/* cursor positions are only valid with a stable header height and
+	 * terminal size and only for the rows on the screen
+	 */
+	redraw = !diff->drawn ||
+		 (!diff->changes_only &&
+		  (header_lines != diff->header_lines ||
+		   visible_slots != diff->visible_slots));
+
+	if (!redraw) {
+		table_diff_match(diff);
+		redraw = diff->num_slots > visible_slots;
+	}
+
+	diff->header_lines = header_lines;
+	diff->visible_slots = visible_slots;
+
+	if (diff->cur.num_rows > visible_slots) {
+		table_diff_print_all(diff, header);
+		/* the next table which fits starts on a clean screen */
+		diff->drawn = false;
+		diff->num_slots = 0;
+	} else if (redraw) {
+		memset(diff->slot_used, 0, num_slots * sizeof(*slot_used));
+		table_diff_redraw(diff, header);
+		diff->drawn = true;
+	} else {
+		table_diff_update(diff, header);
+	}
+
+	fflush(stdout);
+
+	free(diff->header);
+	diff->header = header ? strdup(header) : NULL;
+
+	table_diff_snapshot_free(&diff->prev);
+	diff->prev = diff->cur;
+	memset(&diff->cur, 0, sizeof(diff->cur));
+
+	return 0;
+
+err:
+	table_diff_snapshot_free(&diff->cur);
+	return ret;
+}
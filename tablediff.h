@@ -0,0 +1,25 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/* Copyright (C) B.A.T.M.A.N. contributors:
+ *
+ * License-Filename: LICENSES/preferred/GPL-2.0
+ */
+
+#ifndef _BATCTL_TABLEDIFF_H
+#define _BATCTL_TABLEDIFF_H
+
+#include <netlink/msg.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+struct outbuf;
+struct table_diff;
+
+struct table_diff *table_diff_new(uint8_t nl_cmd, bool changes_only);
+void table_diff_free(struct table_diff *diff);
+
+struct outbuf *table_diff_begin(struct table_diff *diff);
+void table_diff_row_begin(struct table_diff *diff);
+void table_diff_row_end(struct table_diff *diff, struct nl_msg *msg);
+int table_diff_end(struct table_diff *diff, const char *header, bool valid);
+
+#endif /* _BATCTL_TABLEDIFF_H */
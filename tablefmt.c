@@ -0,0 +1,287 @@
+// SPDX-License-Identifier: GPL-2.0
+/* Copyright (C) B.A.T.M.A.N. contributors:
+ *
+ * License-Filename: LICENSES/preferred/GPL-2.0
+ */
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <netlink/attr.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tablefmt.h"
+#include "bat-hosts.h"
+#include "batadv_packet.h"
+#include "batman_adv.h"
+#include "functions.h"
+#include "main.h"
+#include "netlink.h"
+#include "output.h"
+
+static char table_format_separator(const struct table_format *format)
+{
+	return format->output == TABLE_OUTPUT_TSV ? '\t' : ',';
+}
+
+static int table_format_find(const struct table_format *format,
+			     const char *name)
+{
+	size_t i;
+
+	for (i = 0; i < format->num_columns; i++) {
+		if (strcmp(format->columns[i].name, name) == 0)
+			return i;
+	}
+
+	return -ENOENT;
+}
+
+static void table_format_list_columns(const struct table_format *format)
+{
+	size_t i;
+
+	fprintf(stderr, "Available columns:");
+	for (i = 0; i < format->num_columns; i++)
+		fprintf(stderr, " %s", format->columns[i].name);
+
+	fprintf(stderr, "\n");
+}
+
+/* select the comma separated columns in selection; NULL selects all */
+int table_format_init(struct table_format *format, enum table_output output,
+		      const struct table_column *columns, size_t num_columns,
+		      const char *selection)
+{
+	char *saveptr;
+	char *list;
+	char *name;
+	int column;
+
+	memset(format, 0, sizeof(*format));
+	format->output = output;
+	format->columns = columns;
+	format->num_columns = num_columns;
+
+	if (!selection) {
+		for (column = 0; column < (int)num_columns; column++) {
+			if (format->num_selected == TABLE_FORMAT_MAX_COLUMNS)
+				break;
+
+			format->selected[format->num_selected++] = column;
+		}
+
+		return 0;
+	}
+
+	list = strdup(selection);
+	if (!list)
+		return -ENOMEM;
+
+	for (name = strtok_r(list, ",", &saveptr); name;
+	     name = strtok_r(NULL, ",", &saveptr)) {
+		column = table_format_find(format, name);
+		if (column < 0) {
+			fprintf(stderr, "Error - unknown column '%s'\n", name);
+			table_format_list_columns(format);
+			free(list);
+			return -EINVAL;
+		}
+
+		if (format->num_selected == TABLE_FORMAT_MAX_COLUMNS) {
+			fprintf(stderr, "Error - too many columns selected\n");
+			free(list);
+			return -EINVAL;
+		}
+
+		format->selected[format->num_selected++] = column;
+	}
+
+	free(list);
+
+	if (format->num_selected == 0) {
+		fprintf(stderr, "Error - no column selected\n");
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+char *table_format_header(const struct table_format *format)
+{
+	const char *name;
+	size_t len = 1;
+	char *header;
+	char *pos;
+	size_t i;
+
+	for (i = 0; i < format->num_selected; i++)
+		len += strlen(format->columns[format->selected[i]].name) + 1;
+
+	header = malloc(len);
+	if (!header)
+		return NULL;
+
+	pos = header;
+	for (i = 0; i < format->num_selected; i++) {
+		if (i > 0)
+			*pos++ = table_format_separator(format);
+
+		name = format->columns[format->selected[i]].name;
+		memcpy(pos, name, strlen(name));
+		pos += strlen(name);
+	}
+
+	*pos++ = '\n';
+	*pos = '\0';
+
+	return header;
+}
+
+/* print only the selected columns of an entry */
+void table_format_row(struct print_opts *opts, struct nlattr *attrs[])
+{
+	const struct table_format *format = opts->table.format;
+	const struct table_column *column;
+	size_t i;
+
+	for (i = 0; i < format->num_selected; i++) {
+		if (i > 0)
+			outbuf_putc(opts->out, table_format_separator(format));
+
+		column = &format->columns[format->selected[i]];
+		column->print(opts, attrs, column->attr);
+	}
+
+	outbuf_putc(opts->out, '\n');
+}
+
+/* quote (CSV) or replace (TSV) the characters which would break the row */
+static void table_format_str(struct print_opts *opts, const char *str)
+{
+	struct outbuf *out = opts->out;
+
+	if (opts->table.format->output == TABLE_OUTPUT_TSV) {
+		if (!strpbrk(str, "\t\r\n")) {
+			outbuf_str(out, str, 0);
+			return;
+		}
+
+		for (; *str; str++) {
+			if (*str == '\t' || *str == '\r' || *str == '\n')
+				outbuf_putc(out, ' ');
+			else
+				outbuf_putc(out, *str);
+		}
+
+		return;
+	}
+
+	if (!strpbrk(str, ",\"\r\n")) {
+		outbuf_str(out, str, 0);
+		return;
+	}
+
+	outbuf_putc(out, '"');
+	for (; *str; str++) {
+		if (*str == '"')
+			outbuf_putc(out, '"');
+
+		outbuf_putc(out, *str);
+	}
+	outbuf_putc(out, '"');
+}
+
+void table_column_flag(struct print_opts *opts, struct nlattr *attrs[],
+		       int attr)
+{
+	outbuf_putc(opts->out, attrs[attr] ? '1' : '0');
+}
+
+void table_column_u8(struct print_opts *opts, struct nlattr *attrs[],
+		     int attr)
+{
+	if (attrs[attr])
+		outbuf_uint(opts->out, nla_get_u8(attrs[attr]), 0);
+}
+
+void table_column_u16(struct print_opts *opts, struct nlattr *attrs[],
+		      int attr)
+{
+	if (attrs[attr])
+		outbuf_uint(opts->out, nla_get_u16(attrs[attr]), 0);
+}
+
+void table_column_u32(struct print_opts *opts, struct nlattr *attrs[],
+		      int attr)
+{
+	if (attrs[attr])
+		outbuf_uint(opts->out, nla_get_u32(attrs[attr]), 0);
+}
+
+void table_column_vid(struct print_opts *opts, struct nlattr *attrs[],
+		      int attr)
+{
+	uint16_t vid;
+
+	if (!attrs[attr])
+		return;
+
+	vid = nla_get_u16(attrs[attr]);
+	outbuf_int(opts->out, BATADV_PRINT_VID(vid), 0);
+}
+
+void table_column_mac(struct print_opts *opts, struct nlattr *attrs[],
+		      int attr)
+{
+	struct bat_host *bat_host = NULL;
+	uint8_t *addr;
+
+	if (!attrs[attr])
+		return;
+
+	addr = nla_data(attrs[attr]);
+
+	if (opts->read_opt & USE_BAT_HOSTS)
+		bat_host = bat_hosts_find_by_mac((char *)addr);
+
+	if (bat_host)
+		table_format_str(opts, bat_host->name);
+	else
+		outbuf_mac(opts->out, addr);
+}
+
+/* name of the hard interface, resolved from its index for older kernels */
+void table_column_ifname(struct print_opts *opts, struct nlattr *attrs[],
+			 int attr)
+{
+	char ifname_buf[IF_NAMESIZE];
+	uint32_t ifindex;
+
+	if (attrs[attr]) {
+		table_format_str(opts, nla_get_string(attrs[attr]));
+		return;
+	}
+
+	if (!attrs[BATADV_ATTR_HARD_IFINDEX])
+		return;
+
+	ifindex = nla_get_u32(attrs[BATADV_ATTR_HARD_IFINDEX]);
+	if (if_indextoname(ifindex, ifname_buf))
+		table_format_str(opts, ifname_buf);
+}
+
+void table_column_ipv4(struct print_opts *opts, struct nlattr *attrs[],
+		       int attr)
+{
+	struct in_addr in_addr;
+
+	if (!attrs[attr])
+		return;
+
+	in_addr.s_addr = nla_get_u32(attrs[attr]);
+	outbuf_str(opts->out, inet_ntoa(in_addr), 0);
+}
@@ -0,0 +1,60 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/* Copyright (C) B.A.T.M.A.N. contributors:
+ *
+ * License-Filename: LICENSES/preferred/GPL-2.0
+ */
+
+#ifndef _BATCTL_TABLEFMT_H
+#define _BATCTL_TABLEFMT_H
+
+#include <stddef.h>
+
+#define TABLE_FORMAT_MAX_COLUMNS 16
+
+struct nlattr;
+struct print_opts;
+
+/* column of a debug table in the CSV/TSV output, filled from attribute attr */
+struct table_column {
+	const char *name;
+	int attr;
+	void (*print)(struct print_opts *opts, struct nlattr *attrs[], int attr);
+};
+
+enum table_output {
+	TABLE_OUTPUT_CSV,
+	TABLE_OUTPUT_TSV,
+};
+
+struct table_format {
+	enum table_output output;
+	const struct table_column *columns;
+	size_t num_columns;
+	size_t selected[TABLE_FORMAT_MAX_COLUMNS];
+	size_t num_selected;
+};
+
+int table_format_init(struct table_format *format, enum table_output output,
+		      const struct table_column *columns, size_t num_columns,
+		      const char *selection);
+char *table_format_header(const struct table_format *format);
+void table_format_row(struct print_opts *opts, struct nlattr *attrs[]);
+
+void table_column_flag(struct print_opts *opts, struct nlattr *attrs[],
+		       int attr);
+void table_column_u8(struct print_opts *opts, struct nlattr *attrs[],
+		     int attr);
+void table_column_u16(struct print_opts *opts, struct nlattr *attrs[],
+		      int attr);
+void table_column_u32(struct print_opts *opts, struct nlattr *attrs[],
+		      int attr);
+void table_column_vid(struct print_opts *opts, struct nlattr *attrs[],
+		      int attr);
+void table_column_mac(struct print_opts *opts, struct nlattr *attrs[],
+		      int attr);
+void table_column_ifname(struct print_opts *opts, struct nlattr *attrs[],
+			 int attr);
+void table_column_ipv4(struct print_opts *opts, struct nlattr *attrs[],
+		       int attr);
+
+#endif /* _BATCTL_TABLEFMT_H */
@@ -0,0 +1,358 @@
+// SPDX-License-Identifier: GPL-2.0
+/* Copyright (C) B.A.T.M.A.N. contributors:
+ *
+ * License-Filename: LICENSES/preferred/GPL-2.0
+ */
+
+#include <errno.h>
+#include <net/ethernet.h>
+#include <netlink/attr.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tablegroup.h"
+#include "batadv_packet.h"
+#include "bat-hosts.h"
+#include "functions.h"
+#include "macmap.h"
+#include "main.h"
+#include "netlink.h"
+#include "output.h"
+
+#define TABLE_GROUP_MAX_FLAGS 8
+#define TABLE_GROUP_COUNT_WIDTH 8
+
+struct table_group_entry {
+	uint64_t key;
+	unsigned long count;
+	unsigned long flags[TABLE_GROUP_MAX_FLAGS];
+};
+
+struct table_group {
+	const struct table_group_key *key;
+	const struct table_group_flag *flags;
+	size_t num_flags;
+	/* the entries are kept for the next dump, groups which didn't get a
+	 * row are removed when the table is printed
+	 */
+	struct macmap entries;
+	/* consecutive rows often belong to the same group */
+	struct table_group_entry *last;
+	/* reused for sorting the entries of every dump */
+	struct table_group_entry **sorted;
+	size_t max_sorted;
+};
+
+const struct table_group_key *
+table_group_find_key(const struct table_group_key *keys, size_t num_keys,
+		     const char *name)
+{
+	size_t i;
+
+	for (i = 0; i < num_keys; i++) {
+		if (strcmp(keys[i].name, name) == 0)
+			return &keys[i];
+	}
+
+	fprintf(stderr, "Error - unknown group key '%s'\n", name);
+	fprintf(stderr, "Available group keys:");
+	for (i = 0; i < num_keys; i++)
+		fprintf(stderr, " %s", keys[i].name);
+
+	fprintf(stderr, "\n");
+
+	return NULL;
+}
+
+struct table_group *table_group_new(const struct table_group_key *key,
+				    const struct table_group_flag *flags,
+				    size_t num_flags)
+{
+	struct table_group *group;
+
+	if (num_flags > TABLE_GROUP_MAX_FLAGS)
+		num_flags = TABLE_GROUP_MAX_FLAGS;
+
+	group = calloc(1, sizeof(*group));
+	if (!group)
+		return NULL;
+
+	group->key = key;
+	group->flags = flags;
+	group->num_flags = num_flags;
+	if (macmap_init(&group->entries, 128) < 0) {
+		free(group);
+		return NULL;
+	}
+
+	return group;
+}
+
+void table_group_free(struct table_group *group)
+{
+	if (!group)
+		return;
+
+	macmap_destroy(&group->entries, free);
+	free(group->sorted);
+	free(group);
+}
+
+static int table_group_key_width(const struct table_group *group)
+{
+	int width = group->key->type == TABLE_GROUP_MAC ? 17 : 4;
+	int title_len = strlen(group->key->title);
+
+	return title_len > width ? title_len : width;
+}
+
+static int table_group_flag_width(const struct table_group_flag *flag)
+{
+	int width = strlen(flag->name);
+
+	return width > 5 ? width : 5;
+}
+
+char *table_group_header(const struct table_group *group)
+{
+	char *header;
+	size_t size;
+	size_t len;
+	size_t i;
+
+	size = table_group_key_width(group) + TABLE_GROUP_COUNT_WIDTH + 3;
+	for (i = 0; i < group->num_flags; i++)
+		size += table_group_flag_width(&group->flags[i]) + 1;
+
+	header = malloc(size);
+	if (!header)
+		return NULL;
+
+	/* addresses are left aligned, numbers right aligned */
+	if (group->key->type == TABLE_GROUP_MAC)
+		len = snprintf(header, size, "%-*s %*s",
+			       table_group_key_width(group), group->key->title,
+			       TABLE_GROUP_COUNT_WIDTH, "count");
+	else
+		len = snprintf(header, size, "%*s %*s",
+			       table_group_key_width(group), group->key->title,
+			       TABLE_GROUP_COUNT_WIDTH, "count");
+
+	for (i = 0; i < group->num_flags; i++)
+		len += snprintf(header + len, size - len, " %*s",
+				table_group_flag_width(&group->flags[i]),
+				group->flags[i].name);
+
+	snprintf(header + len, size - len, "\n");
+
+	return header;
+}
+
+static uint64_t table_group_key_value(const struct table_group *group,
+				      struct nlattr *attrs[])
+{
+	struct nlattr *attr = attrs[group->key->attr];
+	uint64_t key = 0;
+	uint8_t *mac;
+	int i;
+
+	if (!attr)
+		return 0;
+
+	switch (group->key->type) {
+	case TABLE_GROUP_MAC:
+		mac = nla_data(attr);
+		for (i = 0; i < ETH_ALEN; i++)
+			key = (key << 8) | mac[i];
+		break;
+	case TABLE_GROUP_VID:
+		/* untagged (-1) sorts in front of the tagged vids */
+		key = BATADV_PRINT_VID(nla_get_u16(attr)) + 1;
+		break;
+	}
+
+	return key;
+}
+
+static struct table_group_entry *table_group_get(struct table_group *group,
+						 uint64_t key)
+{
+	struct table_group_entry *entry;
+
+	if (group->last && group->last->key == key)
+		return group->last;
+
+	entry = macmap_find(&group->entries, key);
+	if (entry)
+		goto out;
+
+	entry = calloc(1, sizeof(*entry));
+	if (!entry)
+		return NULL;
+
+	entry->key = key;
+
+	if (macmap_add(&group->entries, key, entry) < 0) {
+		free(entry);
+		return NULL;
+	}
+
+out:
+	group->last = entry;
+	return entry;
+}
+
+/* rows are only counted, the table itself is never formatted */
+void table_group_add(struct table_group *group, struct nlattr *attrs[])
+{
+	const struct table_group_flag *flag;
+	struct table_group_entry *entry;
+	struct nlattr *attr;
+	size_t i;
+
+	entry = table_group_get(group, table_group_key_value(group, attrs));
+	if (!entry) {
+		last_err = -ENOMEM;
+		return;
+	}
+
+	entry->count++;
+
+	for (i = 0; i < group->num_flags; i++) {
+		flag = &group->flags[i];
+
+		attr = attrs[flag->attr];
+		if (!attr)
+			continue;
+
+		if (flag->mask && !(nla_get_u32(attr) & flag->mask))
+			continue;
+
+		entry->flags[i]++;
+	}
+}
+
+static int table_group_entry_compare(const void *data1, const void *data2)
+{
+	const struct table_group_entry *entry1 = *(void * const *)data1;
+	const struct table_group_entry *entry2 = *(void * const *)data2;
+
+	if (entry1->key < entry2->key)
+		return -1;
+
+	if (entry1->key > entry2->key)
+		return 1;
+
+	return 0;
+}
+
+static void table_group_print_mac(struct print_opts *opts, const uint8_t *mac)
+{
+	struct bat_host *bat_host;
+
+	if (!(opts->read_opt & USE_BAT_HOSTS)) {
+		outbuf_mac(opts->out, mac);
+		return;
+	}
+
+	bat_host = bat_hosts_find_by_mac((char *)mac);
+	if (!bat_host)
+		outbuf_mac(opts->out, mac);
+	else
+		outbuf_str(opts->out, bat_host->name, 17);
+}
+
+static void table_group_print(struct print_opts *opts,
+			      const struct table_group *group,
+			      const struct table_group_entry *entry)
+{
+	uint8_t mac[ETH_ALEN];
+	int width;
+	size_t i;
+
+	width = table_group_key_width(group);
+
+	switch (group->key->type) {
+	case TABLE_GROUP_MAC:
+		for (i = 0; i < ETH_ALEN; i++)
+			mac[i] = entry->key >> (8 * (ETH_ALEN - 1 - i));
+
+		table_group_print_mac(opts, mac);
+		outbuf_str(opts->out, "", width - 17);
+		break;
+	case TABLE_GROUP_VID:
+		outbuf_int(opts->out, (long)entry->key - 1, width);
+		break;
+	}
+
+	outbuf_putc(opts->out, ' ');
+	outbuf_uint(opts->out, entry->count, TABLE_GROUP_COUNT_WIDTH);
+
+	for (i = 0; i < group->num_flags; i++) {
+		outbuf_putc(opts->out, ' ');
+		outbuf_uint(opts->out, entry->flags[i],
+			    table_group_flag_width(&group->flags[i]));
+	}
+
+	outbuf_putc(opts->out, '\n');
+}
+
+/* print one line per group, ordered by key, and start over for the next
+ * dump
+ */
+void table_group_flush(struct print_opts *opts)
+{
+	struct table_group *group = opts->table.group;
+	struct table_group_entry **sorted;
+	struct table_group_entry *entry;
+	size_t num_entries = 0;
+	size_t num_stale;
+	uint32_t iter = 0;
+	size_t i;
+
+	netlink_print_remaining_header(opts);
+	group->last = NULL;
+
+	if (group->entries.elements == 0)
+		return;
+
+	if (group->entries.elements > group->max_sorted) {
+		sorted = realloc(group->sorted,
+				 group->entries.elements * sizeof(*sorted));
+		if (!sorted) {
+			last_err = -ENOMEM;
+			return;
+		}
+
+		group->sorted = sorted;
+		group->max_sorted = group->entries.elements;
+	}
+
+	/* groups without rows in this dump are collected at the end */
+	num_stale = 0;
+	while ((entry = macmap_iterate(&group->entries, &iter))) {
+		if (entry->count)
+			group->sorted[num_entries++] = entry;
+		else
+			group->sorted[group->max_sorted - ++num_stale] = entry;
+	}
+
+	for (i = 0; i < num_stale; i++) {
+		entry = group->sorted[group->max_sorted - 1 - i];
+		macmap_remove(&group->entries, entry->key);
+		free(entry);
+	}
+
+	qsort(group->sorted, num_entries, sizeof(*group->sorted),
+	      table_group_entry_compare);
+
+	for (i = 0; i < num_entries; i++) {
+		entry = group->sorted[i];
+		table_group_print(opts, group, entry);
+
+		entry->count = 0;
+		memset(entry->flags, 0, sizeof(entry->flags));
+	}
+}
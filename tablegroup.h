@@ -0,0 +1,51 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/* Copyright (C) B.A.T.M.A.N. contributors:
+ *
+ * License-Filename: LICENSES/preferred/GPL-2.0
+ */
+
+#ifndef _BATCTL_TABLEGROUP_H
+#define _BATCTL_TABLEGROUP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct nlattr;
+struct print_opts;
+struct table_group;
+
+enum table_group_type {
+	TABLE_GROUP_MAC,
+	TABLE_GROUP_VID,
+};
+
+/* rows of a debug table are aggregated by the value of attribute attr */
+struct table_group_key {
+	const char *name;
+	const char *title;
+	int attr;
+	enum table_group_type type;
+};
+
+/* counted per group when attr is present and (without a zero mask) one of
+ * the bits in mask is set
+ */
+struct table_group_flag {
+	const char *name;
+	int attr;
+	uint32_t mask;
+};
+
+const struct table_group_key *
+table_group_find_key(const struct table_group_key *keys, size_t num_keys,
+		     const char *name);
+struct table_group *table_group_new(const struct table_group_key *key,
+				    const struct table_group_flag *flags,
+				    size_t num_flags);
+void table_group_free(struct table_group *group);
+
+char *table_group_header(const struct table_group *group);
+void table_group_add(struct table_group *group, struct nlattr *attrs[]);
+void table_group_flush(struct print_opts *opts);
+
+#endif /* _BATCTL_TABLEGROUP_H */
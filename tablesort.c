@@ -0,0 +1,266 @@
+// SPDX-License-Identifier: GPL-2.0
+/* Copyright (C) B.A.T.M.A.N. contributors:
+ *
+ * License-Filename: LICENSES/preferred/GPL-2.0
+ */
+
+#include <errno.h>
+#include <net/ethernet.h>
+#include <netlink/attr.h>
+#include <netlink/msg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tablesort.h"
+#include "main.h"
+#include "netlink.h"
+
+struct table_sort_row {
+	/* larger ranks are printed first */
+	uint64_t rank;
+	unsigned long seq;
+	struct nl_msg *msg;
+};
+
+/* with a limit, rows is a min-heap of the best rows seen so far: the root is
+ * the row which is dropped first. without a limit, all rows are kept
+ */
+struct table_sort {
+	const struct table_sort_key *key;
+	bool reverse;
+	size_t limit;
+	struct table_sort_row *rows;
+	size_t num_rows;
+	size_t max_rows;
+	unsigned long seq;
+};
+
+const struct table_sort_key *
+table_sort_find_key(const struct table_sort_key *keys, size_t num_keys,
+		    const char *name)
+{
+	size_t i;
+
+	for (i = 0; i < num_keys; i++) {
+		if (strcmp(keys[i].name, name) == 0)
+			return &keys[i];
+	}
+
+	fprintf(stderr, "Error - unknown sort key '%s'\n", name);
+	fprintf(stderr, "Available sort keys:");
+	for (i = 0; i < num_keys; i++)
+		fprintf(stderr, " %s", keys[i].name);
+
+	fprintf(stderr, "\n");
+
+	return NULL;
+}
+
+struct table_sort *table_sort_new(const struct table_sort_key *key,
+				  bool reverse, size_t limit)
+{
+	struct table_sort *sort;
+
+	sort = calloc(1, sizeof(*sort));
+	if (!sort)
+		return NULL;
+
+	sort->key = key;
+	sort->reverse = reverse;
+	sort->limit = limit;
+
+	return sort;
+}
+
+static void table_sort_clear(struct table_sort *sort)
+{
+	size_t i;
+
+	for (i = 0; i < sort->num_rows; i++)
+		nlmsg_free(sort->rows[i].msg);
+
+	sort->num_rows = 0;
+	sort->seq = 0;
+}
+
+void table_sort_free(struct table_sort *sort)
+{
+	if (!sort)
+		return;
+
+	table_sort_clear(sort);
+	free(sort->rows);
+	free(sort);
+}
+
+static uint64_t table_sort_rank(const struct table_sort *sort,
+				struct nlattr *attrs[])
+{
+	struct nlattr *attr = attrs[sort->key->attr];
+	uint64_t rank = 0;
+	uint8_t *mac;
+	int i;
+
+	/* rows without the attribute are treated as the smallest value */
+	if (attr) {
+		switch (sort->key->type) {
+		case TABLE_SORT_U8:
+			rank = nla_get_u8(attr);
+			break;
+		case TABLE_SORT_U16:
+			rank = nla_get_u16(attr);
+			break;
+		case TABLE_SORT_U32:
+			rank = nla_get_u32(attr);
+			break;
+		case TABLE_SORT_MAC:
+			mac = nla_data(attr);
+			for (i = 0; i < ETH_ALEN; i++)
+				rank = (rank << 8) | mac[i];
+			break;
+		}
+	}
+
+	if (sort->key->descending == sort->reverse)
+		rank = ~rank;
+
+	return rank;
+}
+
+static bool table_sort_better(const struct table_sort_row *row1,
+			      const struct table_sort_row *row2)
+{
+	if (row1->rank != row2->rank)
+		return row1->rank > row2->rank;
+
+	/* keep the kernel order for equal keys */
+	return row1->seq < row2->seq;
+}
+
+static void table_sort_sift_up(struct table_sort *sort, size_t pos)
+{
+	struct table_sort_row row = sort->rows[pos];
+	size_t parent;
+
+	while (pos > 0) {
+		parent = (pos - 1) / 2;
+		if (!table_sort_better(&sort->rows[parent], &row))
+			break;
+
+		sort->rows[pos] = sort->rows[parent];
+		pos = parent;
+	}
+
+	sort->rows[pos] = row;
+}
+
+static void table_sort_sift_down(struct table_sort *sort, size_t pos)
+{
+	struct table_sort_row row = sort->rows[pos];
+	size_t child;
+
+	while ((child = 2 * pos + 1) < sort->num_rows) {
+		if (child + 1 < sort->num_rows &&
+		    table_sort_better(&sort->rows[child], &sort->rows[child + 1]))
+			child++;
+
+		if (!table_sort_better(&row, &sort->rows[child]))
+			break;
+
+		sort->rows[pos] = sort->rows[child];
+		pos = child;
+	}
+
+	sort->rows[pos] = row;
+}
+
+static int table_sort_grow(struct table_sort *sort)
+{
+	struct table_sort_row *rows;
+	size_t max_rows;
+
+	max_rows = sort->max_rows ? sort->max_rows * 2 : 64;
+	if (sort->limit && max_rows > sort->limit)
+		max_rows = sort->limit;
+
+	rows = realloc(sort->rows, max_rows * sizeof(*rows));
+	if (!rows)
+		return -ENOMEM;
+
+	sort->rows = rows;
+	sort->max_rows = max_rows;
+
+	return 0;
+}
+
+/* keep a reference to msg when it belongs to the printed rows. the row is
+ * only formatted in table_sort_flush()
+ */
+void table_sort_add(struct table_sort *sort, struct nl_msg *msg,
+		    struct nlattr *attrs[])
+{
+	struct table_sort_row row = {
+		.rank = table_sort_rank(sort, attrs),
+		.seq = sort->seq++,
+		.msg = msg,
+	};
+
+	if (sort->limit && sort->num_rows == sort->limit) {
+		if (!table_sort_better(&row, &sort->rows[0]))
+			return;
+
+		nlmsg_free(sort->rows[0].msg);
+		nlmsg_get(msg);
+		sort->rows[0] = row;
+		table_sort_sift_down(sort, 0);
+		return;
+	}
+
+	if (sort->num_rows == sort->max_rows && table_sort_grow(sort) < 0) {
+		last_err = -ENOMEM;
+		return;
+	}
+
+	nlmsg_get(msg);
+	sort->rows[sort->num_rows] = row;
+
+	if (sort->limit)
+		table_sort_sift_up(sort, sort->num_rows++);
+	else
+		sort->num_rows++;
+}
+
+static int table_sort_compare(const void *data1, const void *data2)
+{
+	const struct table_sort_row *row1 = data1;
+	const struct table_sort_row *row2 = data2;
+
+	if (table_sort_better(row1, row2))
+		return -1;
+
+	if (table_sort_better(row2, row1))
+		return 1;
+
+	return 0;
+}
+
+/* print the collected rows in order and start over for the next dump */
+void table_sort_flush(struct print_opts *opts)
+{
+	struct table_sort *sort = opts->table.sort;
+	size_t i;
+
+	qsort(sort->rows, sort->num_rows, sizeof(*sort->rows),
+	      table_sort_compare);
+
+	/* the rows are printed directly when no sort is set */
+	opts->table.sort = NULL;
+	for (i = 0; i < sort->num_rows; i++)
+		netlink_print_common_cb(sort->rows[i].msg, opts);
+	opts->table.sort = sort;
+
+	table_sort_clear(sort);
+}
@@ -0,0 +1,46 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/* Copyright (C) B.A.T.M.A.N. contributors:
+ *
+ * License-Filename: LICENSES/preferred/GPL-2.0
+ */
+
+#ifndef _BATCTL_TABLESORT_H
+#define _BATCTL_TABLESORT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+struct nlattr;
+struct nl_msg;
+struct print_opts;
+struct table_sort;
+
+enum table_sort_type {
+	TABLE_SORT_U8,
+	TABLE_SORT_U16,
+	TABLE_SORT_U32,
+	TABLE_SORT_MAC,
+};
+
+/* sort key of a debug table, read from attribute attr. descending keys
+ * print the largest value first
+ */
+struct table_sort_key {
+	const char *name;
+	int attr;
+	enum table_sort_type type;
+	bool descending;
+};
+
+const struct table_sort_key *
+table_sort_find_key(const struct table_sort_key *keys, size_t num_keys,
+		    const char *name);
+struct table_sort *table_sort_new(const struct table_sort_key *key,
+				  bool reverse, size_t limit);
+void table_sort_free(struct table_sort *sort);
+
+void table_sort_add(struct table_sort *sort, struct nl_msg *msg,
+		    struct nlattr *attrs[]);
+void table_sort_flush(struct print_opts *opts);
+
+#endif /* _BATCTL_TABLESORT_H */
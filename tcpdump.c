@@ -1362,7 +1362,8 @@ static int tcpdump(struct state *state __maybe_unused, int argc, char **argv)
 
 	check_root_or_die("batctl tcpdump");
 
-	bat_hosts_init(read_opt);
+	if (read_opt & USE_BAT_HOSTS)
+		bat_hosts_init(read_opt);
 
 	signal(SIGINT, sig_handler);
 	signal(SIGTERM, sig_handler);
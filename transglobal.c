@@ -22,6 +22,10 @@
 #include "functions.h"
 #include "main.h"
 #include "netlink.h"
+#include "output.h"
+#include "tablefmt.h"
+#include "tablegroup.h"
+#include "tablesort.h"
 
 static const int transglobal_mandatory[] = {
 	BATADV_ATTR_TT_ADDRESS,
@@ -33,13 +37,53 @@ static const int transglobal_mandatory[] = {
 	BATADV_ATTR_TT_FLAGS,
 };
 
-static int transglobal_callback(struct nl_msg *msg, void *arg)
+static const struct table_column transglobal_columns[] = {
+	{ "best", BATADV_ATTR_FLAG_BEST, table_column_flag },
+	{ "tt_address", BATADV_ATTR_TT_ADDRESS, table_column_mac },
+	{ "tt_vid", BATADV_ATTR_TT_VID, table_column_vid },
+	{ "tt_flags", BATADV_ATTR_TT_FLAGS, table_column_u32 },
+	{ "tt_ttvn", BATADV_ATTR_TT_TTVN, table_column_u8 },
+	{ "orig_address", BATADV_ATTR_ORIG_ADDRESS, table_column_mac },
+	{ "tt_last_ttvn", BATADV_ATTR_TT_LAST_TTVN, table_column_u8 },
+	{ "tt_crc32", BATADV_ATTR_TT_CRC32, table_column_u32 },
+};
+
+static const struct table_sort_key transglobal_sort_keys[] = {
+	{ "address", BATADV_ATTR_TT_ADDRESS, TABLE_SORT_MAC, false },
+	{ "orig", BATADV_ATTR_ORIG_ADDRESS, TABLE_SORT_MAC, false },
+	{ "vid", BATADV_ATTR_TT_VID, TABLE_SORT_U16, false },
+};
+
+static const struct table_group_key transglobal_group_keys[] = {
+	{ "orig", "Originator", BATADV_ATTR_ORIG_ADDRESS, TABLE_GROUP_MAC },
+	{ "vid", "VID", BATADV_ATTR_TT_VID, TABLE_GROUP_VID },
+};
+
+static const struct table_group_flag transglobal_group_flags[] = {
+	{ "best", BATADV_ATTR_FLAG_BEST, 0 },
+	{ "roaming", BATADV_ATTR_TT_FLAGS, BATADV_TT_CLIENT_ROAM },
+	{ "wifi", BATADV_ATTR_TT_FLAGS, BATADV_TT_CLIENT_WIFI },
+	{ "isolated", BATADV_ATTR_TT_FLAGS, BATADV_TT_CLIENT_ISOLA },
+	{ "temp", BATADV_ATTR_TT_FLAGS, BATADV_TT_CLIENT_TEMP },
+};
+
+static bool transglobal_match(struct nlattr *attrs[],
+			      const struct print_opts *opts)
+{
+	uint8_t *addr = nla_data(attrs[BATADV_ATTR_TT_ADDRESS]);
+
+	if (opts->read_opt & MULTICAST_ONLY && !(addr[0] & 0x01))
+		return false;
+
+	if (opts->read_opt & UNICAST_ONLY && (addr[0] & 0x01))
+		return false;
+
+	return true;
+}
+
+static void transglobal_print(struct nlattr *attrs[], struct print_opts *opts)
 {
-	struct nlattr *attrs[BATADV_ATTR_MAX+1];
-	struct nlmsghdr *nlh = nlmsg_hdr(msg);
-	struct print_opts *opts = arg;
 	struct bat_host *bat_host;
-	struct genlmsghdr *ghdr;
 	char c, r, w, i, t;
 	uint8_t last_ttvn;
 	uint32_t crc32;
@@ -49,28 +93,6 @@ static int transglobal_callback(struct nl_msg *msg, void *arg)
 	uint8_t ttvn;
 	int16_t vid;
 
-	if (!genlmsg_valid_hdr(nlh, 0)) {
-		fputs("Received invalid data from kernel.\n", stderr);
-		exit(1);
-	}
-
-	ghdr = nlmsg_data(nlh);
-
-	if (ghdr->cmd != BATADV_CMD_GET_TRANSTABLE_GLOBAL)
-		return NL_OK;
-
-	if (nla_parse(attrs, BATADV_ATTR_MAX, genlmsg_attrdata(ghdr, 0),
-		      genlmsg_len(ghdr), batadv_netlink_policy)) {
-		fputs("Received invalid data from kernel.\n", stderr);
-		exit(1);
-	}
-
-	if (missing_mandatory_attrs(attrs, transglobal_mandatory,
-				    ARRAY_SIZE(transglobal_mandatory))) {
-		fputs("Missing attributes from kernel\n", stderr);
-		exit(1);
-	}
-
 	addr = nla_data(attrs[BATADV_ATTR_TT_ADDRESS]);
 	orig = nla_data(attrs[BATADV_ATTR_ORIG_ADDRESS]);
 	vid = nla_get_u16(attrs[BATADV_ATTR_TT_VID]);
@@ -79,12 +101,6 @@ static int transglobal_callback(struct nl_msg *msg, void *arg)
 	crc32 = nla_get_u32(attrs[BATADV_ATTR_TT_CRC32]);
 	flags = nla_get_u32(attrs[BATADV_ATTR_TT_FLAGS]);
 
-	if (opts->read_opt & MULTICAST_ONLY && !(addr[0] & 0x01))
-		return NL_OK;
-
-	if (opts->read_opt & UNICAST_ONLY && (addr[0] & 0x01))
-		return NL_OK;
-
 	c = ' ', r = '.', w = '.', i = '.', t = '.';
 	if (attrs[BATADV_ATTR_FLAG_BEST])
 		c = '*';
@@ -97,46 +113,70 @@ static int transglobal_callback(struct nl_msg *msg, void *arg)
 	if (flags & BATADV_TT_CLIENT_TEMP)
 		t = 'T';
 
-	printf(" %c ", c);
+	outbuf_putc(opts->out, ' ');
+	outbuf_putc(opts->out, c);
+	outbuf_putc(opts->out, ' ');
 
 	bat_host = bat_hosts_find_by_mac((char *)addr);
 	if (!(opts->read_opt & USE_BAT_HOSTS) || !bat_host)
-		printf("%02x:%02x:%02x:%02x:%02x:%02x ",
-		       addr[0], addr[1], addr[2],
-		       addr[3], addr[4], addr[5]);
+		outbuf_mac(opts->out, addr);
 	else
-		printf("%17s ", bat_host->name);
-
-	printf("%4i [%c%c%c%c] (%3u) ",
-	       BATADV_PRINT_VID(vid), r, w, i, t, ttvn);
+		outbuf_str(opts->out, bat_host->name, 17);
+	outbuf_putc(opts->out, ' ');
+
+	outbuf_int(opts->out, BATADV_PRINT_VID(vid), 4);
+	outbuf_str(opts->out, " [", 0);
+	outbuf_putc(opts->out, r);
+	outbuf_putc(opts->out, w);
+	outbuf_putc(opts->out, i);
+	outbuf_putc(opts->out, t);
+	outbuf_str(opts->out, "] (", 0);
+	outbuf_uint(opts->out, ttvn, 3);
+	outbuf_str(opts->out, ") ", 0);
 
 	bat_host = bat_hosts_find_by_mac((char *)orig);
 	if (!(opts->read_opt & USE_BAT_HOSTS) || !bat_host)
-		printf("%02x:%02x:%02x:%02x:%02x:%02x ",
-		       orig[0], orig[1], orig[2],
-		       orig[3], orig[4], orig[5]);
+		outbuf_mac(opts->out, orig);
 	else
-		printf("%17s ", bat_host->name);
-
-	printf("(%3u) (0x%.8x)\n",
-	       last_ttvn, crc32);
-
-	return NL_OK;
+		outbuf_str(opts->out, bat_host->name, 17);
+	outbuf_putc(opts->out, ' ');
+
+	outbuf_putc(opts->out, '(');
+	outbuf_uint(opts->out, last_ttvn, 3);
+	outbuf_str(opts->out, ") (0x", 0);
+	outbuf_hex(opts->out, crc32, 8);
+	outbuf_str(opts->out, ")\n", 0);
 }
 
+static const struct table_rows transglobal_rows = {
+	.mandatory = transglobal_mandatory,
+	.num_mandatory = ARRAY_SIZE(transglobal_mandatory),
+	.match = transglobal_match,
+	.print = transglobal_print,
+};
+
 static int netlink_print_transglobal(struct state *state, char *orig_iface,
 				     int read_opts, float orig_timeout,
-				     float watch_interval)
+				     float watch_interval,
+				     const struct table_opts *table)
 {
 	return netlink_print_common(state, orig_iface, read_opts,
 				    orig_timeout, watch_interval,
 				    "   Client             VID Flags Last ttvn     Via        ttvn  (CRC       )\n",
 				    BATADV_CMD_GET_TRANSTABLE_GLOBAL,
-				    transglobal_callback);
+				    &transglobal_rows, table);
 }
 
 static struct debug_table_data batctl_debug_table_transglobal = {
 	.netlink_fn = netlink_print_transglobal,
+	.columns = transglobal_columns,
+	.num_columns = ARRAY_SIZE(transglobal_columns),
+	.sort_keys = transglobal_sort_keys,
+	.num_sort_keys = ARRAY_SIZE(transglobal_sort_keys),
+	.group_keys = transglobal_group_keys,
+	.num_group_keys = ARRAY_SIZE(transglobal_group_keys),
+	.group_flags = transglobal_group_flags,
+	.num_group_flags = ARRAY_SIZE(transglobal_group_flags),
 	.option_unicast_only = 1,
 	.option_multicast_only = 1,
 };
@@ -6,17 +6,156 @@
  * License-Filename: LICENSES/preferred/GPL-2.0
  */
 
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "main.h"
 #include "functions.h"
 #include "bat-hosts.h"
+#include "netlink.h"
 
 
 static void translate_usage(void)
 {
 	fprintf(stderr, "Usage: batctl [options] translate mac|bat-host|host_name|IPv4_address\n");
+	fprintf(stderr, "       batctl [options] translate -\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "When \"-\" is given, destinations are read line by line from stdin\n");
+}
+
+static int translate_read_stdin(struct mac_resolve_req **reqs_out,
+				size_t *num_out)
+{
+	struct mac_resolve_req *reqs = NULL;
+	struct mac_resolve_req *tmp;
+	size_t num = 0, max = 0;
+	char *line = NULL;
+	size_t len = 0;
+	char *token;
+
+	while (getline(&line, &len, stdin) != -1) {
+		token = strtok(line, " \t\r\n");
+		if (!token || token[0] == '#')
+			continue;
+
+		if (num == max) {
+			max = max ? max * 2 : 256;
+			tmp = realloc(reqs, max * sizeof(*reqs));
+			if (!tmp)
+				goto err;
+
+			reqs = tmp;
+		}
+
+		reqs[num].asc = strdup(token);
+		if (!reqs[num].asc)
+			goto err;
+
+		reqs[num].found = false;
+		num++;
+	}
+
+	free(line);
+	*reqs_out = reqs;
+	*num_out = num;
+
+	return 0;
+
+err:
+	free(line);
+	while (num--)
+		free((char *)reqs[num].asc);
+	free(reqs);
+
+	return -ENOMEM;
+}
+
+static int translate_stream(struct state *state)
+{
+	const struct tt_snapshot_entry *entry;
+	struct mac_resolve_req *unresolved;
+	struct tt_snapshot *snapshot;
+	struct mac_resolve_req *reqs;
+	struct bat_host *bat_host;
+	size_t num_unresolved = 0;
+	int ret = EXIT_SUCCESS;
+	size_t num;
+	size_t i;
+
+	if (translate_read_stdin(&reqs, &num) < 0) {
+		fprintf(stderr, "Error - could not read destinations\n");
+		return EXIT_FAILURE;
+	}
+
+	unresolved = calloc(num ? num : 1, sizeof(*unresolved));
+	if (!unresolved) {
+		fprintf(stderr, "Error - could not allocate destinations\n");
+		ret = EXIT_FAILURE;
+		goto free_reqs;
+	}
+
+	bat_hosts_init(0);
+
+	/* bat-host names first, everything else is resolved in one go */
+	for (i = 0; i < num; i++) {
+		bat_host = bat_hosts_find_by_name((char *)reqs[i].asc);
+		if (bat_host) {
+			memcpy(&reqs[i].mac, &bat_host->mac_addr,
+			       sizeof(reqs[i].mac));
+			reqs[i].found = true;
+			continue;
+		}
+
+		unresolved[num_unresolved++] = reqs[i];
+	}
+
+	resolve_macs(unresolved, num_unresolved);
+
+	num_unresolved = 0;
+	for (i = 0; i < num; i++) {
+		if (!reqs[i].found)
+			reqs[i] = unresolved[num_unresolved++];
+	}
+
+	snapshot = tt_snapshot_create(state);
+	if (!snapshot) {
+		fprintf(stderr, "Error - could not query translation table: %s\n",
+			strerror(errno));
+		ret = EXIT_FAILURE;
+		goto free_unresolved;
+	}
+
+	for (i = 0; i < num; i++) {
+		if (!reqs[i].found) {
+			fprintf(stderr, "Error - mac address could not be resolved and is not a bat-host name: %s\n",
+				reqs[i].asc);
+			ret = EXIT_NOSUCCESS;
+			continue;
+		}
+
+		printf("%s -> ", reqs[i].asc);
+
+		entry = tt_snapshot_find(snapshot, &reqs[i].mac,
+					 TT_SNAPSHOT_VID_ANY);
+		if (entry)
+			printf("%s\n", ether_ntoa_long(&entry->orig));
+		else
+			printf("%s\n", ether_ntoa_long(&reqs[i].mac));
+	}
+
+	tt_snapshot_free(snapshot);
+
+free_unresolved:
+	bat_hosts_free();
+	free(unresolved);
+free_reqs:
+	for (i = 0; i < num; i++)
+		free((char *)reqs[i].asc);
+	free(reqs);
+
+	return ret;
 }
 
 static int translate(struct state *state, int argc, char **argv)
@@ -34,6 +173,9 @@ static int translate(struct state *state, int argc, char **argv)
 
 	check_root_or_die("batctl translate");
 
+	if (strcmp(argv[1], "-") == 0)
+		return translate_stream(state);
+
 	dst_string = argv[1];
 	bat_hosts_init(0);
 	bat_host = bat_hosts_find_by_name(dst_string);
@@ -66,4 +208,4 @@ static int translate(struct state *state, int argc, char **argv)
 
 COMMAND(SUBCOMMAND_MIF, translate, "t",
 	COMMAND_FLAG_MESH_IFACE | COMMAND_FLAG_NETLINK, NULL,
-	"<destination>     \ttranslate a destination to the originator responsible for it");
+	"<destination>|-   \ttranslate a destination to the originator responsible for it");
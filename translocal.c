@@ -22,6 +22,9 @@
 #include "functions.h"
 #include "main.h"
 #include "netlink.h"
+#include "output.h"
+#include "tablefmt.h"
+#include "tablegroup.h"
 
 static const int translocal_mandatory[] = {
 	BATADV_ATTR_TT_ADDRESS,
@@ -30,54 +33,57 @@ static const int translocal_mandatory[] = {
 	BATADV_ATTR_TT_FLAGS,
 };
 
-static int translocal_callback(struct nl_msg *msg, void *arg)
+static const struct table_column translocal_columns[] = {
+	{ "tt_address", BATADV_ATTR_TT_ADDRESS, table_column_mac },
+	{ "tt_vid", BATADV_ATTR_TT_VID, table_column_vid },
+	{ "tt_flags", BATADV_ATTR_TT_FLAGS, table_column_u32 },
+	{ "last_seen_msecs", BATADV_ATTR_LAST_SEEN_MSECS, table_column_u32 },
+	{ "tt_crc32", BATADV_ATTR_TT_CRC32, table_column_u32 },
+};
+
+static const struct table_group_key translocal_group_keys[] = {
+	{ "vid", "VID", BATADV_ATTR_TT_VID, TABLE_GROUP_VID },
+};
+
+static const struct table_group_flag translocal_group_flags[] = {
+	{ "roaming", BATADV_ATTR_TT_FLAGS, BATADV_TT_CLIENT_ROAM },
+	{ "nopurge", BATADV_ATTR_TT_FLAGS, BATADV_TT_CLIENT_NOPURGE },
+	{ "new", BATADV_ATTR_TT_FLAGS, BATADV_TT_CLIENT_NEW },
+	{ "pending", BATADV_ATTR_TT_FLAGS, BATADV_TT_CLIENT_PENDING },
+	{ "wifi", BATADV_ATTR_TT_FLAGS, BATADV_TT_CLIENT_WIFI },
+	{ "isolated", BATADV_ATTR_TT_FLAGS, BATADV_TT_CLIENT_ISOLA },
+};
+
+static bool translocal_match(struct nlattr *attrs[],
+			     const struct print_opts *opts)
+{
+	uint8_t *addr = nla_data(attrs[BATADV_ATTR_TT_ADDRESS]);
+
+	if (opts->read_opt & MULTICAST_ONLY && !(addr[0] & 0x01))
+		return false;
+
+	if (opts->read_opt & UNICAST_ONLY && (addr[0] & 0x01))
+		return false;
+
+	return true;
+}
+
+static void translocal_print(struct nlattr *attrs[], struct print_opts *opts)
 {
 	int last_seen_msecs = 0, last_seen_secs = 0;
-	struct nlattr *attrs[BATADV_ATTR_MAX+1];
-	struct nlmsghdr *nlh = nlmsg_hdr(msg);
-	struct print_opts *opts = arg;
 	struct bat_host *bat_host;
-	struct genlmsghdr *ghdr;
 	char r, p, n, x, w, i;
 	uint8_t *addr;
 	int16_t vid;
 	uint32_t crc32;
 	uint32_t flags;
 
-	if (!genlmsg_valid_hdr(nlh, 0)) {
-		fputs("Received invalid data from kernel.\n", stderr);
-		exit(1);
-	}
-
-	ghdr = nlmsg_data(nlh);
-
-	if (ghdr->cmd != BATADV_CMD_GET_TRANSTABLE_LOCAL)
-		return NL_OK;
-
-	if (nla_parse(attrs, BATADV_ATTR_MAX, genlmsg_attrdata(ghdr, 0),
-		      genlmsg_len(ghdr), batadv_netlink_policy)) {
-		fputs("Received invalid data from kernel.\n", stderr);
-		exit(1);
-	}
-
-	if (missing_mandatory_attrs(attrs, translocal_mandatory,
-				    ARRAY_SIZE(translocal_mandatory))) {
-		fputs("Missing attributes from kernel\n", stderr);
-		exit(1);
-	}
-
 	addr = nla_data(attrs[BATADV_ATTR_TT_ADDRESS]);
 	vid = nla_get_u16(attrs[BATADV_ATTR_TT_VID]);
 	crc32 = nla_get_u32(attrs[BATADV_ATTR_TT_CRC32]);
 	flags = nla_get_u32(attrs[BATADV_ATTR_TT_FLAGS]);
 	last_seen_msecs = 0, last_seen_secs = 0;
 
-	if (opts->read_opt & MULTICAST_ONLY && !(addr[0] & 0x01))
-		return NL_OK;
-
-	if (opts->read_opt & UNICAST_ONLY && (addr[0] & 0x01))
-		return NL_OK;
-
 	r = '.', p = '.', n = '.', x = '.', w = '.', i = '.';
 	if (flags & BATADV_TT_CLIENT_ROAM)
 		r = 'R';
@@ -101,33 +107,55 @@ static int translocal_callback(struct nl_msg *msg, void *arg)
 
 	bat_host = bat_hosts_find_by_mac((char *)addr);
 	if (!(opts->read_opt & USE_BAT_HOSTS) || !bat_host)
-		printf("%02x:%02x:%02x:%02x:%02x:%02x ",
-		       addr[0], addr[1], addr[2],
-		       addr[3], addr[4], addr[5]);
+		outbuf_mac(opts->out, addr);
 	else
-		printf("%17s ", bat_host->name);
-
-	printf("%4i [%c%c%c%c%c%c] %3u.%03u   (0x%.8x)\n",
-	       BATADV_PRINT_VID(vid), r, p, n, x, w, i,
-	       last_seen_secs, last_seen_msecs,
-	       crc32);
-
-	return NL_OK;
+		outbuf_str(opts->out, bat_host->name, 17);
+	outbuf_putc(opts->out, ' ');
+
+	outbuf_int(opts->out, BATADV_PRINT_VID(vid), 4);
+	outbuf_str(opts->out, " [", 0);
+	outbuf_putc(opts->out, r);
+	outbuf_putc(opts->out, p);
+	outbuf_putc(opts->out, n);
+	outbuf_putc(opts->out, x);
+	outbuf_putc(opts->out, w);
+	outbuf_putc(opts->out, i);
+	outbuf_str(opts->out, "] ", 0);
+	outbuf_uint(opts->out, last_seen_secs, 3);
+	outbuf_putc(opts->out, '.');
+	outbuf_uint_zero(opts->out, last_seen_msecs, 3);
+	outbuf_str(opts->out, "   (0x", 0);
+	outbuf_hex(opts->out, crc32, 8);
+	outbuf_str(opts->out, ")\n", 0);
 }
 
+static const struct table_rows translocal_rows = {
+	.mandatory = translocal_mandatory,
+	.num_mandatory = ARRAY_SIZE(translocal_mandatory),
+	.match = translocal_match,
+	.print = translocal_print,
+};
+
 static int netlink_print_translocal(struct state *state, char *orig_iface,
 				    int read_opts, float orig_timeout,
-				    float watch_interval)
+				    float watch_interval,
+				    const struct table_opts *table)
 {
 	return netlink_print_common(state, orig_iface, read_opts,
 				    orig_timeout, watch_interval,
 				    "Client             VID Flags    Last seen (CRC       )\n",
 				    BATADV_CMD_GET_TRANSTABLE_LOCAL,
-				    translocal_callback);
+				    &translocal_rows, table);
 }
 
 static struct debug_table_data batctl_debug_table_translocal = {
 	.netlink_fn = netlink_print_translocal,
+	.columns = translocal_columns,
+	.num_columns = ARRAY_SIZE(translocal_columns),
+	.group_keys = translocal_group_keys,
+	.num_group_keys = ARRAY_SIZE(translocal_group_keys),
+	.group_flags = translocal_group_flags,
+	.num_group_flags = ARRAY_SIZE(translocal_group_flags),
 	.option_unicast_only = 1,
 	.option_multicast_only = 1,
 };